@@ -123,17 +123,19 @@ bool repowerd::AndroidAutobrightnessAlgorithm::init(EventLoop& event_loop)
     return true;
 }
 
-void repowerd::AndroidAutobrightnessAlgorithm::new_light_value(double light)
+void repowerd::AndroidAutobrightnessAlgorithm::new_light_values(
+    LightSamples const& samples)
 {
-    if (!started)
+    if (!started || samples.empty())
         return;
 
     auto const is_first_light_value = !have_previous_light_values();
 
-    log->log(log_tag, "process_new_light_value(%.2f), is_first_light_value=%d",
-             light, is_first_light_value);
+    REPOWERD_LOG_DEBUG(*log, log_tag, "process_new_light_values(%.2f, num_samples=%zu), is_first_light_value=%d",
+                       samples.back().light, samples.size(), is_first_light_value);
 
-    update_averages(light);
+    for (auto const& sample : samples)
+        update_averages(sample.light, sample.time);
 
     if (is_first_light_value)
     {
@@ -189,10 +191,9 @@ bool repowerd::AndroidAutobrightnessAlgorithm::have_previous_light_values()
     return last_light_tp != std::chrono::steady_clock::time_point{};
 }
 
-void repowerd::AndroidAutobrightnessAlgorithm::update_averages(double light)
+void repowerd::AndroidAutobrightnessAlgorithm::update_averages(
+    double light, std::chrono::steady_clock::time_point time)
 {
-    auto const now = std::chrono::steady_clock::now();
-
     if (!have_previous_light_values())
     {
         fast_average = light;
@@ -200,7 +201,10 @@ void repowerd::AndroidAutobrightnessAlgorithm::update_averages(double light)
     }
     else
     {
-        auto const dt = now - last_light_tp;
+        // Samples are timestamped at the source, so don't let a late one
+        // move the averages backwards in time
+        auto const dt = std::max(time - last_light_tp,
+                                 std::chrono::steady_clock::duration::zero());
         double const dt_ms =
             std::chrono::duration_cast<std::chrono::milliseconds>(dt).count();
 
@@ -211,7 +215,7 @@ void repowerd::AndroidAutobrightnessAlgorithm::update_averages(double light)
         slow_average = exponential_smoothing(slow_average, light, slow_factor);
     }
 
-    last_light_tp = now;
+    last_light_tp = std::max(last_light_tp, time);
     last_light = light;
 }
 
@@ -223,7 +227,7 @@ void repowerd::AndroidAutobrightnessAlgorithm::schedule_debounce()
     debouncing = true;
     ++debouncing_seqnum;
 
-    log->log(log_tag, "schedule_debounce(), seqnum=%d", debouncing_seqnum);
+    REPOWERD_LOG_DEBUG(*log, log_tag, "schedule_debounce(), seqnum=%d", debouncing_seqnum);
 
     event_loop->schedule_in(
         debounce_delay,
@@ -231,30 +235,30 @@ void repowerd::AndroidAutobrightnessAlgorithm::schedule_debounce()
         {
             if (debouncing_seqnum != expected_debouncing_seqnum)
             {
-                log->log(log_tag, "debounce() ignored, expected_seqnum=%d, actual_seqnum=%d",
-                         expected_debouncing_seqnum, debouncing_seqnum);
+                REPOWERD_LOG_DEBUG(*log, log_tag, "debounce() ignored, expected_seqnum=%d, actual_seqnum=%d",
+                                   expected_debouncing_seqnum, debouncing_seqnum);
                 return;
             }
 
             auto constexpr min_hysteresis = 2.0;
 
             debouncing = false;
-            update_averages(last_light);
+            update_averages(last_light, std::chrono::steady_clock::now());
 
             auto const hysteresis = std::max(applied_light * hysteresis_factor, min_hysteresis);
             auto const slow_delta = slow_average - applied_light;
             auto const fast_delta = fast_average - applied_light;
-            log->log(log_tag,
-                     "debounce(), seqnum=%d, applied_light=%.2f, hysteresis=%.2f, "
-                     "slow_average=%.2f, fast_average=%.2f, slow_delta=%.2f, "
-                     "fast_delta=%.2f",
-                     expected_debouncing_seqnum, applied_light, hysteresis, slow_average,
-                     fast_average, slow_delta, fast_delta);
+            REPOWERD_LOG_DEBUG(*log, log_tag,
+                               "debounce(), seqnum=%d, applied_light=%.2f, hysteresis=%.2f, "
+                               "slow_average=%.2f, fast_average=%.2f, slow_delta=%.2f, "
+                               "fast_delta=%.2f",
+                               expected_debouncing_seqnum, applied_light, hysteresis, slow_average,
+                               fast_average, slow_delta, fast_delta);
 
             if ((slow_delta >= hysteresis && fast_delta >= hysteresis) ||
                 (-slow_delta >= hysteresis && -fast_delta >= hysteresis))
             {
-                log->log(log_tag, "debounce(), apply light %.2f", fast_average);
+                REPOWERD_LOG_DEBUG(*log, log_tag, "debounce(), apply light %.2f", fast_average);
                 notify_brightness(brightness_spline->interpolate(fast_average));
                 applied_light = fast_average;
             }
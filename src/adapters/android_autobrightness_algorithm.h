@@ -40,7 +40,7 @@ public:
 
     bool init(EventLoop& event_loop) override;
 
-    void new_light_value(double light) override;
+    void new_light_values(LightSamples const& samples) override;
     void start() override;
     void stop() override;
 
@@ -50,7 +50,7 @@ public:
 private:
     void reset();
     bool have_previous_light_values();
-    void update_averages(double light);
+    void update_averages(double light, std::chrono::steady_clock::time_point time);
     void schedule_debounce();
     void notify_brightness(double brightness);
 
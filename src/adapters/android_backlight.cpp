@@ -24,6 +24,14 @@
 #include <cstring>
 #include <cmath>
 
+namespace
+{
+// The lights HAL has no way to query the panel resolution. It takes the
+// brightness as the 8-bit channels of an RGB color and scales it to the
+// panel itself, so 255 levels is all we can address.
+int const hal_brightness_levels{255};
+}
+
 repowerd::AndroidBacklight::AndroidBacklight()
     : brightness{Backlight::unknown_brightness}
 {
@@ -46,7 +54,7 @@ repowerd::AndroidBacklight::~AndroidBacklight()
 
 void repowerd::AndroidBacklight::set_brightness(double value)
 {
-    int const value_abs = round(value * 255);
+    int const value_abs = round(value * hal_brightness_levels);
 
     light_state_t state;
     memset(&state, 0, sizeof(light_state_t));
@@ -63,3 +71,8 @@ double repowerd::AndroidBacklight::get_brightness()
 {
     return brightness;
 }
+
+int repowerd::AndroidBacklight::num_brightness_levels()
+{
+    return hal_brightness_levels;
+}
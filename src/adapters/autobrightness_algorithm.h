@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include "light_sensor.h"
 #include "src/core/handler_registration.h"
 
 #include <functional>
@@ -36,7 +37,7 @@ public:
     
     virtual bool init(EventLoop& event_loop) = 0;
 
-    virtual void new_light_value(double light) = 0;
+    virtual void new_light_values(LightSamples const& samples) = 0;
     virtual void start() = 0;
     virtual void stop() = 0;
 
@@ -28,6 +28,8 @@ public:
 
     virtual void set_brightness(double) = 0;
     virtual double get_brightness() = 0;
+    // Number of distinct non-zero brightness values the hardware supports
+    virtual int num_brightness_levels() = 0;
 
     static double constexpr unknown_brightness = -1.0;
 
@@ -27,6 +27,7 @@
 
 #include "src/core/log.h"
 
+#include <algorithm>
 #include <cmath>
 #include <chrono>
 #include <string>
@@ -62,7 +63,8 @@ repowerd::BacklightBrightnessControl::BacklightBrightnessControl(
     std::shared_ptr<Chrono> const& chrono,
     std::shared_ptr<Log> const& log,
     DeviceConfig const& device_config,
-    DeviceQuirks const& quirks)
+    DeviceQuirks const& quirks,
+    BrightnessCurve const& curve)
     : backlight{backlight},
       light_sensor{light_sensor},
       autobrightness_algorithm{autobrightness_algorithm},
@@ -71,6 +73,17 @@ repowerd::BacklightBrightnessControl::BacklightBrightnessControl(
       normal_before_display_on_autobrightness{
           quirks.normal_before_display_on_autobrightness()},
       ab_supported{autobrightness_algorithm->init(event_loop)},
+      curve{curve},
+      transition_active{false},
+      transition_id{0},
+      transition_start{0.0},
+      transition_current{0.0},
+      transition_target{0.0},
+      transition_from{0.0},
+      transition_step{0},
+      transition_num_steps{0},
+      transition_step_time{0},
+      turn_off_pending{false},
       event_loop{"Backlight"},
       brightness_handler{null_handler},
       dim_brightness{dim_brightness_percent(device_config)},
@@ -86,7 +99,7 @@ repowerd::BacklightBrightnessControl::BacklightBrightnessControl(
             {
                 if (ab_active)
                 {
-                    this->log->log(log_tag, "new_autobrightness_value(%.2f)", brightness);
+                    REPOWERD_LOG_DEBUG(*this->log, log_tag, "new_autobrightness_value(%.2f)", brightness);
 
                     normal_brightness = brightness;
 
@@ -98,17 +111,27 @@ repowerd::BacklightBrightnessControl::BacklightBrightnessControl(
             });
 
         light_handler_registration = light_sensor->register_light_handler(
-            [this] (double light)
+            [this] (LightSamples const& samples)
             {
-                event_loop.enqueue(
-                    [this, light]
+                event_loop.post(
+                    [this, samples]
                     {
-                        this->autobrightness_algorithm->new_light_value(light);
+                        this->autobrightness_algorithm->new_light_values(samples);
                     });
             });
     }
 }
 
+repowerd::BacklightBrightnessControl::~BacklightBrightnessControl()
+{
+    event_loop.enqueue(
+        [this]
+        {
+            transition_active = false;
+            ++transition_id;
+        }).wait();
+}
+
 void repowerd::BacklightBrightnessControl::disable_autobrightness()
 {
     if (!ab_supported) return;
@@ -154,8 +177,11 @@ void repowerd::BacklightBrightnessControl::set_dim_brightness()
         { 
             bool should_transition = true;
 
+            // A fade out in progress is reversed, even if it has already
+            // gone below the dim brightness
             auto const backlight_brightness = get_brightness_value();
-            if (backlight_brightness > 0.0 &&
+            if (!turn_off_pending &&
+                backlight_brightness > 0.0 &&
                 backlight_brightness < dim_brightness)
             {
                 should_transition = false;
@@ -164,6 +190,7 @@ void repowerd::BacklightBrightnessControl::set_dim_brightness()
             if (should_transition)
                 transition_to_brightness_value(dim_brightness, TransitionSpeed::normal);
 
+            turn_off_pending = false;
             active_brightness_type = ActiveBrightnessType::dim;
         }).get();
 }
@@ -173,7 +200,10 @@ void repowerd::BacklightBrightnessControl::set_normal_brightness()
     event_loop.enqueue(
         [this]
         { 
-            if (ab_active && active_brightness_type == ActiveBrightnessType::off)
+            // Autobrightness is only stopped once a fade out completes, so
+            // if one is in progress just reverse it
+            if (ab_active && active_brightness_type == ActiveBrightnessType::off &&
+                !turn_off_pending)
             {
                 if (normal_before_display_on_autobrightness)
                     transition_to_brightness_value(normal_brightness, TransitionSpeed::normal);
@@ -185,6 +215,7 @@ void repowerd::BacklightBrightnessControl::set_normal_brightness()
                 transition_to_brightness_value(normal_brightness, TransitionSpeed::normal);
             }
 
+            turn_off_pending = false;
             active_brightness_type = ActiveBrightnessType::normal;
         }).get();
 }
@@ -209,10 +240,15 @@ void repowerd::BacklightBrightnessControl::set_off_brightness()
     event_loop.enqueue(
         [this]
         { 
-            transition_to_brightness_value(0, TransitionSpeed::normal);
+            // Don't make the caller wait for the fade out, finish turning
+            // off when it completes instead
             active_brightness_type = ActiveBrightnessType::off;
-            autobrightness_algorithm->stop();
-            light_sensor->disable_light_events();
+            transition_to_brightness_value(0, TransitionSpeed::normal);
+
+            if (transition_active)
+                turn_off_pending = true;
+            else
+                complete_turn_off();
         }).get();
 }
 
@@ -234,54 +270,156 @@ repowerd::BacklightBrightnessControl::register_brightness_handler(
 void repowerd::BacklightBrightnessControl::transition_to_brightness_value(
     double brightness, TransitionSpeed transition_speed)
 {
-    auto const step = 0.01;
+    // Retarget a transition already in flight, continuing from the current
+    // brightness instead of restarting
+    if (transition_active)
+    {
+        if (brightness != transition_target)
+        {
+            REPOWERD_LOG_DEBUG(*log, log_tag, "Retargeting brightness transition %.2f => %.2f",
+                               transition_current, brightness);
+            set_transition_target(brightness, transition_speed);
+        }
+        return;
+    }
+
+    auto const step = 1.0 / backlight->num_brightness_levels();
     auto const backlight_brightness = get_brightness_value();
     auto const starting_brightness =
         backlight_brightness == Backlight::unknown_brightness ?
         brightness - step : backlight_brightness;
-    auto const num_steps = std::ceil(std::fabs(starting_brightness - brightness) / step);
-    auto const step_time = (transition_speed == TransitionSpeed::slow ||
-                            starting_brightness == 0.0
-                            || brightness == 0.0) ?
-                            100000us / num_steps : 1000us;
 
-    if (starting_brightness != brightness)
+    if (starting_brightness == brightness)
+        return;
+
+    transition_active = true;
+    ++transition_id;
+    transition_start = starting_brightness;
+    transition_current = starting_brightness;
+    set_transition_target(brightness, transition_speed);
+
+    REPOWERD_LOG_DEBUG(*log, log_tag, "Transitioning brightness %.2f => %.2f in %d steps %.2fus each",
+                       transition_start, transition_target, transition_num_steps,
+                       std::chrono::duration<double, std::micro>{transition_step_time}.count());
+
+    // The first step is applied immediately, the rest from timers, so that
+    // callers never wait for the whole transition
+    transition_last_step = chrono->steady_now() - transition_step_time;
+    run_due_transition_steps();
+}
+
+void repowerd::BacklightBrightnessControl::set_transition_target(
+    double brightness, TransitionSpeed transition_speed)
+{
+    auto const duration =
+        transition_duration(transition_current, brightness, transition_speed);
+
+    transition_from = transition_current;
+    transition_target = brightness;
+    transition_step = 0;
+    transition_num_steps = curve.num_steps(
+        transition_from, transition_target,
+        backlight->num_brightness_levels(), duration);
+    transition_step_time = duration / transition_num_steps;
+}
+
+std::chrono::nanoseconds repowerd::BacklightBrightnessControl::transition_duration(
+    double from, double to, TransitionSpeed transition_speed)
+{
+    // Transitions from or to off, and slow transitions, take 100ms. Normal
+    // transitions take 1ms per hundredth of the brightness range.
+    std::chrono::nanoseconds const full_duration{100ms};
+
+    if (transition_speed == TransitionSpeed::slow || from == 0.0 || to == 0.0)
+        return full_duration;
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        full_duration * std::fabs(to - from));
+}
+
+void repowerd::BacklightBrightnessControl::schedule_transition_step()
+{
+    auto const id = transition_id;
+    auto const timeout = std::max(
+        std::chrono::milliseconds{1},
+        std::chrono::duration_cast<std::chrono::milliseconds>(transition_step_time));
+
+    event_loop.schedule_in(
+        timeout,
+        [this, id]
+        {
+            if (transition_active && id == transition_id)
+                run_due_transition_steps();
+        });
+}
+
+void repowerd::BacklightBrightnessControl::run_due_transition_steps()
+{
+    apply_due_transition_step();
+
+    if (transition_current == transition_target)
+        finish_transition();
+    else
+        schedule_transition_step();
+}
+
+void repowerd::BacklightBrightnessControl::apply_due_transition_step()
+{
+    auto const elapsed = chrono->steady_now() - transition_last_step;
+
+    // Jump to the step for the current time, so that the transition
+    // duration doesn't depend on timer latency, without writing out the
+    // steps that are already overdue
+    if (transition_step_time.count() <= 0)
     {
-        log->log(log_tag, "Transitioning brightness %.2f => %.2f in %.2f steps %.2fus each",
-                 starting_brightness, brightness, num_steps, step_time.count());
+        transition_step = transition_num_steps;
     }
+    else
+    {
+        auto const due_steps = elapsed / transition_step_time;
+        if (due_steps <= 0)
+            return;
 
-    auto current_brightness = starting_brightness;
+        transition_step = std::min<long long>(
+            transition_num_steps, transition_step + due_steps);
+        transition_last_step += due_steps * transition_step_time;
+    }
 
-    if (current_brightness < brightness)
+    if (transition_step >= transition_num_steps)
     {
-        while (current_brightness < brightness)
-        {
-            current_brightness += step;
-            if (current_brightness > brightness) current_brightness = brightness;
-            set_brightness_value(current_brightness);
-            chrono->sleep_for(std::chrono::duration_cast<std::chrono::nanoseconds>(step_time));
-        }
+        transition_current = transition_target;
     }
-    else if (current_brightness > brightness)
+    else
     {
-        while (current_brightness > brightness)
-        {
-            current_brightness -= step;
-            if (current_brightness < brightness) current_brightness = brightness;
-            set_brightness_value(current_brightness);
-            chrono->sleep_for(std::chrono::duration_cast<std::chrono::nanoseconds>(step_time));
-        }
+        transition_current = curve.value_at(
+            transition_from, transition_target,
+            static_cast<double>(transition_step) / transition_num_steps);
     }
 
-    if (starting_brightness != brightness)
+    set_brightness_value(transition_current);
+}
+
+void repowerd::BacklightBrightnessControl::finish_transition()
+{
+    transition_active = false;
+
+    REPOWERD_LOG_DEBUG(*log, log_tag, "Transitioning brightness %.2f => %.2f done",
+                       transition_start, transition_current);
+
+    if (turn_off_pending)
     {
-        log->log(log_tag, "Transitioning brightness %.2f => %.2f done",
-                 starting_brightness, current_brightness);
+        turn_off_pending = false;
+        complete_turn_off();
     }
 
-    if (starting_brightness != brightness)
-        brightness_handler(brightness);
+    if (transition_start != transition_current)
+        brightness_handler(transition_current);
+}
+
+void repowerd::BacklightBrightnessControl::complete_turn_off()
+{
+    autobrightness_algorithm->stop();
+    light_sensor->disable_light_events();
 }
 
 void repowerd::BacklightBrightnessControl::set_brightness_value(double brightness)
@@ -19,9 +19,11 @@
 #pragma once
 
 #include "src/core/brightness_control.h"
+#include "brightness_curve.h"
 #include "brightness_notification.h"
 #include "event_loop.h"
 
+#include <chrono>
 #include <memory>
 
 namespace repowerd
@@ -45,7 +47,9 @@ public:
         std::shared_ptr<Chrono> const& chrono,
         std::shared_ptr<Log> const& log,
         DeviceConfig const& device_config,
-        DeviceQuirks const& device_quirks);
+        DeviceQuirks const& device_quirks,
+        BrightnessCurve const& curve);
+    ~BacklightBrightnessControl();
 
     void disable_autobrightness() override;
     void enable_autobrightness() override;
@@ -62,6 +66,14 @@ private:
     enum class ActiveBrightnessType {normal, dim, off};
     enum class TransitionSpeed {normal, slow};
     void transition_to_brightness_value(double brightness, TransitionSpeed transition_speed);
+    void set_transition_target(double brightness, TransitionSpeed transition_speed);
+    void schedule_transition_step();
+    std::chrono::nanoseconds transition_duration(
+        double from, double to, TransitionSpeed transition_speed);
+    void run_due_transition_steps();
+    void apply_due_transition_step();
+    void finish_transition();
+    void complete_turn_off();
     void set_brightness_value(double brightness);
     double get_brightness_value();
 
@@ -72,6 +84,23 @@ private:
     std::shared_ptr<Log> const log;
     bool const normal_before_display_on_autobrightness;
     bool const ab_supported;
+    BrightnessCurve const curve;
+
+    // Brightness transitions are driven by event_loop timers and only
+    // accessed from within event_loop. The state is declared before
+    // event_loop, so that it outlives any pending transition step.
+    bool transition_active;
+    unsigned int transition_id;
+    double transition_start;
+    double transition_current;
+    double transition_target;
+    double transition_from;
+    int transition_step;
+    int transition_num_steps;
+    std::chrono::nanoseconds transition_step_time;
+    std::chrono::steady_clock::time_point transition_last_step;
+    // Set while fading out for set_off_brightness()
+    bool turn_off_pending;
 
     EventLoop event_loop;
     HandlerRegistration light_handler_registration;
@@ -0,0 +1,176 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "battery_discharge_estimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+std::size_t constexpr repowerd::BatteryDischargeEstimator::capacity;
+std::chrono::seconds constexpr repowerd::BatteryDischargeEstimator::min_estimate_span;
+std::size_t constexpr repowerd::BatteryDischargeEstimator::load_samples;
+
+namespace
+{
+
+double to_seconds(std::chrono::steady_clock::duration d)
+{
+    return std::chrono::duration<double>{d}.count();
+}
+
+}
+
+repowerd::BatteryDischargeEstimator::BatteryDischargeEstimator()
+    : samples{},
+      next{0},
+      count{0}
+{
+}
+
+void repowerd::BatteryDischargeEstimator::add_sample(
+    TimePoint time, double percentage, double energy_rate)
+{
+    // A rising level means the battery has been charging in between, so
+    // older samples don't describe the current discharge
+    if (count > 0 && percentage > sample(count - 1).percentage)
+        reset();
+
+    samples[next] = Sample{time, percentage, energy_rate};
+    next = (next + 1) % capacity;
+    if (count < capacity)
+        ++count;
+}
+
+void repowerd::BatteryDischargeEstimator::reset()
+{
+    next = 0;
+    count = 0;
+}
+
+repowerd::BatteryEstimate repowerd::BatteryDischargeEstimator::estimate() const
+{
+    BatteryEstimate const unknown{0.0, std::chrono::seconds{0}};
+
+    if (count < 2)
+        return unknown;
+
+    auto const& oldest = sample(0);
+    auto const& newest = sample(count - 1);
+
+    if (newest.time - oldest.time < min_estimate_span)
+        return unknown;
+
+    double sum_t{0.0};
+    double sum_p{0.0};
+    double sum_tt{0.0};
+    double sum_tp{0.0};
+    double sum_energy_rate{0.0};
+    std::size_t num_energy_rates{0};
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto const& s = sample(i);
+        auto const t = to_seconds(s.time - oldest.time);
+
+        sum_t += t;
+        sum_p += s.percentage;
+        sum_tt += t * t;
+        sum_tp += t * s.percentage;
+
+        if (s.energy_rate > 0.0)
+        {
+            sum_energy_rate += s.energy_rate;
+            ++num_energy_rates;
+        }
+    }
+
+    double const n = count;
+    auto const denominator = n * sum_tt - sum_t * sum_t;
+    if (denominator <= 0.0)
+        return unknown;
+
+    // Percent per second
+    auto rate = -(n * sum_tp - sum_t * sum_p) / denominator;
+
+    auto const load = current_load();
+    if (load > 0.0 && num_energy_rates > 0)
+        rate *= load / (sum_energy_rate / num_energy_rates);
+
+    if (rate <= 0.0)
+        return unknown;
+
+    return BatteryEstimate{
+        rate * 3600.0,
+        std::chrono::seconds{std::lround(newest.percentage / rate)}};
+}
+
+std::chrono::milliseconds repowerd::BatteryDischargeEstimator::mean_sample_interval() const
+{
+    if (count < 2)
+        return std::chrono::milliseconds{0};
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        (sample(count - 1).time - sample(0).time) / (count - 1));
+}
+
+double repowerd::BatteryDischargeEstimator::current_load() const
+{
+    std::array<double, load_samples> rates;
+    std::size_t num_rates{0};
+
+    for (std::size_t i = count; i > 0 && num_rates < load_samples; --i)
+    {
+        auto const energy_rate = sample(i - 1).energy_rate;
+        if (energy_rate > 0.0)
+            rates[num_rates++] = energy_rate;
+    }
+
+    if (num_rates == 0)
+        return 0.0;
+
+    // The lower median, so that with only two rates a single spike is ignored
+    auto const median = rates.begin() + (num_rates - 1) / 2;
+    std::nth_element(rates.begin(), median, rates.begin() + num_rates);
+    return *median;
+}
+
+repowerd::BatteryDischargeEstimator::Sample const&
+repowerd::BatteryDischargeEstimator::sample(std::size_t i) const
+{
+    // i is relative to the oldest sample
+    return samples[(next + capacity - count + i) % capacity];
+}
+
+void repowerd::BatteryEstimates::update(
+    std::string const& battery, BatteryEstimate const& estimate)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    estimates[battery] = estimate;
+}
+
+void repowerd::BatteryEstimates::remove(std::string const& battery)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    estimates.erase(battery);
+}
+
+std::vector<std::pair<std::string,repowerd::BatteryEstimate>>
+repowerd::BatteryEstimates::all() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return {estimates.begin(), estimates.end()};
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace repowerd
+{
+
+struct BatteryEstimate
+{
+    // In percent per hour, zero if unknown or not discharging
+    double discharge_rate;
+    // Zero if unknown or not discharging
+    std::chrono::seconds time_to_empty;
+};
+
+// Keeps the latest (time, percentage, energy rate) samples of a discharging
+// battery in a fixed-size ring buffer, and estimates the discharge rate from
+// the least-squares slope of the percentage. The slope is scaled by the
+// current load relative to the mean energy rate over the buffer, so that
+// sustained load changes show up before the percentage catches up. The
+// current load is the median of the latest energy rates, so that a single
+// spiked reading doesn't make the battery look about to run out.
+class BatteryDischargeEstimator
+{
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+    static std::size_t constexpr capacity{16};
+    // Estimates over shorter spans are dominated by the percentage granularity
+    static std::chrono::seconds constexpr min_estimate_span{30};
+    // Number of latest energy rates the current load is the median of
+    static std::size_t constexpr load_samples{3};
+
+    BatteryDischargeEstimator();
+
+    void add_sample(TimePoint time, double percentage, double energy_rate);
+    void reset();
+
+    BatteryEstimate estimate() const;
+    std::chrono::milliseconds mean_sample_interval() const;
+
+private:
+    struct Sample
+    {
+        TimePoint time;
+        double percentage;
+        double energy_rate;
+    };
+
+    Sample const& sample(std::size_t i) const;
+    double current_load() const;
+
+    std::array<Sample, capacity> samples;
+    std::size_t next;
+    std::size_t count;
+};
+
+// Latest estimates per battery, written by the power source and read by
+// clients such as the D-Bus service. Thread-safe.
+class BatteryEstimates
+{
+public:
+    void update(std::string const& battery, BatteryEstimate const& estimate);
+    void remove(std::string const& battery);
+    std::vector<std::pair<std::string,BatteryEstimate>> all() const;
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<std::string,BatteryEstimate> estimates;
+};
+
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "brightness_curve.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+
+// Curve segments sampled to find its steepest part
+int const slope_samples{64};
+
+// CIE 1976 lightness for relative luminance y, both in the 0.0-1.0 range
+double lightness_for(double y)
+{
+    if (y <= 216.0 / 24389.0)
+        return y * (24389.0 / 27.0) / 100.0;
+    return (116.0 * std::cbrt(y) - 16.0) / 100.0;
+}
+
+double luminance_for(double l)
+{
+    auto const l100 = l * 100.0;
+    if (l100 <= 8.0)
+        return l100 * (27.0 / 24389.0);
+    auto const f = (l100 + 16.0) / 116.0;
+    return f * f * f;
+}
+
+}
+
+repowerd::BrightnessCurve::BrightnessCurve(
+    Easing easing, bool perceptual, int max_steps_per_second)
+    : easing{easing},
+      perceptual{perceptual},
+      max_steps_per_second{max_steps_per_second}
+{
+}
+
+repowerd::BrightnessCurve::Easing
+repowerd::BrightnessCurve::easing_from_string(std::string const& str)
+{
+    if (str == "linear")
+        return Easing::linear;
+    else if (str == "ease-in")
+        return Easing::ease_in;
+    else if (str == "ease-out")
+        return Easing::ease_out;
+    else if (str == "ease-in-out")
+        return Easing::ease_in_out;
+
+    throw std::invalid_argument{"Unknown brightness easing: " + str};
+}
+
+double repowerd::BrightnessCurve::value_at(
+    double from, double to, double progress) const
+{
+    auto const eased = ease(std::min(std::max(progress, 0.0), 1.0));
+
+    if (!perceptual)
+        return from + (to - from) * eased;
+
+    auto const l_from = lightness_for(from);
+    auto const l_to = lightness_for(to);
+
+    return luminance_for(l_from + (l_to - l_from) * eased);
+}
+
+int repowerd::BrightnessCurve::num_steps(
+    double from, double to, int num_levels,
+    std::chrono::nanoseconds duration) const
+{
+    auto max_steps = std::numeric_limits<int>::max();
+
+    if (max_steps_per_second > 0)
+    {
+        auto const frames = static_cast<int>(
+            std::chrono::duration<double>{duration}.count() * max_steps_per_second);
+        max_steps = std::max(1, frames);
+    }
+
+    // Equal progress steps change the output by different amounts along an
+    // eased or perceptual curve, so the steepest part decides how many are
+    // needed to not skip any level. The small epsilon keeps exact multiples
+    // of a level from rounding up.
+    auto max_change = 0.0;
+    auto prev = value_at(from, to, 0.0);
+    for (int i = 1; i <= slope_samples; ++i)
+    {
+        auto const value = value_at(from, to, static_cast<double>(i) / slope_samples);
+        max_change = std::max(max_change, std::fabs(value - prev));
+        prev = value;
+    }
+
+    auto const level_steps = static_cast<int>(
+        std::ceil(max_change * slope_samples * num_levels - 1e-9));
+
+    auto steps = std::min(std::max(1, level_steps), max_steps);
+
+    // Sampling slightly underestimates the steepest part
+    while (steps < max_steps && skips_level(from, to, num_levels, steps))
+        ++steps;
+
+    return steps;
+}
+
+bool repowerd::BrightnessCurve::skips_level(
+    double from, double to, int num_levels, int steps) const
+{
+    auto prev = std::round(from * num_levels);
+
+    for (int i = 1; i <= steps; ++i)
+    {
+        auto const level = std::round(
+            value_at(from, to, static_cast<double>(i) / steps) * num_levels);
+        if (std::fabs(level - prev) > 1.0)
+            return true;
+        prev = level;
+    }
+
+    return false;
+}
+
+double repowerd::BrightnessCurve::ease(double p) const
+{
+    switch (easing)
+    {
+    case Easing::ease_in:
+        return p * p;
+    case Easing::ease_out:
+        return 1.0 - (1.0 - p) * (1.0 - p);
+    case Easing::ease_in_out:
+        return p * p * (3.0 - 2.0 * p);
+    case Easing::linear:
+    default:
+        return p;
+    }
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace repowerd
+{
+
+// Shapes brightness transitions. Interpolation can happen in perceptual
+// (CIE L*) space, so that fades look uniform instead of rushing through the
+// dark range, and the number of steps is limited both by the backlight
+// resolution and by the maximum number of steps per second.
+class BrightnessCurve
+{
+public:
+    enum class Easing {linear, ease_in, ease_out, ease_in_out};
+
+    BrightnessCurve(Easing easing, bool perceptual, int max_steps_per_second);
+
+    // Accepts "linear", "ease-in", "ease-out" and "ease-in-out"
+    static Easing easing_from_string(std::string const& str);
+
+    // Brightness at progress (0.0-1.0) of a transition from -> to
+    double value_at(double from, double to, double progress) const;
+
+    // The minimum number of equal progress steps along the curve that
+    // visits every brightness level of a backlight with num_levels levels
+    // between from and to, capped so that steps are not more frequent than
+    // max_steps_per_second (0 = no cap)
+    int num_steps(double from, double to, int num_levels,
+                  std::chrono::nanoseconds duration) const;
+
+private:
+    double ease(double progress) const;
+    bool skips_level(double from, double to, int num_levels, int steps) const;
+
+    Easing const easing;
+    bool const perceptual;
+    int const max_steps_per_second;
+};
+
+}
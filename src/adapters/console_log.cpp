@@ -23,7 +23,8 @@
 #include <ctime>
 #include <string>
 
-void repowerd::ConsoleLog::log(char const* tag, char const* format, ...)
+void repowerd::ConsoleLog::vlog(
+    LogLevel level, char const* tag, char const* format, va_list ap)
 {
     struct timespec ts;
     clock_gettime(CLOCK_REALTIME, &ts);
@@ -36,17 +37,17 @@ void repowerd::ConsoleLog::log(char const* tag, char const* format, ...)
     format_str += "[";
     format_str += now;
     format_str += "] ";
+    if (level != LogLevel::info)
+    {
+        format_str += log_level_to_string(level);
+        format_str += " ";
+    }
     format_str += tag;
     format_str += ": ";
     format_str += format;
     format_str += "\n";
 
-    va_list ap;
-    va_start(ap, format);
-
     vprintf(format_str.c_str(), ap);
 
-    va_end(ap);
-
     fflush(stdout);
 }
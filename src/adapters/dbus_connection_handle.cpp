@@ -19,13 +19,29 @@
 #include "dbus_connection_handle.h"
 #include "scoped_g_error.h"
 
+#include <atomic>
+#include <mutex>
 #include <stdexcept>
+#include <unordered_map>
 
-repowerd::DBusConnectionHandle::DBusConnectionHandle(std::string const& address)
+namespace
+{
+
+struct SharedConnection
+{
+    GDBusConnection* connection;
+    int handles;
+};
+
+std::atomic<bool> shared_connections_enabled{false};
+std::mutex shared_connections_mutex;
+std::unordered_map<std::string, SharedConnection> shared_connections;
+
+GDBusConnection* connect_to_bus(std::string const& address)
 {
     repowerd::ScopedGError error;
 
-    connection = g_dbus_connection_new_for_address_sync(
+    auto const connection = g_dbus_connection_new_for_address_sync(
         address.c_str(),
         GDBusConnectionFlags(
             G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION |
@@ -40,13 +56,56 @@ repowerd::DBusConnectionHandle::DBusConnectionHandle(std::string const& address)
             "Failed to connect to DBus bus with address '" +
                 address + "': " + error.message_str());
     }
+
+    return connection;
+}
+
+}
+
+repowerd::DBusConnectionHandle::DBusConnectionHandle(std::string const& address)
+    : address{address},
+      shared{shared_connections_enabled}
+{
+    if (!shared)
+    {
+        connection = connect_to_bus(address);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock{shared_connections_mutex};
+
+    auto iter = shared_connections.find(address);
+    if (iter == shared_connections.end())
+    {
+        iter = shared_connections.emplace(
+            address, SharedConnection{connect_to_bus(address), 0}).first;
+    }
+
+    ++iter->second.handles;
+    connection = iter->second.connection;
 }
 
 repowerd::DBusConnectionHandle::~DBusConnectionHandle()
 {
+    if (shared)
+    {
+        std::lock_guard<std::mutex> lock{shared_connections_mutex};
+
+        auto const iter = shared_connections.find(address);
+        if (--iter->second.handles > 0)
+            return;
+
+        shared_connections.erase(iter);
+    }
+
     g_dbus_connection_close_sync(connection, nullptr, nullptr);
 }
 
+void repowerd::DBusConnectionHandle::enable_shared_connections(bool enable)
+{
+    shared_connections_enabled = enable;
+}
+
 void repowerd::DBusConnectionHandle::request_name(char const* name) const
 {
     static constexpr uint32_t DBUS_NAME_FLAG_DO_NOT_QUEUE = 0x4;
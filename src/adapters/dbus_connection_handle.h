@@ -31,6 +31,12 @@ public:
     DBusConnectionHandle(std::string const& address);
     ~DBusConnectionHandle();
 
+    // When enabled, handles created afterwards for the same bus address
+    // share a single underlying connection, so that the bus handshake and
+    // match rules are set up only once per process. Incoming messages are
+    // routed to each handle's subscriptions and objects by GDBus itself.
+    static void enable_shared_connections(bool enable);
+
     void request_name(char const* name) const;
 
     operator GDBusConnection*() const;
@@ -39,6 +45,8 @@ private:
     DBusConnectionHandle(DBusConnectionHandle const&) = delete;
     DBusConnectionHandle& operator=(DBusConnectionHandle const&) = delete;
 
+    std::string const address;
+    bool const shared;
     GDBusConnection* connection;
 };
 
@@ -156,7 +156,8 @@ repowerd::HandlerRegistration repowerd::DBusEventLoop::register_signal_handler(
     };
 
     unsigned int registration_id = 0;
-    auto done = enqueue(
+    EventLoopHandlerRegistration::run_in(
+        *this,
         [&]
         {
             registration_id = g_dbus_connection_signal_subscribe(
@@ -172,8 +173,6 @@ repowerd::HandlerRegistration repowerd::DBusEventLoop::register_signal_handler(
                 reinterpret_cast<GDestroyNotify>(&SignalContext::static_destroy));
         });
 
-    done.wait();
-
     // g_dbus_connection_signal_subscribe() is not synchronous, so wait for
     // the subscription (really a DBus AddMatch request) to be processed
     // by the server
@@ -0,0 +1,120 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "dbus_sender_credentials.h"
+#include "scoped_g_error.h"
+
+#include "src/core/log.h"
+
+namespace
+{
+char const* const log_tag = "DBusSenderCredentials";
+
+// Senders are normally evicted when they disconnect; this only bounds the
+// cache if nobody reports NameOwnerChanged
+size_t const max_cached_senders = 1024;
+}
+
+repowerd::DBusSenderCredentials::DBusSenderCredentials(
+    std::shared_ptr<Log> const& log)
+    : log{log}
+{
+}
+
+pid_t repowerd::DBusSenderCredentials::pid_for(
+    GDBusConnection* connection, std::string const& sender)
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto const iter = pids.find(sender);
+        if (iter != pids.end())
+            return iter->second;
+    }
+
+    auto const pid = dbus_get_connection_pid(connection, sender);
+
+    // Only unique names are stable, and failures are not cached
+    if (pid >= 0 && !sender.empty() && sender[0] == ':')
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        if (pids.size() >= max_cached_senders)
+            pids.clear();
+
+        pids[sender] = pid;
+    }
+
+    return pid;
+}
+
+void repowerd::DBusSenderCredentials::name_owner_changed(
+    std::string const& name,
+    std::string const& old_owner,
+    std::string const& new_owner)
+{
+    if (new_owner.empty() && old_owner == name)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        pids.erase(name);
+    }
+}
+
+pid_t repowerd::DBusSenderCredentials::dbus_get_connection_pid(
+    GDBusConnection* connection, std::string const& sender)
+{
+    int constexpr timeout = 1000;
+    auto constexpr null_cancellable = nullptr;
+    ScopedGError error;
+
+    auto const result = g_dbus_connection_call_sync(
+        connection,
+        "org.freedesktop.DBus",
+        "/org/freedesktop/DBus",
+        "org.freedesktop.DBus",
+        "GetConnectionCredentials",
+        g_variant_new("(s)", sender.c_str()),
+        G_VARIANT_TYPE("(a{sv})"),
+        G_DBUS_CALL_FLAGS_NONE,
+        timeout,
+        null_cancellable,
+        error);
+
+    if (!result)
+    {
+        REPOWERD_LOG_WARNING(*log, log_tag, "failed to get credentials of '%s': %s",
+                             sender.c_str(), error.message_str().c_str());
+        return -1;
+    }
+
+    GVariant* credentials{nullptr};
+    g_variant_get(result, "(@a{sv})", &credentials);
+
+    guint pid{0};
+    auto const has_pid = g_variant_lookup(credentials, "ProcessID", "u", &pid);
+
+    g_variant_unref(credentials);
+    g_variant_unref(result);
+
+    if (!has_pid)
+    {
+        log->log(log_tag, "no ProcessID in credentials of '%s'", sender.c_str());
+        return -1;
+    }
+
+    return pid;
+}
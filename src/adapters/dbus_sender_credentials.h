@@ -0,0 +1,59 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <sys/types.h>
+
+namespace repowerd
+{
+class Log;
+
+// Caches the process id of D-Bus method call senders by unique name. Unique
+// names are never reused on a bus, so an entry stays valid until its sender
+// disconnects, which is reported through name_owner_changed(). Meant to be
+// shared by all services on the same bus. Thread-safe.
+class DBusSenderCredentials
+{
+public:
+    DBusSenderCredentials(std::shared_ptr<Log> const& log);
+
+    pid_t pid_for(GDBusConnection* connection, std::string const& sender);
+
+    void name_owner_changed(
+        std::string const& name,
+        std::string const& old_owner,
+        std::string const& new_owner);
+
+private:
+    pid_t dbus_get_connection_pid(
+        GDBusConnection* connection, std::string const& sender);
+
+    std::shared_ptr<Log> const log;
+
+    std::mutex mutex;
+    std::unordered_map<std::string,pid_t> pids;
+};
+
+}
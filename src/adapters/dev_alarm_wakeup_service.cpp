@@ -60,12 +60,14 @@ timespec to_timespec(std::chrono::system_clock::time_point const& tp)
 }
 
 repowerd::DevAlarmWakeupService::DevAlarmWakeupService(
-    std::shared_ptr<Filesystem> const& filesystem)
+    std::shared_ptr<Filesystem> const& filesystem,
+    std::chrono::milliseconds default_slack)
     : filesystem{filesystem},
+      default_slack{default_slack},
       dev_alarm_fd{filesystem->open("/dev/alarm", O_RDWR)},
       running{true},
-      cookie_pool{1},
-      wakeup_handler{null_handler}
+      wakeup_handler{null_handler},
+      armed_time{std::chrono::system_clock::time_point::max()}
 {
     if (dev_alarm_fd == -1)
         throw std::system_error{errno, std::system_category(), "Failed to open /dev/alarm"};
@@ -86,12 +88,12 @@ repowerd::DevAlarmWakeupService::DevAlarmWakeupService(
                 lock.lock();
                 if (running && !wakeups.empty())
                 {
-                    auto const wakeup = *wakeups.begin();
-                    cookie_pool.remove(std::stoull(wakeup.second));
-                    wakeups.erase(wakeups.begin());
+                    // The whole batch the alarm was armed for is due
+                    auto const due = wakeups.take_due(armed_time);
                     auto const handler = wakeup_handler;
                     lock.unlock();
-                    handler(wakeup.second);
+                    for (auto const id : due)
+                        handler(WakeupRegistry::to_cookie(id));
                     lock.lock();
                 }
                 reset_hardware_alarm();
@@ -111,31 +113,27 @@ repowerd::DevAlarmWakeupService::~DevAlarmWakeupService()
 
 std::string repowerd::DevAlarmWakeupService::schedule_wakeup_at(
     std::chrono::system_clock::time_point tp)
+{
+    return schedule_wakeup_at(tp, default_slack);
+}
+
+std::string repowerd::DevAlarmWakeupService::schedule_wakeup_at(
+    std::chrono::system_clock::time_point tp, std::chrono::milliseconds slack)
 {
     std::lock_guard<std::mutex> lock{wakeup_mutex};
 
-    auto const cookie = std::to_string(cookie_pool.generate());
-    wakeups.insert({tp, cookie});
+    auto const id = wakeups.add(tp, slack);
 
     reset_hardware_alarm();
-    return cookie;
+    return WakeupRegistry::to_cookie(id);
 }
 
 void repowerd::DevAlarmWakeupService::cancel_wakeup(std::string const& cookie)
 {
     std::lock_guard<std::mutex> lock{wakeup_mutex};
 
-    for (auto iter = wakeups.begin(); iter != wakeups.end(); ++iter)
-    {
-        if (iter->second == cookie)
-        {
-            cookie_pool.remove(std::stoull(cookie));
-            wakeups.erase(iter);
-            break;
-        }
-    }
-
-    reset_hardware_alarm();
+    if (wakeups.remove(WakeupRegistry::from_cookie(cookie)))
+        reset_hardware_alarm();
 }
 
 repowerd::HandlerRegistration repowerd::DevAlarmWakeupService::register_wakeup_handler(
@@ -154,7 +152,7 @@ repowerd::HandlerRegistration repowerd::DevAlarmWakeupService::register_wakeup_h
 unsigned int repowerd::DevAlarmWakeupService::num_stored_elements()
 {
     std::lock_guard<std::mutex> lock{wakeup_mutex};
-    return cookie_pool.size() + wakeups.size();
+    return wakeups.num_stored_elements();
 }
 
 void repowerd::DevAlarmWakeupService::reset_hardware_alarm()
@@ -163,6 +161,8 @@ void repowerd::DevAlarmWakeupService::reset_hardware_alarm()
 
     timespec next_wakeup;
 
+    armed_time = wakeups.next_batch_time();
+
     if (running)
     {
         if (wakeups.empty())
@@ -171,7 +171,7 @@ void repowerd::DevAlarmWakeupService::reset_hardware_alarm()
         }
         else
         {
-            next_wakeup = to_timespec(wakeups.begin()->first);
+            next_wakeup = to_timespec(armed_time);
         }
     }
     else
@@ -20,9 +20,8 @@
 
 #include "wakeup_service.h"
 #include "fd.h"
-#include "unique_random_pool.h"
+#include "wakeup_registry.h"
 
-#include <map>
 #include <thread>
 #include <mutex>
 
@@ -33,10 +32,14 @@ class Filesystem;
 class DevAlarmWakeupService : public WakeupService
 {
 public:
-    DevAlarmWakeupService(std::shared_ptr<Filesystem> const& filesystem);
+    DevAlarmWakeupService(
+        std::shared_ptr<Filesystem> const& filesystem,
+        std::chrono::milliseconds default_slack);
     ~DevAlarmWakeupService();
 
     std::string schedule_wakeup_at(std::chrono::system_clock::time_point tp) override;
+    std::string schedule_wakeup_at(
+        std::chrono::system_clock::time_point tp, std::chrono::milliseconds slack) override;
     void cancel_wakeup(std::string const& cookie) override;
 
     HandlerRegistration register_wakeup_handler(
@@ -49,14 +52,15 @@ private:
     void reset_hardware_alarm();
 
     std::shared_ptr<Filesystem> const filesystem;
+    std::chrono::milliseconds const default_slack;
     Fd const dev_alarm_fd;
     std::thread wakeup_thread;
 
     std::mutex wakeup_mutex;
     bool running;
-    UniqueRandomPool<uint64_t> cookie_pool;
     WakeupHandler wakeup_handler;
-    std::multimap<std::chrono::system_clock::time_point,std::string> wakeups;
+    WakeupRegistry wakeups;
+    std::chrono::system_clock::time_point armed_time;
 };
 
 }
@@ -21,6 +21,9 @@
 #include <glib-unix.h>
 #include <pthread.h>
 
+#include <algorithm>
+#include <atomic>
+
 namespace
 {
 
@@ -81,22 +84,128 @@ struct GSourceFdContext
     std::function<void()> const callback;
 };
 
+std::atomic<bool> shared_reactor_enabled{false};
+std::mutex shared_reactor_mutex;
+std::weak_ptr<repowerd::SharedReactor> shared_reactor_instance;
+size_t const min_prune_sources_at{64};
+// Bursts beyond this spill into the queue's overflow list
+size_t const posted_actions_capacity{64};
+
+void run_in_context_and_wait(GMainContext* context, std::function<void()> const& func)
+{
+    auto const gsource = g_idle_source_new();
+    auto const ctx = new GSourceContext{func};
+    g_source_set_callback(
+            gsource,
+            reinterpret_cast<GSourceFunc>(&GSourceContext::static_call),
+            ctx,
+            reinterpret_cast<GDestroyNotify>(&GSourceContext::static_destroy));
+
+    auto done = ctx->done.get_future();
+
+    g_source_attach(gsource, context);
+    g_source_unref(gsource);
+
+    done.wait();
 }
 
-repowerd::EventLoop::EventLoop(std::string const& name)
-    : main_context{g_main_context_new()},
-      main_loop{g_main_loop_new(main_context, FALSE)}
+}
+
+class repowerd::SharedReactor
 {
-    loop_thread = std::thread{
-        [this]
+public:
+    SharedReactor()
+        : main_context{g_main_context_new()},
+          main_loop{g_main_loop_new(main_context, FALSE)}
+    {
+        loop_thread = std::thread{
+            [this]
+            {
+                g_main_context_push_thread_default(main_context);
+                g_main_loop_run(main_loop);
+            }};
+
+        set_thread_name(loop_thread, "Reactor");
+    }
+
+    ~SharedReactor()
+    {
+        if (loop_thread.get_id() == std::this_thread::get_id())
+        {
+            g_main_loop_quit(main_loop);
+            loop_thread.detach();
+        }
+        else
+        {
+            // Quit from within the loop, so that we don't race with
+            // g_main_loop_run() starting up
+            run_in_context_and_wait(
+                main_context, [this] { g_main_loop_quit(main_loop); });
+            loop_thread.join();
+        }
+
+        g_main_loop_unref(main_loop);
+        g_main_context_unref(main_context);
+    }
+
+    static std::shared_ptr<SharedReactor> instance()
+    {
+        std::lock_guard<std::mutex> lock{shared_reactor_mutex};
+
+        auto reactor = shared_reactor_instance.lock();
+        if (!reactor)
         {
-            g_main_context_push_thread_default(main_context);
-            g_main_loop_run(main_loop);
-        }};
+            reactor = std::make_shared<SharedReactor>();
+            shared_reactor_instance = reactor;
+        }
+
+        return reactor;
+    }
+
+    std::thread::id thread_id() const { return loop_thread.get_id(); }
+
+    GMainContext* const main_context;
+
+private:
+    GMainLoop* const main_loop;
+    std::thread loop_thread;
+};
+
+void repowerd::EventLoop::enable_shared_reactor(bool enable)
+{
+    shared_reactor_enabled = enable;
+}
+
+repowerd::EventLoop::EventLoop(std::string const& name)
+    : shared_reactor{shared_reactor_enabled ? SharedReactor::instance() : nullptr},
+      main_context{shared_reactor ?
+                   g_main_context_ref(shared_reactor->main_context) :
+                   g_main_context_new()},
+      main_loop{shared_reactor ? nullptr : g_main_loop_new(main_context, FALSE)},
+      prune_sources_at{min_prune_sources_at}
+{
+    if (shared_reactor)
+    {
+        // No round trip through the reactor, which would deadlock when
+        // constructing from within the reactor thread itself
+        loop_thread_id = shared_reactor->thread_id();
+    }
+    else
+    {
+        loop_thread = std::thread{
+            [this]
+            {
+                g_main_context_push_thread_default(main_context);
+                g_main_loop_run(main_loop);
+            }};
 
-    set_thread_name(loop_thread, name);
+        set_thread_name(loop_thread, name);
+        loop_thread_id = loop_thread.get_id();
 
-    enqueue([]{}).wait();
+        // Wait for the loop to start, so that stop() can't race with
+        // g_main_loop_run() starting up
+        run_in_context_and_wait(main_context, [] {});
+    }
 }
 
 repowerd::EventLoop::~EventLoop()
@@ -106,6 +215,21 @@ repowerd::EventLoop::~EventLoop()
 
 void repowerd::EventLoop::stop()
 {
+    if (shared_reactor)
+    {
+        if (main_context)
+        {
+            if (in_shared_reactor_thread())
+                destroy_attached_sources();
+            else
+                run_in_context_and_wait(main_context, [this] { destroy_attached_sources(); });
+
+            g_main_context_unref(main_context);
+            main_context = nullptr;
+        }
+        return;
+    }
+
     if (main_loop)
         g_main_loop_quit(main_loop);
     if (loop_thread.joinable())
@@ -124,6 +248,21 @@ void repowerd::EventLoop::stop()
 
 std::future<void> repowerd::EventLoop::enqueue(std::function<void()> const& callback)
 {
+    if (in_shared_reactor_thread())
+    {
+        std::promise<void> done;
+        try
+        {
+            callback();
+            done.set_value();
+        }
+        catch (...)
+        {
+            done.set_exception(std::current_exception());
+        }
+        return done.get_future();
+    }
+
     auto const gsource = g_idle_source_new();
     auto const ctx = new GSourceContext{callback};
     g_source_set_callback(
@@ -134,7 +273,7 @@ std::future<void> repowerd::EventLoop::enqueue(std::function<void()> const& call
 
     auto future = ctx->done.get_future();
 
-    g_source_attach(gsource, main_context);
+    attach(gsource);
     g_source_unref(gsource);
 
     return future;
@@ -154,7 +293,7 @@ std::future<void> repowerd::EventLoop::schedule_in(
 
     auto future = ctx->done.get_future();
 
-    g_source_attach(gsource, main_context);
+    attach(gsource);
     g_source_unref(gsource);
 
     return future;
@@ -186,7 +325,7 @@ void repowerd::EventLoop::schedule_with_cancellation_in(
             cancellation_ready(cancellation);
         });
 
-    g_source_attach(gsource, main_context);
+    attach(gsource);
 }
 
 void repowerd::EventLoop::watch_fd(
@@ -200,6 +339,92 @@ void repowerd::EventLoop::watch_fd(
             ctx,
             reinterpret_cast<GDestroyNotify>(&GSourceFdContext::static_destroy));
 
-    g_source_attach(gsource, main_context);
+    attach(gsource);
     g_source_unref(gsource);
 }
+
+void repowerd::EventLoop::post(Action&& action)
+{
+    std::call_once(
+        posted_actions_created,
+        [this]
+        {
+            posted_actions = std::make_unique<ActionQueue>(posted_actions_capacity);
+            watch_fd(posted_actions->wakeup_fd(), [this] { run_posted_actions(); });
+        });
+
+    posted_actions->push(std::move(action));
+}
+
+void repowerd::EventLoop::run_posted_actions()
+{
+    posted_actions->clear_wakeup();
+
+    Action action;
+    while (posted_actions->try_pop(action))
+    {
+        try
+        {
+            action();
+        }
+        catch (...)
+        {
+        }
+        action.reset();
+    }
+}
+
+void repowerd::EventLoop::attach(GSource* gsource)
+{
+    if (!shared_reactor)
+    {
+        g_source_attach(gsource, main_context);
+        return;
+    }
+
+    // Keep track of our sources in the shared context, so that we can
+    // destroy them when stopping. Sources that have already been
+    // destroyed are pruned whenever the list doubles in size.
+    std::lock_guard<std::mutex> lock{sources_mutex};
+
+    if (sources.size() >= prune_sources_at)
+    {
+        auto const end = std::remove_if(
+            sources.begin(), sources.end(),
+            [] (GSource* s)
+            {
+                if (!g_source_is_destroyed(s))
+                    return false;
+                g_source_unref(s);
+                return true;
+            });
+        sources.erase(end, sources.end());
+        prune_sources_at = std::max(min_prune_sources_at, 2 * sources.size());
+    }
+
+    sources.push_back(g_source_ref(gsource));
+    g_source_attach(gsource, main_context);
+}
+
+bool repowerd::EventLoop::in_loop_thread() const
+{
+    return std::this_thread::get_id() == loop_thread_id;
+}
+
+bool repowerd::EventLoop::in_shared_reactor_thread()
+{
+    return shared_reactor && in_loop_thread();
+}
+
+void repowerd::EventLoop::destroy_attached_sources()
+{
+    std::lock_guard<std::mutex> lock{sources_mutex};
+
+    for (auto const s : sources)
+    {
+        g_source_destroy(s);
+        g_source_unref(s);
+    }
+
+    sources.clear();
+}
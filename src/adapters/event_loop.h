@@ -18,10 +18,15 @@
 
 #pragma once
 
+#include "src/core/action_queue.h"
+
 #include <thread>
 #include <functional>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <glib.h>
 
@@ -29,6 +34,7 @@ namespace repowerd
 {
 
 using EventLoopCancellation = std::function<void()>;
+class SharedReactor;
 
 class EventLoop
 {
@@ -36,9 +42,27 @@ public:
     EventLoop(std::string const& name);
     ~EventLoop();
 
+    // When enabled, EventLoops created afterwards don't own a thread and
+    // GMainContext, but attach their sources to a single process-wide
+    // reactor thread instead. Stopping such an EventLoop destroys only the
+    // sources it has attached. Enqueuing from within the reactor thread
+    // runs the callback immediately, so that adapters can still make
+    // blocking calls into each other.
+    static void enable_shared_reactor(bool enable);
+
     void stop();
 
     std::future<void> enqueue(std::function<void()> const& callback);
+
+    // Fire-and-forget alternative to enqueue(), for high-rate callers that
+    // don't need to wait for completion. Posted actions are stored inline in
+    // a lock-free ring and drained by a single persistent source, so no
+    // per-call GSource, promise or (for small callables) heap allocation is
+    // needed. The ring and its source are only created on the first post.
+    // Posted actions run in order with respect to each other, but not with
+    // respect to enqueue()d callbacks. Exceptions are ignored. Posting from
+    // the loop thread itself never blocks, even when the ring is full.
+    void post(Action&& action);
     std::future<void> schedule_in(
         std::chrono::milliseconds, std::function<void()> const& callback);
 
@@ -49,10 +73,28 @@ public:
 
     void watch_fd(int fd, std::function<void()> const& callback);
 
+    // Whether the caller is running on the thread that dispatches this
+    // loop's sources
+    bool in_loop_thread() const;
+
 protected:
+    std::shared_ptr<SharedReactor> shared_reactor;
     std::thread loop_thread;
     GMainContext* main_context;
     GMainLoop* main_loop;
+
+private:
+    void attach(GSource* gsource);
+    bool in_shared_reactor_thread();
+    void destroy_attached_sources();
+    void run_posted_actions();
+
+    std::thread::id loop_thread_id;
+    std::mutex sources_mutex;
+    std::vector<GSource*> sources;
+    size_t prune_sources_at;
+    std::once_flag posted_actions_created;
+    std::unique_ptr<ActionQueue> posted_actions;
 };
 
 }
@@ -31,17 +31,27 @@ public:
         repowerd::EventLoop& loop,
         std::function<void()> const& register_func,
         std::function<void()> const& unregister)
-        : HandlerRegistration{[&, unregister] { loop.enqueue(unregister).wait(); }}
+        : HandlerRegistration{[&, unregister] { run_in(loop, unregister); }}
     {
-        loop.enqueue(register_func).wait();
+        run_in(loop, register_func);
     }
 
     EventLoopHandlerRegistration(
         repowerd::EventLoop& loop,
         std::function<void()> const& unregister)
-        : HandlerRegistration{[&, unregister] { loop.enqueue(unregister).wait(); }}
+        : HandlerRegistration{[&, unregister] { run_in(loop, unregister); }}
     {
     }
+
+    // Runs func in the loop, or directly if already there, so that handlers
+    // can be (un)registered from within the loop's own callbacks
+    static void run_in(repowerd::EventLoop& loop, std::function<void()> const& func)
+    {
+        if (loop.in_loop_thread())
+            func();
+        else
+            loop.enqueue(func).wait();
+    }
 };
 
 }
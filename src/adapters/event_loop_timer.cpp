@@ -58,18 +58,7 @@ repowerd::AlarmId repowerd::EventLoopTimer::schedule_alarm_in(
         alarm_id = next_alarm_id++;
     }
 
-    event_loop.schedule_with_cancellation_in(
-        t,
-        [this, alarm_id]
-        {
-            alarm_handler(alarm_id);
-            cancel_alarm_unqueued(alarm_id);
-        },
-        [this, alarm_id] (EventLoopCancellation const& cancellation)
-        {
-            std::lock_guard<std::mutex> lock{alarms_mutex};
-            alarms[alarm_id] = cancellation;
-        });
+    schedule_alarm_with_id_in(alarm_id, t);
 
     return alarm_id;
 }
@@ -79,12 +68,42 @@ void repowerd::EventLoopTimer::cancel_alarm(AlarmId id)
     event_loop.enqueue([this,id] { cancel_alarm_unqueued(id); }).get();
 }
 
+bool repowerd::EventLoopTimer::extend_alarm_in(
+    AlarmId id, std::chrono::milliseconds t)
+{
+    bool cancelled = false;
+
+    event_loop.enqueue([this,id,&cancelled] { cancelled = cancel_alarm_unqueued(id); }).get();
+
+    if (cancelled)
+        schedule_alarm_with_id_in(id, t);
+
+    return cancelled;
+}
+
 std::chrono::steady_clock::time_point repowerd::EventLoopTimer::now()
 {
     return std::chrono::steady_clock::now();
 }
 
-void repowerd::EventLoopTimer::cancel_alarm_unqueued(AlarmId id)
+void repowerd::EventLoopTimer::schedule_alarm_with_id_in(
+    AlarmId alarm_id, std::chrono::milliseconds t)
+{
+    event_loop.schedule_with_cancellation_in(
+        t,
+        [this, alarm_id]
+        {
+            alarm_handler(alarm_id);
+            cancel_alarm_unqueued(alarm_id);
+        },
+        [this, alarm_id] (EventLoopCancellation const& cancellation)
+        {
+            std::lock_guard<std::mutex> lock{alarms_mutex};
+            alarms[alarm_id] = cancellation;
+        });
+}
+
+bool repowerd::EventLoopTimer::cancel_alarm_unqueued(AlarmId id)
 {
     std::lock_guard<std::mutex> lock{alarms_mutex};
 
@@ -93,5 +112,8 @@ void repowerd::EventLoopTimer::cancel_alarm_unqueued(AlarmId id)
     {
         iter->second();
         alarms.erase(iter);
+        return true;
     }
+
+    return false;
 }
@@ -36,10 +36,12 @@ public:
     HandlerRegistration register_alarm_handler(AlarmHandler const& handler) override;
     AlarmId schedule_alarm_in(std::chrono::milliseconds t) override;
     void cancel_alarm(AlarmId id) override;
+    bool extend_alarm_in(AlarmId id, std::chrono::milliseconds t) override;
     std::chrono::steady_clock::time_point now() override;
 
 private:
-    void cancel_alarm_unqueued(AlarmId id);
+    void schedule_alarm_with_id_in(AlarmId id, std::chrono::milliseconds t);
+    bool cancel_alarm_unqueued(AlarmId id);
 
     EventLoop event_loop;
     AlarmHandler alarm_handler;
@@ -0,0 +1,83 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "light_sample_batcher.h"
+
+#include <algorithm>
+
+repowerd::LightSampleBatcher::LightSampleBatcher(
+    int batch_size,
+    std::chrono::milliseconds min_sample_interval,
+    std::chrono::milliseconds max_batch_delay)
+    : batch_size{std::max(batch_size, 1)},
+      min_sample_interval{min_sample_interval},
+      max_batch_delay{max_batch_delay},
+      delivered{false}
+{
+}
+
+repowerd::LightSamples repowerd::LightSampleBatcher::add(LightSample const& sample)
+{
+    if (!pending.empty() &&
+        sample.time - last_sample_start < min_sample_interval)
+    {
+        pending.back() = sample;
+    }
+    else
+    {
+        if (pending.empty())
+            batch_start = sample.time;
+        pending.push_back(sample);
+        last_sample_start = sample.time;
+    }
+
+    if (!delivered || pending.size() >= static_cast<size_t>(batch_size))
+        return take();
+
+    return {};
+}
+
+repowerd::LightSamples repowerd::LightSampleBatcher::take_due(TimePoint now)
+{
+    if (now >= due_time())
+        return take();
+
+    return {};
+}
+
+repowerd::LightSampleBatcher::TimePoint repowerd::LightSampleBatcher::due_time() const
+{
+    if (pending.empty())
+        return TimePoint::max();
+
+    return batch_start + max_batch_delay;
+}
+
+void repowerd::LightSampleBatcher::reset()
+{
+    pending.clear();
+    delivered = false;
+}
+
+repowerd::LightSamples repowerd::LightSampleBatcher::take()
+{
+    LightSamples batch;
+    batch.swap(pending);
+    delivered = true;
+    return batch;
+}
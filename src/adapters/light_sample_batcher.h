@@ -0,0 +1,67 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+#include "light_sensor.h"
+
+#include <chrono>
+
+namespace repowerd
+{
+
+// Groups light samples into batches, independently of the sensor and of any
+// event loop: times come from the samples and from the caller. Samples
+// closer than min_sample_interval to the start of the previous kept sample
+// replace it. A batch is complete at batch_size samples, or once its first
+// sample is max_batch_delay old. The first sample after construction or
+// reset() is delivered on its own, since consumers react to it immediately.
+class LightSampleBatcher
+{
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    LightSampleBatcher(
+        int batch_size,
+        std::chrono::milliseconds min_sample_interval,
+        std::chrono::milliseconds max_batch_delay);
+
+    // Returns the batch to deliver now, empty if the sample was held back
+    LightSamples add(LightSample const& sample);
+    // Returns the held back batch if it is due by now, empty otherwise
+    LightSamples take_due(TimePoint now);
+    // When the held back batch becomes due, TimePoint::max() if there is none
+    TimePoint due_time() const;
+
+    void reset();
+
+private:
+    LightSamples take();
+
+    int const batch_size;
+    std::chrono::milliseconds const min_sample_interval;
+    std::chrono::milliseconds const max_batch_delay;
+
+    LightSamples pending;
+    // Replacing samples doesn't postpone the batch
+    TimePoint batch_start;
+    TimePoint last_sample_start;
+    bool delivered;
+};
+
+}
@@ -20,12 +20,22 @@
 
 #include "src/core/handler_registration.h"
 
+#include <chrono>
 #include <functional>
+#include <vector>
 
 namespace repowerd
 {
 
-using LightHandler = std::function<void(double)>;
+struct LightSample
+{
+    std::chrono::steady_clock::time_point time;
+    double light;
+};
+
+// Samples are delivered in batches, oldest first
+using LightSamples = std::vector<LightSample>;
+using LightHandler = std::function<void(LightSamples const&)>;
 
 class LightSensor
 {
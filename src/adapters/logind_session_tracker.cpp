@@ -24,6 +24,7 @@
 #include "src/core/log.h"
 
 #include <algorithm>
+#include <chrono>
 
 namespace
 {
@@ -38,6 +39,9 @@ char const* const dbus_manager_interface = "org.freedesktop.login1.Manager";
 char const* const dbus_seat_path = "/org/freedesktop/login1/seat/seat0";
 char const* const dbus_seat_interface = "org.freedesktop.login1.Seat";
 char const* const dbus_session_interface = "org.freedesktop.login1.Session";
+size_t const pid_session_cache_capacity = 64;
+// Only needed without pidfd support, to drop entries of exited processes
+auto const pid_exit_poll_interval = std::chrono::seconds{5};
 
 repowerd::SessionType logind_session_type_to_repowerd_type(
     std::string const& logind_session_type)
@@ -83,6 +87,8 @@ repowerd::LogindSessionTracker::LogindSessionTracker(
     : filesystem{filesystem},
       log{log},
       ignore_session_deactivation{quirks.ignore_session_deactivation()},
+      pid_session_cache{filesystem, pid_session_cache_capacity},
+      pid_exit_poll_scheduled{false},
       dbus_connection{dbus_bus_address},
       dbus_event_loop{"Logind"},
       active_session_changed_handler{null_arg2_handler},
@@ -131,6 +137,10 @@ void repowerd::LogindSessionTracker::start_processing()
                 signal_name, parameters);
         });
 
+    dbus_event_loop.watch_fd(
+        pid_session_cache.exit_notification_fd(),
+        [this] { pid_session_cache.process_exit_notifications(); });
+
     dbus_event_loop.enqueue([this] { set_initial_active_session(); }).get();
 }
 
@@ -158,12 +168,22 @@ std::string repowerd::LogindSessionTracker::session_for_pid(pid_t pid)
 {
     std::string ret_session_id{invalid_session_id};
 
+    if (pid_session_cache.lookup(pid, ret_session_id))
+        return ret_session_id;
+
+    auto identity = pid_session_cache.identify(pid);
+    auto const polled = identity.pidfd < 0;
+    // Failed lookups may be transient, and the active session fallback
+    // changes with the active session, so only cache sessions logind knows
+    auto resolved = false;
+
     dbus_event_loop.enqueue(
         [&]
         {
             auto const session_path = dbus_get_session_path_by_pid(pid);
             ret_session_id = session_id_for_path(session_path);
-            if (ret_session_id == invalid_session_id)
+            resolved = ret_session_id != invalid_session_id;
+            if (!resolved)
             {
                 auto const& active_session_path = tracked_sessions[active_session_id].path;
                 auto const active_session_uid = dbus_get_session_uid(active_session_path);
@@ -177,9 +197,31 @@ std::string repowerd::LogindSessionTracker::session_for_pid(pid_t pid)
             }
         }).get();
 
+    if (resolved)
+    {
+        pid_session_cache.insert(pid, std::move(identity), ret_session_id);
+        if (polled)
+            schedule_pid_exit_poll();
+    }
+
     return ret_session_id;
 }
 
+void repowerd::LogindSessionTracker::schedule_pid_exit_poll()
+{
+    if (pid_exit_poll_scheduled.exchange(true))
+        return;
+
+    dbus_event_loop.schedule_in(
+        pid_exit_poll_interval,
+        [this]
+        {
+            pid_exit_poll_scheduled = false;
+            if (pid_session_cache.poll_exits())
+                schedule_pid_exit_poll();
+        });
+}
+
 void repowerd::LogindSessionTracker::handle_dbus_signal(
     GDBusConnection* /*connection*/,
     gchar const* /*sender*/,
@@ -262,6 +304,9 @@ void repowerd::LogindSessionTracker::track_session(
 
     tracked_sessions[session_id] =
         { session_path, logind_session_type_to_repowerd_type(session_type) };
+
+    // Processes of this session may have previously resolved to another one
+    pid_session_cache.clear();
 }
 
 void repowerd::LogindSessionTracker::remove_session(std::string const& session_id)
@@ -272,6 +317,7 @@ void repowerd::LogindSessionTracker::remove_session(std::string const& session_i
         log->log(log_tag, "remove_session(%s)", session_id.c_str());
 
         tracked_sessions.erase(iter);
+        pid_session_cache.remove_session(session_id);
         session_removed_handler(session_id);
     }
 }
@@ -290,6 +336,7 @@ void repowerd::LogindSessionTracker::activate_session(
     {
         log->log(log_tag, "activate_session(%s)", session_id.c_str());
         active_session_id = iter->first;
+        pid_session_cache.clear();
         active_session_changed_handler(iter->first, iter->second.type);
     }
 }
@@ -302,6 +349,7 @@ void repowerd::LogindSessionTracker::deactivate_session()
         return;
 
     active_session_id = invalid_session_id;
+    pid_session_cache.clear();
 
     active_session_changed_handler(
         repowerd::invalid_session_id,
@@ -329,8 +377,8 @@ std::pair<std::string,std::string> repowerd::LogindSessionTracker::dbus_get_acti
 
     if (!result)
     {
-        log->log(log_tag, "dbus_get_active_session() failed to get ActiveSession: %s",
-                 error.message_str().c_str());
+        REPOWERD_LOG_WARNING(*log, log_tag, "dbus_get_active_session() failed to get ActiveSession: %s",
+                             error.message_str().c_str());
         return {"",""};
     }
 
@@ -371,8 +419,8 @@ std::string repowerd::LogindSessionTracker::dbus_get_session_type(std::string co
 
     if (!result)
     {
-        log->log(log_tag, "dbus_get_session_type() failed to get session Type: %s",
-                 error.message_str().c_str());
+        REPOWERD_LOG_WARNING(*log, log_tag, "dbus_get_session_type() failed to get session Type: %s",
+                             error.message_str().c_str());
         return "";
     }
 
@@ -411,8 +459,8 @@ std::string repowerd::LogindSessionTracker::dbus_get_session_path_by_pid(pid_t p
 
     if (!result)
     {
-        log->log(log_tag, "dbus_get_session_by_pid() failed: %s",
-                 error.message_str().c_str());
+        REPOWERD_LOG_WARNING(*log, log_tag, "dbus_get_session_by_pid() failed: %s",
+                             error.message_str().c_str());
         return invalid_session_id;
     }
 
@@ -463,8 +511,8 @@ uid_t repowerd::LogindSessionTracker::dbus_get_session_uid(std::string const& se
 
     if (!result)
     {
-        log->log(log_tag, "dbus_get_session_uid() failed to get session uid: %s",
-                 error.message_str().c_str());
+        REPOWERD_LOG_WARNING(*log, log_tag, "dbus_get_session_uid() failed to get session uid: %s",
+                             error.message_str().c_str());
         return -1;
     }
 
@@ -23,7 +23,9 @@
 #include "dbus_connection_handle.h"
 #include "dbus_event_loop.h"
 #include "filesystem.h"
+#include "pid_session_cache.h"
 
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 
@@ -73,11 +75,19 @@ private:
     std::string dbus_get_session_path_by_pid(pid_t pid);
     std::string session_id_for_path(std::string const& session_path);
     uid_t dbus_get_session_uid(std::string const& session_path);
+    void schedule_pid_exit_poll();
 
     std::shared_ptr<Filesystem> const filesystem;
     std::shared_ptr<Log> const log;
     bool const ignore_session_deactivation;
 
+    // Sessions of recent client processes, so that repeated requests don't
+    // need any D-Bus calls. Looked up without going through dbus_event_loop,
+    // and declared before it, since its exit notification fd is watched
+    // there.
+    PidSessionCache pid_session_cache;
+    std::atomic<bool> pid_exit_poll_scheduled;
+
     DBusConnectionHandle dbus_connection;
     DBusEventLoop dbus_event_loop;
     HandlerRegistration dbus_seat_signal_handler_registration;
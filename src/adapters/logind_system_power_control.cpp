@@ -247,7 +247,7 @@ repowerd::Fd repowerd::LogindSystemPowerControl::dbus_inhibit(
 
     if (!result)
     {
-        log->log(log_tag, "dbus_inhibit() failed: %s", error.message_str().c_str());
+        REPOWERD_LOG_WARNING(*log, log_tag, "dbus_inhibit() failed: %s", error.message_str().c_str());
         return Fd{-1};
     }
 
@@ -257,7 +257,7 @@ repowerd::Fd repowerd::LogindSystemPowerControl::dbus_inhibit(
 
     auto inhibit_fd = Fd{g_unix_fd_list_get(fd_list, inhibit_fd_index, error)};
     if (inhibit_fd < 0)
-        log->log(log_tag, "dbus_inhibit() get fd failed: %s", error.message_str().c_str());
+        REPOWERD_LOG_WARNING(*log, log_tag, "dbus_inhibit() get fd failed: %s", error.message_str().c_str());
     else
         log->log(log_tag, "dbus_inhibit(%s,%s) done", what, why);
     g_object_unref(fd_list);
@@ -287,7 +287,7 @@ void repowerd::LogindSystemPowerControl::dbus_power_off()
         error);
 
     if (!result)
-        log->log(log_tag, "dbus_power_off() failed: %s", error.message_str().c_str());
+        REPOWERD_LOG_WARNING(*log, log_tag, "dbus_power_off() failed: %s", error.message_str().c_str());
     else
         log->log(log_tag, "dbus_power_off() done");
 
@@ -316,7 +316,7 @@ void repowerd::LogindSystemPowerControl::dbus_suspend()
         error);
 
     if (!result)
-        log->log(log_tag, "dbus_suspend() failed: %s", error.message_str().c_str());
+        REPOWERD_LOG_WARNING(*log, log_tag, "dbus_suspend() failed: %s", error.message_str().c_str());
     else
         log->log(log_tag, "dbus_suspend() done");
 
@@ -353,8 +353,8 @@ std::string repowerd::LogindSystemPowerControl::dbus_get_block_inhibited()
 
     if (!result)
     {
-        log->log(log_tag, "dbus_get_block_inhibited() failed to get BlockInhibited: %s",
-                 error.message_str().c_str());
+        REPOWERD_LOG_WARNING(*log, log_tag, "dbus_get_block_inhibited() failed to get BlockInhibited: %s",
+                             error.message_str().c_str());
         return "";
     }
 
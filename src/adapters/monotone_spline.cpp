@@ -116,10 +116,29 @@ std::vector<repowerd::MonotoneSpline::Point> sorted(
 }
 
 repowerd::MonotoneSpline::MonotoneSpline(
-    std::vector<Point> const& points)
-    : points{sorted(points)},
-      tangents{calculate_monotone_point_tangents(this->points)}
+    std::vector<Point> const& unsorted_points)
 {
+    auto const points = sorted(unsorted_points);
+    auto const tangents = calculate_monotone_point_tangents(points);
+
+    for (auto i = 0u; i < points.size() - 1; ++i)
+    {
+        auto const h = points[i+1].x - points[i].x;
+        auto const slope = (points[i+1].y - points[i].y) / h;
+
+        xs.push_back(points[i].x);
+        segments.push_back(
+            {points[i].y,
+             tangents[i],
+             (3 * slope - 2 * tangents[i] - tangents[i+1]) / h,
+             (tangents[i] + tangents[i+1] - 2 * slope) / (h * h),
+             std::min(points[i].y, points[i+1].y),
+             std::max(points[i].y, points[i+1].y)});
+    }
+
+    xs.push_back(points.back().x);
+    front_y = points.front().y;
+    back_y = points.back().y;
 }
 
 double repowerd::MonotoneSpline::interpolate(double x) const
@@ -127,33 +146,21 @@ double repowerd::MonotoneSpline::interpolate(double x) const
     auto const i = find_index(x);
 
     if (i < 0)
-        return points.front().y;
-    if (i >= static_cast<int>(points.size() - 1))
-        return points.back().y;
-
-    auto const h = points[i+1].x - points[i].x;
-    auto const t = (x - points[i].x) / h;
-    auto const h00 = t * t * (2 * t - 3) + 1;
-    auto const h10 = t * (1 + t * (t - 2));
-    auto const h01 = t * t * (3 - 2 * t);
-    auto const h11 = t * t * (t - 1);
-
-    return h00 * points[i].y +
-           h10 * h * tangents[i] +
-           h01 * points[i+1].y +
-           h11 * h * tangents[i+1];
+        return front_y;
+    if (i >= static_cast<int>(segments.size()))
+        return back_y;
+
+    auto const& s = segments[i];
+    auto const dx = x - xs[i];
+    auto const y = s.y0 + dx * (s.c1 + dx * (s.c2 + dx * s.c3));
+
+    // The segment is monotone, so this only removes rounding errors that
+    // could otherwise break monotonicity across segment boundaries
+    return std::min(std::max(y, s.min_y), s.max_y);
 }
 
 int repowerd::MonotoneSpline::find_index(double x) const
 {
-    if (x < points[0].x)
-        return -1;
-
-    for (auto i = 0u; i < points.size() - 1; ++i)
-    {
-        if (x >= points[i].x && x < points[i+1].x)
-            return i;
-    }
-
-    return points.size() - 1;
+    auto const iter = std::upper_bound(xs.begin(), xs.end(), x);
+    return static_cast<int>(iter - xs.begin()) - 1;
 }
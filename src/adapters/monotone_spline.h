@@ -25,6 +25,9 @@ namespace repowerd
 
 // Implemented using Monotone cubic Hermite interpolation
 // See: https://en.wikipedia.org/wiki/Monotone_cubic_interpolation
+//
+// The Hermite form of each segment is expanded into a cubic polynomial at
+// construction, so interpolation is a binary search and a Horner evaluation.
 class MonotoneSpline
 {
 public:
@@ -35,10 +38,23 @@ public:
     double interpolate(double x) const;
 
 private:
+    // y = y0 + dx * (c1 + dx * (c2 + dx * c3)), with dx from the segment start
+    struct Segment
+    {
+        double y0;
+        double c1;
+        double c2;
+        double c3;
+        double min_y;
+        double max_y;
+    };
+
     int find_index(double x) const;
 
-    std::vector<Point> points;
-    std::vector<double> tangents;
+    std::vector<double> xs;
+    std::vector<Segment> segments;
+    double front_y;
+    double back_y;
 };
 
 }
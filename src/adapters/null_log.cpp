@@ -18,6 +18,6 @@
 
 #include "null_log.h"
 
-void repowerd::NullLog::log(char const*, char const*, ...)
+void repowerd::NullLog::vlog(LogLevel, char const*, char const*, va_list)
 {
 }
@@ -25,8 +25,8 @@ namespace repowerd
 
 class NullLog : public Log
 {
-public:
-    void log(char const* tag, char const* format, ...) override;
+protected:
+    void vlog(LogLevel level, char const* tag, char const* format, va_list ap) override;
 };
 
 }
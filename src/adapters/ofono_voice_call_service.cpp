@@ -216,12 +216,12 @@ repowerd::HandlerRegistration repowerd::OfonoVoiceCallService::register_update_c
 
 void repowerd::OfonoVoiceCallService::set_low_power_mode()
 {
-    dbus_event_loop.enqueue([this] { set_fast_dormancy(true); });
+    dbus_event_loop.post([this] { set_fast_dormancy(true); });
 }
 
 void repowerd::OfonoVoiceCallService::set_normal_power_mode()
 {
-    dbus_event_loop.enqueue([this] { set_fast_dormancy(false); });
+    dbus_event_loop.post([this] { set_fast_dormancy(false); });
 }
 
 std::unordered_set<std::string> repowerd::OfonoVoiceCallService::tracked_modems()
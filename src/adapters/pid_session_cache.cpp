@@ -0,0 +1,240 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "pid_session_cache.h"
+#include "filesystem.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+
+int pidfd_open(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return syscall(SYS_pidfd_open, pid, 0);
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+bool has_exited(int pidfd)
+{
+    pollfd pfd{pidfd, POLLIN, 0};
+    return poll(&pfd, 1, 0) != 0;
+}
+
+}
+
+repowerd::PidSessionCache::PidSessionCache(
+    std::shared_ptr<Filesystem> const& filesystem, size_t capacity)
+    : filesystem{filesystem},
+      capacity{capacity},
+      epoll_fd{epoll_create1(EPOLL_CLOEXEC)},
+      use_counter{0},
+      generation{0}
+{
+    if (epoll_fd < 0)
+        throw std::system_error{errno, std::system_category(), "Failed to create epoll fd"};
+}
+
+bool repowerd::PidSessionCache::lookup(pid_t pid, std::string& session_id)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const iter = entries.find(pid);
+    if (iter == entries.end())
+        return false;
+
+    if (!is_same_process(pid, iter->second.pidfd, iter->second.start_time))
+    {
+        entries.erase(iter);
+        return false;
+    }
+
+    iter->second.last_used = ++use_counter;
+    session_id = iter->second.session_id;
+
+    return true;
+}
+
+repowerd::PidSessionCache::ProcessIdentity
+repowerd::PidSessionCache::identify(pid_t pid)
+{
+    Fd pidfd{pidfd_open(pid)};
+    auto const start_time = pidfd < 0 ? start_time_of(pid) : 0;
+
+    std::lock_guard<std::mutex> lock{mutex};
+    return {std::move(pidfd), start_time, generation};
+}
+
+void repowerd::PidSessionCache::insert(
+    pid_t pid, ProcessIdentity&& identity, std::string const& session_id)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    if (identity.generation != generation ||
+        !is_same_process(pid, identity.pidfd, identity.start_time))
+    {
+        return;
+    }
+
+    entries.erase(pid);
+
+    if (entries.size() >= capacity)
+        evict_one();
+
+    if (identity.pidfd >= 0)
+    {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = static_cast<uint64_t>(pid);
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, identity.pidfd, &event);
+    }
+
+    entries.emplace(
+        pid,
+        Entry{session_id, std::move(identity.pidfd), identity.start_time, ++use_counter});
+}
+
+void repowerd::PidSessionCache::remove_session(std::string const& session_id)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    for (auto iter = entries.begin(); iter != entries.end();)
+    {
+        if (iter->second.session_id == session_id)
+            iter = entries.erase(iter);
+        else
+            ++iter;
+    }
+}
+
+void repowerd::PidSessionCache::clear()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    entries.clear();
+    ++generation;
+}
+
+int repowerd::PidSessionCache::exit_notification_fd() const
+{
+    return epoll_fd;
+}
+
+void repowerd::PidSessionCache::process_exit_notifications()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    epoll_event events[16];
+    auto const n = epoll_wait(epoll_fd, events, 16, 0);
+
+    // Closing the pidfd of an erased entry also removes it from the epoll
+    // set. Any remaining events are picked up on the next notification.
+    for (int i = 0; i < n; ++i)
+    {
+        auto const iter = entries.find(static_cast<pid_t>(events[i].data.u64));
+        if (iter != entries.end() && has_exited(iter->second.pidfd))
+            entries.erase(iter);
+    }
+}
+
+bool repowerd::PidSessionCache::poll_exits()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto polled_entries = false;
+
+    for (auto iter = entries.begin(); iter != entries.end();)
+    {
+        if (iter->second.pidfd >= 0)
+        {
+            ++iter;
+        }
+        else if (start_time_of(iter->first) != iter->second.start_time)
+        {
+            iter = entries.erase(iter);
+        }
+        else
+        {
+            polled_entries = true;
+            ++iter;
+        }
+    }
+
+    return polled_entries;
+}
+
+size_t repowerd::PidSessionCache::size()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return entries.size();
+}
+
+bool repowerd::PidSessionCache::is_same_process(
+    pid_t pid, Fd const& pidfd, uint64_t start_time)
+{
+    if (pidfd >= 0)
+        return !has_exited(pidfd);
+
+    return start_time != 0 && start_time_of(pid) == start_time;
+}
+
+uint64_t repowerd::PidSessionCache::start_time_of(pid_t pid)
+{
+    auto stat = filesystem->istream("/proc/" + std::to_string(pid) + "/stat");
+    std::string line;
+    std::getline(*stat, line);
+
+    // The command name may contain spaces, so start after its closing
+    // parenthesis, where the state (field 3) begins. The start time is
+    // field 22.
+    auto pos = line.rfind(')');
+    if (pos == std::string::npos)
+        return 0;
+
+    for (int field = 3; field <= 22 && pos != std::string::npos; ++field)
+        pos = line.find(' ', pos + 1);
+
+    if (pos == std::string::npos)
+        return 0;
+
+    return std::strtoull(line.c_str() + pos + 1, nullptr, 10);
+}
+
+void repowerd::PidSessionCache::evict_one()
+{
+    auto const lru = std::min_element(
+        entries.begin(), entries.end(),
+        [] (auto const& a, auto const& b)
+        {
+            return a.second.last_used < b.second.last_used;
+        });
+
+    if (lru != entries.end())
+        entries.erase(lru);
+}
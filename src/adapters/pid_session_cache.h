@@ -0,0 +1,96 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "fd.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <sys/types.h>
+
+namespace repowerd
+{
+class Filesystem;
+
+// Bounded cache of the session each process belongs to. Entries are tied
+// to the identity of the process, through a pidfd where the kernel supports
+// it and through the process start time otherwise, so that a reused pid
+// never matches a stale entry. Exited processes are reported through
+// exit_notification_fd(), which becomes readable when any cached process
+// with a pidfd exits. Entries without a pidfd have to be polled for with
+// poll_exits() instead. Thread-safe.
+class PidSessionCache
+{
+public:
+    struct ProcessIdentity
+    {
+        Fd pidfd;
+        uint64_t start_time;
+        uint64_t generation;
+    };
+
+    PidSessionCache(std::shared_ptr<Filesystem> const& filesystem, size_t capacity);
+
+    bool lookup(pid_t pid, std::string& session_id);
+
+    // Captures the identity of a process before resolving its session, so
+    // that insert() can detect whether the process changed in the meantime,
+    // or whether the cache was cleared
+    ProcessIdentity identify(pid_t pid);
+    void insert(pid_t pid, ProcessIdentity&& identity, std::string const& session_id);
+
+    void remove_session(std::string const& session_id);
+    void clear();
+
+    int exit_notification_fd() const;
+    void process_exit_notifications();
+
+    // Drops the entries without a pidfd whose processes have exited, and
+    // returns whether any such entries remain to be polled again
+    bool poll_exits();
+
+    size_t size();
+
+private:
+    struct Entry
+    {
+        std::string session_id;
+        Fd pidfd;
+        uint64_t start_time;
+        uint64_t last_used;
+    };
+
+    bool is_same_process(pid_t pid, Fd const& pidfd, uint64_t start_time);
+    uint64_t start_time_of(pid_t pid);
+    void evict_one();
+
+    std::shared_ptr<Filesystem> const filesystem;
+    size_t const capacity;
+    Fd const epoll_fd;
+
+    std::mutex mutex;
+    std::unordered_map<pid_t,Entry> entries;
+    uint64_t use_counter;
+    uint64_t generation;
+};
+
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "proximity_state_cache.h"
+#include "chrono.h"
+
+#include <algorithm>
+
+repowerd::ProximityStateCache::ProximityStateCache(
+    std::shared_ptr<Chrono> const& chrono,
+    std::chrono::milliseconds freshness_window,
+    std::chrono::milliseconds linger_period)
+    : chrono{chrono},
+      freshness_window{freshness_window},
+      linger_period{linger_period},
+      has_state_{false},
+      is_valid_{false},
+      state_{ProximityState::far},
+      is_lingering_{false}
+{
+}
+
+void repowerd::ProximityStateCache::record(ProximityState state)
+{
+    state_ = state;
+    has_state_ = true;
+    is_valid_ = true;
+    state_time = chrono->steady_now();
+}
+
+void repowerd::ProximityStateCache::sensor_powered_off()
+{
+    // The last reported state has been accurate up until now
+    if (is_valid_)
+        state_time = chrono->steady_now();
+    is_valid_ = false;
+    is_lingering_ = false;
+}
+
+bool repowerd::ProximityStateCache::has_state() const
+{
+    return has_state_;
+}
+
+bool repowerd::ProximityStateCache::is_valid() const
+{
+    return is_valid_;
+}
+
+bool repowerd::ProximityStateCache::is_fresh() const
+{
+    return has_state_ && chrono->steady_now() - state_time <= freshness_window;
+}
+
+repowerd::ProximityState repowerd::ProximityStateCache::state() const
+{
+    return state_;
+}
+
+bool repowerd::ProximityStateCache::start_linger()
+{
+    if (linger_period <= std::chrono::milliseconds::zero())
+        return false;
+
+    is_lingering_ = true;
+    linger_end = chrono->steady_now() + linger_period;
+
+    return true;
+}
+
+void repowerd::ProximityStateCache::cancel_linger()
+{
+    is_lingering_ = false;
+}
+
+bool repowerd::ProximityStateCache::is_lingering() const
+{
+    return is_lingering_;
+}
+
+std::chrono::milliseconds repowerd::ProximityStateCache::linger_time_left() const
+{
+    if (!is_lingering_)
+        return std::chrono::milliseconds::zero();
+
+    // Rounded up, so that waiting for it is enough for the linger to end
+    auto const left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        linger_end - chrono->steady_now() + std::chrono::milliseconds{1} -
+        std::chrono::nanoseconds{1});
+
+    return std::max(left, std::chrono::milliseconds::zero());
+}
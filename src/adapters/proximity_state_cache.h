@@ -0,0 +1,73 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+#include "src/core/proximity_sensor.h"
+
+#include <chrono>
+#include <memory>
+
+namespace repowerd
+{
+class Chrono;
+
+// Decides when the proximity state can be answered without waiting for the
+// sensor, and when a sensor left lingering after its last user went away
+// should be powered off. A reading is valid while the sensor stays powered,
+// and remains usable for freshness_window after it is powered off. Not
+// thread-safe.
+class ProximityStateCache
+{
+public:
+    ProximityStateCache(
+        std::shared_ptr<Chrono> const& chrono,
+        std::chrono::milliseconds freshness_window,
+        std::chrono::milliseconds linger_period);
+
+    void record(ProximityState state);
+    void sensor_powered_off();
+
+    bool has_state() const;
+    bool is_valid() const;
+    bool is_fresh() const;
+    ProximityState state() const;
+
+    // Returns false if the sensor shouldn't linger, but be powered off now
+    bool start_linger();
+    void cancel_linger();
+    bool is_lingering() const;
+    // Zero once the lingering sensor should be powered off
+    std::chrono::milliseconds linger_time_left() const;
+
+private:
+    std::shared_ptr<Chrono> const chrono;
+    std::chrono::milliseconds const freshness_window;
+    std::chrono::milliseconds const linger_period;
+
+    bool has_state_;
+    bool is_valid_;
+    ProximityState state_;
+    // When the state was last known to be accurate
+    std::chrono::steady_clock::time_point state_time;
+
+    bool is_lingering_;
+    std::chrono::steady_clock::time_point linger_end;
+};
+
+}
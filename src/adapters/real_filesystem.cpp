@@ -24,6 +24,7 @@
 #include <fstream>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 namespace
 {
@@ -98,3 +99,15 @@ int repowerd::RealFilesystem::ioctl(
     else
         return ::ioctl(fd, request);
 }
+
+ssize_t repowerd::RealFilesystem::pread(
+    int fd, void* buf, size_t count, off_t offset) const
+{
+    return ::pread(fd, buf, count, offset);
+}
+
+ssize_t repowerd::RealFilesystem::pwrite(
+    int fd, void const* buf, size_t count, off_t offset) const
+{
+    return ::pwrite(fd, buf, count, offset);
+}
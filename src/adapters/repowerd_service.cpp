@@ -17,9 +17,11 @@
  */
 
 #include "repowerd_service.h"
+#include "battery_discharge_estimator.h"
+#include "dbus_sender_credentials.h"
 #include "event_loop_handler_registration.h"
-#include "scoped_g_error.h"
 
+#include "src/core/event_latency.h"
 #include "src/core/infinite_timeout.h"
 #include "src/core/log.h"
 
@@ -52,6 +54,19 @@ char const* const repowerd_service_introspection = R"(
     <method name='SetCriticalPowerBehavior'>
       <arg type='s' name='action' direction='in' />
     </method>
+    <method name='GetEventLatencies'>
+      <arg type='a(sttttttt)' name='latencies' direction='out' />
+    </method>
+    <method name='GetBatteryEstimates'>
+      <arg type='a(sdt)' name='estimates' direction='out' />
+    </method>
+    <method name='SetLogLevel'>
+      <arg type='s' name='tag' direction='in' />
+      <arg type='s' name='level' direction='in' />
+    </method>
+    <method name='GetLogLevels'>
+      <arg type='a(ss)' name='levels' direction='out' />
+    </method>
   </interface>
 </node>)";
 
@@ -83,8 +98,14 @@ repowerd::PowerSupply power_supply_from_string(std::string const& str)
 
 repowerd::RepowerdService::RepowerdService(
     std::shared_ptr<Log> const& log,
+    std::shared_ptr<EventLatencyStats> const& event_latency_stats,
+    std::shared_ptr<BatteryEstimates> const& battery_estimates,
+    std::shared_ptr<DBusSenderCredentials> const& sender_credentials,
     std::string const& dbus_bus_address)
     : log{log},
+      event_latency_stats{event_latency_stats},
+      battery_estimates{battery_estimates},
+      sender_credentials{sender_credentials},
       dbus_connection{dbus_bus_address},
       dbus_event_loop{"RepowerdService"},
       set_inactivity_behavior_handler{null_arg4_handler},
@@ -202,6 +223,34 @@ void repowerd::RepowerdService::dbus_method_call(
 
         g_dbus_method_invocation_return_value(invocation, NULL);
     }
+    else if (method_name == "GetEventLatencies")
+    {
+        auto const latencies = dbus_GetEventLatencies(sender);
+
+        g_dbus_method_invocation_return_value(invocation, latencies);
+    }
+    else if (method_name == "GetBatteryEstimates")
+    {
+        auto const estimates = dbus_GetBatteryEstimates(sender);
+
+        g_dbus_method_invocation_return_value(invocation, estimates);
+    }
+    else if (method_name == "SetLogLevel")
+    {
+        char const* tag{""};
+        char const* level{""};
+        g_variant_get(parameters, "(&s&s)", &tag, &level);
+
+        dbus_SetLogLevel(sender, tag, level);
+
+        g_dbus_method_invocation_return_value(invocation, NULL);
+    }
+    else if (method_name == "GetLogLevels")
+    {
+        auto const levels = dbus_GetLogLevels(sender);
+
+        g_dbus_method_invocation_return_value(invocation, levels);
+    }
     else
     {
         dbus_unknown_method(sender, method_name);
@@ -282,6 +331,93 @@ void repowerd::RepowerdService::dbus_SetCriticalPowerBehavior(
     set_critical_power_behavior_handler(power_action, pid);
 }
 
+GVariant* repowerd::RepowerdService::dbus_GetEventLatencies(
+    std::string const& sender)
+{
+    REPOWERD_LOG_DEBUG(*log, log_tag, "dbus_GetEventLatencies(%s)", sender.c_str());
+
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a(sttttttt)"));
+
+    for (auto i = 0; i < static_cast<int>(EventType::count); ++i)
+    {
+        auto const type = static_cast<EventType>(i);
+        auto const s = event_latency_stats->summary(type);
+
+        g_variant_builder_add(
+            &builder, "(sttttttt)",
+            event_type_to_string(type),
+            static_cast<guint64>(s.count),
+            static_cast<guint64>(s.queue_p50.count()),
+            static_cast<guint64>(s.queue_p99.count()),
+            static_cast<guint64>(s.queue_max.count()),
+            static_cast<guint64>(s.total_p50.count()),
+            static_cast<guint64>(s.total_p99.count()),
+            static_cast<guint64>(s.total_max.count()));
+    }
+
+    return g_variant_new("(a(sttttttt))", &builder);
+}
+
+GVariant* repowerd::RepowerdService::dbus_GetBatteryEstimates(
+    std::string const& sender)
+{
+    REPOWERD_LOG_DEBUG(*log, log_tag, "dbus_GetBatteryEstimates(%s)", sender.c_str());
+
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a(sdt)"));
+
+    for (auto const& battery : battery_estimates->all())
+    {
+        g_variant_builder_add(
+            &builder, "(sdt)",
+            battery.first.c_str(),
+            battery.second.discharge_rate,
+            static_cast<guint64>(battery.second.time_to_empty.count()));
+    }
+
+    return g_variant_new("(a(sdt))", &builder);
+}
+
+// An empty tag sets the default level, an empty level resets a tag to it
+void repowerd::RepowerdService::dbus_SetLogLevel(
+    std::string const& sender,
+    std::string const& tag,
+    std::string const& level_str)
+{
+    log->log(log_tag, "dbus_SetLogLevel(%s,%s,%s)",
+             sender.c_str(), tag.c_str(), level_str.c_str());
+
+    if (tag.empty())
+        log->levels().set_default_level(log_level_from_string(level_str));
+    else if (level_str.empty())
+        log->levels().reset_tag_level(tag);
+    else
+        log->levels().set_tag_level(tag, log_level_from_string(level_str));
+}
+
+GVariant* repowerd::RepowerdService::dbus_GetLogLevels(
+    std::string const& sender)
+{
+    REPOWERD_LOG_DEBUG(*log, log_tag, "dbus_GetLogLevels(%s)", sender.c_str());
+
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a(ss)"));
+
+    g_variant_builder_add(
+        &builder, "(ss)", "", log_level_to_string(log->levels().default_level()));
+
+    for (auto const& tag_level : log->levels().tag_levels())
+    {
+        g_variant_builder_add(
+            &builder, "(ss)",
+            tag_level.first.c_str(),
+            log_level_to_string(tag_level.second));
+    }
+
+    return g_variant_new("(a(ss))", &builder);
+}
+
 void repowerd::RepowerdService::dbus_unknown_method(
     std::string const& sender, std::string const& name)
 {
@@ -291,34 +427,6 @@ void repowerd::RepowerdService::dbus_unknown_method(
 pid_t repowerd::RepowerdService::dbus_get_invocation_sender_pid(
     GDBusMethodInvocation* invocation)
 {
-    int constexpr timeout = 1000;
-    auto constexpr null_cancellable = nullptr;
-    ScopedGError error;
     auto const sender = g_dbus_method_invocation_get_sender(invocation);
-
-    auto const result = g_dbus_connection_call_sync(
-        dbus_connection,
-        "org.freedesktop.DBus",
-        "/org/freedesktop/DBus",
-        "org.freedesktop.DBus",
-        "GetConnectionUnixProcessID",
-        g_variant_new("(s)", sender),
-        G_VARIANT_TYPE("(u)"),
-        G_DBUS_CALL_FLAGS_NONE,
-        timeout,
-        null_cancellable,
-        error);
-
-    if (!result)
-    {
-        log->log(log_tag, "failed to get pid of '%s': %s",
-                 sender, error.message_str().c_str());
-        return -1;
-    }
-
-    guint pid;
-    g_variant_get(result, "(u)", &pid);
-    g_variant_unref(result);
-
-    return pid;
+    return sender_credentials->pid_for(dbus_connection, sender ? sender : "");
 }
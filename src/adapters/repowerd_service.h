@@ -30,6 +30,9 @@
 
 namespace repowerd
 {
+class BatteryEstimates;
+class DBusSenderCredentials;
+class EventLatencyStats;
 class Log;
 
 class RepowerdService : public ClientSettings
@@ -37,6 +40,9 @@ class RepowerdService : public ClientSettings
 public:
     RepowerdService(
         std::shared_ptr<Log> const& log,
+        std::shared_ptr<EventLatencyStats> const& event_latency_stats,
+        std::shared_ptr<BatteryEstimates> const& battery_estimates,
+        std::shared_ptr<DBusSenderCredentials> const& sender_credentials,
         std::string const& dbus_bus_address);
 
     void start_processing() override;
@@ -76,10 +82,21 @@ private:
         std::string const& power_action,
         pid_t pid);
 
+    GVariant* dbus_GetEventLatencies(std::string const& sender);
+    GVariant* dbus_GetBatteryEstimates(std::string const& sender);
+    void dbus_SetLogLevel(
+        std::string const& sender,
+        std::string const& tag,
+        std::string const& level);
+    GVariant* dbus_GetLogLevels(std::string const& sender);
+
     void dbus_unknown_method(std::string const& sender, std::string const& name);
     pid_t dbus_get_invocation_sender_pid(GDBusMethodInvocation* invocation);
 
     std::shared_ptr<Log> const log;
+    std::shared_ptr<EventLatencyStats> const event_latency_stats;
+    std::shared_ptr<BatteryEstimates> const battery_estimates;
+    std::shared_ptr<DBusSenderCredentials> const sender_credentials;
     DBusConnectionHandle dbus_connection;
     DBusEventLoop dbus_event_loop;
 
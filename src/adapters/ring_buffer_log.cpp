@@ -0,0 +1,979 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ring_buffer_log.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstddef>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+struct repowerd::RingBufferLog::Record
+{
+    static size_t constexpr tag_size = 48;
+    static size_t constexpr payload_size = 176;
+
+    std::chrono::steady_clock::time_point time;
+    LogLevel level;
+    char tag[tag_size];
+    char const* format;
+    uint16_t size;
+    bool truncated;
+    unsigned char payload[payload_size];
+};
+
+// Records are constructed in place when written, so the pages of the
+// anonymous mapping are only committed as the ring fills up
+struct repowerd::RingBufferLog::ThreadBuffer
+{
+    ThreadBuffer(size_t capacity)
+        : owner{std::this_thread::get_id()},
+          capacity{capacity},
+          storage{mmap(nullptr, capacity * sizeof(Record), PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)},
+          head{0},
+          tail{0},
+          dropped{0}
+    {
+        if (storage == MAP_FAILED)
+            throw std::system_error{errno, std::system_category(), "Failed to map log buffer"};
+    }
+
+    ~ThreadBuffer()
+    {
+        munmap(storage, capacity * sizeof(Record));
+    }
+
+    Record& slot(uint64_t index)
+    {
+        return static_cast<Record*>(storage)[index % capacity];
+    }
+
+    std::thread::id const owner;
+    size_t const capacity;
+    void* const storage;
+    // Written only by the owning thread
+    std::atomic<uint64_t> head;
+    // Written only by the drainer
+    std::atomic<uint64_t> tail;
+    std::atomic<uint64_t> dropped;
+};
+
+namespace
+{
+
+char const* const log_tag = "RingBufferLog";
+
+std::atomic<uint64_t> next_instance_id{1};
+std::atomic<repowerd::RingBufferLog*> signal_instance{nullptr};
+
+int const crash_signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+struct sigaction old_sigusr1_action;
+struct sigaction old_crash_actions[sizeof(crash_signals)/sizeof(crash_signals[0])];
+
+struct ThreadBufferCache
+{
+    uint64_t instance_id;
+    std::shared_ptr<repowerd::RingBufferLog::ThreadBuffer> buffer;
+};
+
+thread_local ThreadBufferCache thread_buffer_cache{0, nullptr};
+
+enum class ArgType : unsigned char { signed_int, unsigned_int, floating, string, pointer };
+
+enum class Length : unsigned char { none, hh, h, l, ll, L, j, z, t };
+
+// A printf conversion specification, without the leading '%'
+struct Spec
+{
+    char const* end;
+    int num_stars;
+    Length length;
+    int length_chars;
+    char conversion;
+};
+
+bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+Spec parse_spec(char const* p)
+{
+    Spec spec{p, 0, Length::none, 0, 0};
+
+    for (;; ++p)
+    {
+        switch (*p)
+        {
+        case '-': case '+': case ' ': case '#': case '0': case '\'':
+            continue;
+        }
+        break;
+    }
+
+    if (*p == '*') { ++spec.num_stars; ++p; }
+    while (is_digit(*p)) ++p;
+    if (*p == '.')
+    {
+        ++p;
+        if (*p == '*') { ++spec.num_stars; ++p; }
+        while (is_digit(*p)) ++p;
+    }
+
+    auto const start = p;
+    switch (*p)
+    {
+    case 'h':
+        ++p;
+        if (*p == 'h') { spec.length = Length::hh; ++p; }
+        else spec.length = Length::h;
+        break;
+    case 'l':
+        ++p;
+        if (*p == 'l') { spec.length = Length::ll; ++p; }
+        else spec.length = Length::l;
+        break;
+    case 'q': spec.length = Length::ll; ++p; break;
+    case 'L': spec.length = Length::L; ++p; break;
+    case 'j': spec.length = Length::j; ++p; break;
+    case 'z': spec.length = Length::z; ++p; break;
+    case 't': spec.length = Length::t; ++p; break;
+    }
+    spec.length_chars = p - start;
+
+    spec.conversion = *p;
+    spec.end = *p ? p + 1 : p;
+
+    return spec;
+}
+
+bool is_signed_conversion(char c) { return c == 'd' || c == 'i'; }
+
+bool is_unsigned_conversion(char c)
+{
+    return c == 'u' || c == 'o' || c == 'x' || c == 'X' || c == 'c';
+}
+
+bool is_floating_conversion(char c)
+{
+    switch (c)
+    {
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Tags may be owned by short-lived objects (e.g. per-session state
+// machines), so unlike formats they are copied, truncated if needed
+void copy_tag(repowerd::RingBufferLog::Record& record, char const* tag)
+{
+    if (!tag) tag = "(null)";
+    auto const len = strnlen(tag, repowerd::RingBufferLog::Record::tag_size - 1);
+    memcpy(record.tag, tag, len);
+    record.tag[len] = '\0';
+}
+
+class PayloadWriter
+{
+public:
+    PayloadWriter(repowerd::RingBufferLog::Record& record)
+        : record(record)
+    {
+        record.size = 0;
+        record.truncated = false;
+    }
+
+    template <typename T>
+    void put(ArgType type, T value)
+    {
+        if (!reserve(1 + sizeof(value))) return;
+        record.payload[record.size++] = static_cast<unsigned char>(type);
+        memcpy(&record.payload[record.size], &value, sizeof(value));
+        record.size += sizeof(value);
+    }
+
+    void put_string(char const* str)
+    {
+        if (!str) str = "(null)";
+        if (!reserve(2)) return;
+
+        auto const max_len = repowerd::RingBufferLog::Record::payload_size - record.size - 2;
+        auto const len = strnlen(str, max_len);
+
+        record.payload[record.size++] = static_cast<unsigned char>(ArgType::string);
+        memcpy(&record.payload[record.size], str, len);
+        record.size += len;
+        record.payload[record.size++] = '\0';
+    }
+
+private:
+    bool reserve(size_t n)
+    {
+        if (record.truncated ||
+            record.size + n > repowerd::RingBufferLog::Record::payload_size)
+        {
+            record.truncated = true;
+            return false;
+        }
+        return true;
+    }
+
+    repowerd::RingBufferLog::Record& record;
+};
+
+void capture_args(repowerd::RingBufferLog::Record& record, va_list ap)
+{
+    PayloadWriter writer{record};
+
+    for (auto p = strchr(record.format, '%'); p; p = strchr(p, '%'))
+    {
+        auto const spec = parse_spec(p + 1);
+        p = spec.end;
+
+        for (int i = 0; i < spec.num_stars; ++i)
+            writer.put(ArgType::signed_int, static_cast<long long>(va_arg(ap, int)));
+
+        auto const c = spec.conversion;
+
+        if (is_signed_conversion(c))
+        {
+            long long v;
+            switch (spec.length)
+            {
+            case Length::ll: v = va_arg(ap, long long); break;
+            case Length::l: v = va_arg(ap, long); break;
+            case Length::z: v = va_arg(ap, ssize_t); break;
+            case Length::j: v = va_arg(ap, intmax_t); break;
+            case Length::t: v = va_arg(ap, ptrdiff_t); break;
+            case Length::hh: v = static_cast<signed char>(va_arg(ap, int)); break;
+            case Length::h: v = static_cast<short>(va_arg(ap, int)); break;
+            default: v = va_arg(ap, int); break;
+            }
+            writer.put(ArgType::signed_int, v);
+        }
+        else if (is_unsigned_conversion(c))
+        {
+            unsigned long long v;
+            switch (spec.length)
+            {
+            case Length::ll: v = va_arg(ap, unsigned long long); break;
+            case Length::l: v = va_arg(ap, unsigned long); break;
+            case Length::z: v = va_arg(ap, size_t); break;
+            case Length::j: v = va_arg(ap, uintmax_t); break;
+            case Length::t: v = va_arg(ap, ptrdiff_t); break;
+            case Length::hh: v = static_cast<unsigned char>(va_arg(ap, unsigned int)); break;
+            case Length::h: v = static_cast<unsigned short>(va_arg(ap, unsigned int)); break;
+            default: v = va_arg(ap, unsigned int); break;
+            }
+            writer.put(ArgType::unsigned_int, v);
+        }
+        else if (is_floating_conversion(c))
+        {
+            double const v = spec.length == Length::L ?
+                static_cast<double>(va_arg(ap, long double)) : va_arg(ap, double);
+            writer.put(ArgType::floating, v);
+        }
+        else if (c == 's')
+        {
+            writer.put_string(va_arg(ap, char const*));
+        }
+        else if (c == 'p')
+        {
+            writer.put(ArgType::pointer, va_arg(ap, void*));
+        }
+        else if (c == 'n')
+        {
+            va_arg(ap, void*);
+        }
+    }
+}
+
+class PayloadReader
+{
+public:
+    PayloadReader(repowerd::RingBufferLog::Record const& record)
+        : record(record), pos{0}
+    {
+    }
+
+    template <typename T>
+    bool get(T& value)
+    {
+        if (pos + 1 + sizeof(value) > record.size) return false;
+        memcpy(&value, &record.payload[pos + 1], sizeof(value));
+        pos += 1 + sizeof(value);
+        return true;
+    }
+
+    bool get_string(char const*& str)
+    {
+        if (pos + 2 > record.size) return false;
+        str = reinterpret_cast<char const*>(&record.payload[pos + 1]);
+        pos += 1 + strnlen(str, record.size - pos - 1) + 1;
+        return true;
+    }
+
+private:
+    repowerd::RingBufferLog::Record const& record;
+    size_t pos;
+};
+
+template <typename T>
+void append_formatted(
+    std::string& out, std::string const& spec, int const* stars, int num_stars, T value)
+{
+    char buffer[256];
+    auto const format = [&] (char* buf, size_t size)
+        {
+            if (num_stars == 2)
+                return snprintf(buf, size, spec.c_str(), stars[0], stars[1], value);
+            else if (num_stars == 1)
+                return snprintf(buf, size, spec.c_str(), stars[0], value);
+            else
+                return snprintf(buf, size, spec.c_str(), value);
+        };
+
+    auto const n = format(buffer, sizeof(buffer));
+    if (n < 0)
+        return;
+
+    if (static_cast<size_t>(n) < sizeof(buffer))
+    {
+        out.append(buffer, n);
+    }
+    else
+    {
+        std::vector<char> large(n + 1);
+        format(large.data(), large.size());
+        out.append(large.data(), n);
+    }
+}
+
+std::string format_record(repowerd::RingBufferLog::Record const& record)
+{
+    std::string out;
+    PayloadReader reader{record};
+
+    auto p = record.format;
+
+    for (auto q = strchr(p, '%'); q; q = strchr(p, '%'))
+    {
+        out.append(p, q - p);
+
+        auto const spec = parse_spec(q + 1);
+        p = spec.end;
+
+        if (spec.conversion == '%')
+        {
+            out += '%';
+            continue;
+        }
+
+        // Rebuild the specification with the length of the stored value
+        std::string spec_str{q, static_cast<size_t>(spec.end - q)};
+        auto const length_pos = spec_str.size() - 1 - spec.length_chars;
+        spec_str.erase(length_pos, spec.length_chars);
+
+        int stars[2] = {0, 0};
+        auto ok = true;
+        for (int i = 0; i < spec.num_stars && ok; ++i)
+        {
+            long long star{0};
+            ok = reader.get(star);
+            stars[i] = static_cast<int>(star);
+        }
+
+        auto const c = spec.conversion;
+
+        if (is_signed_conversion(c) && ok)
+        {
+            long long v{0};
+            if ((ok = reader.get(v)))
+                append_formatted(out, spec_str.insert(length_pos, "ll"), stars, spec.num_stars, v);
+        }
+        else if (is_unsigned_conversion(c) && ok)
+        {
+            unsigned long long v{0};
+            if ((ok = reader.get(v)))
+            {
+                if (c == 'c')
+                    append_formatted(out, spec_str, stars, spec.num_stars, static_cast<int>(v));
+                else
+                    append_formatted(out, spec_str.insert(length_pos, "ll"), stars, spec.num_stars, v);
+            }
+        }
+        else if (is_floating_conversion(c) && ok)
+        {
+            double v{0};
+            if ((ok = reader.get(v)))
+                append_formatted(out, spec_str, stars, spec.num_stars, v);
+        }
+        else if (c == 's' && ok)
+        {
+            char const* v{""};
+            if ((ok = reader.get_string(v)))
+                append_formatted(out, spec_str, stars, spec.num_stars, v);
+        }
+        else if (c == 'p' && ok)
+        {
+            void* v{nullptr};
+            if ((ok = reader.get(v)))
+                append_formatted(out, spec_str, stars, spec.num_stars, v);
+        }
+
+        if (!ok)
+        {
+            out += "<truncated>";
+            return out;
+        }
+    }
+
+    out += p;
+
+    return out;
+}
+
+// Writes lines with write(2) from a fixed buffer, for use in signal
+// handlers. Lines longer than the buffer are cut short.
+class CrashLineWriter
+{
+public:
+    CrashLineWriter(int fd) : fd{fd}, size{0} {}
+
+    void put(char c)
+    {
+        if (size < sizeof(line) - 1)
+            line[size++] = c;
+    }
+
+    void put(char const* str)
+    {
+        while (*str)
+            put(*str++);
+    }
+
+    void put_unsigned(unsigned long long value, unsigned base)
+    {
+        char digits[64];
+        int n = 0;
+        do
+        {
+            digits[n++] = "0123456789abcdef"[value % base];
+            value /= base;
+        }
+        while (value);
+
+        while (n)
+            put(digits[--n]);
+    }
+
+    void put_signed(long long value)
+    {
+        if (value < 0)
+        {
+            put('-');
+            put_unsigned(0ull - static_cast<unsigned long long>(value), 10);
+        }
+        else
+        {
+            put_unsigned(value, 10);
+        }
+    }
+
+    // Fixed three decimals, which is what the daemon's formats mostly use
+    void put_double(double value)
+    {
+        if (value != value)
+        {
+            put("nan");
+            return;
+        }
+
+        if (value < 0)
+        {
+            put('-');
+            value = -value;
+        }
+
+        if (value >= 1e18)
+        {
+            put("inf");
+            return;
+        }
+
+        auto whole = static_cast<unsigned long long>(value);
+        auto millis = static_cast<unsigned long long>((value - whole) * 1000.0 + 0.5);
+        if (millis >= 1000)
+        {
+            ++whole;
+            millis -= 1000;
+        }
+
+        put_unsigned(whole, 10);
+        put('.');
+        put(static_cast<char>('0' + millis / 100));
+        put(static_cast<char>('0' + millis / 10 % 10));
+        put(static_cast<char>('0' + millis % 10));
+    }
+
+    void end_line()
+    {
+        line[size++] = '\n';
+        if (::write(fd, line, size)) {}
+        size = 0;
+    }
+
+private:
+    int const fd;
+    char line[512];
+    size_t size;
+};
+
+// Like format_record(), but async-signal-safe. Flags, width and precision
+// are ignored.
+void write_record_for_crash(
+    CrashLineWriter& writer, repowerd::RingBufferLog::Record const& record)
+{
+    PayloadReader reader{record};
+
+    writer.put(repowerd::log_level_to_string(record.level));
+    writer.put(' ');
+    writer.put(record.tag);
+    writer.put(": ");
+
+    auto p = record.format;
+
+    while (*p)
+    {
+        if (*p != '%')
+        {
+            writer.put(*p++);
+            continue;
+        }
+
+        auto const spec = parse_spec(p + 1);
+        p = spec.end;
+
+        auto const c = spec.conversion;
+        auto ok = true;
+
+        for (int i = 0; i < spec.num_stars && ok; ++i)
+        {
+            long long star{0};
+            ok = reader.get(star);
+        }
+
+        if (c == '%')
+        {
+            writer.put('%');
+        }
+        else if (is_signed_conversion(c) && ok)
+        {
+            long long v{0};
+            if ((ok = reader.get(v)))
+                writer.put_signed(v);
+        }
+        else if (is_unsigned_conversion(c) && ok)
+        {
+            unsigned long long v{0};
+            if ((ok = reader.get(v)))
+            {
+                if (c == 'c')
+                    writer.put(static_cast<char>(v));
+                else if (c == 'x' || c == 'X')
+                    writer.put_unsigned(v, 16);
+                else if (c == 'o')
+                    writer.put_unsigned(v, 8);
+                else
+                    writer.put_unsigned(v, 10);
+            }
+        }
+        else if (is_floating_conversion(c) && ok)
+        {
+            double v{0};
+            if ((ok = reader.get(v)))
+                writer.put_double(v);
+        }
+        else if (c == 's' && ok)
+        {
+            char const* v{""};
+            if ((ok = reader.get_string(v)))
+                writer.put(v);
+        }
+        else if (c == 'p' && ok)
+        {
+            void* v{nullptr};
+            if ((ok = reader.get(v)))
+            {
+                writer.put("0x");
+                writer.put_unsigned(reinterpret_cast<uintptr_t>(v), 16);
+            }
+        }
+
+        if (!ok)
+        {
+            writer.put("<truncated>");
+            break;
+        }
+    }
+
+    writer.end_line();
+}
+
+}
+
+repowerd::RingBufferLog::RingBufferLog(
+    std::shared_ptr<Log> const& sink,
+    size_t records_per_thread,
+    std::chrono::milliseconds flush_interval,
+    SignalHandling signal_handling)
+    : sink{sink},
+      records_per_thread{std::max<size_t>(records_per_thread, 1)},
+      flush_interval{flush_interval},
+      signal_handling{signal_handling},
+      instance_id{next_instance_id++},
+      crash_buffers{},
+      crashing{false},
+      drain_now{false},
+      running{true}
+{
+    if (pipe2(wakeup_pipe, O_CLOEXEC | O_NONBLOCK) < 0)
+        throw std::system_error{errno, std::system_category(), "Failed to create log wakeup pipe"};
+
+    if (signal_handling == SignalHandling::install)
+    {
+        signal_instance = this;
+
+        struct sigaction drain_action{};
+        drain_action.sa_handler = handle_drain_signal;
+        drain_action.sa_flags = SA_RESTART;
+        sigemptyset(&drain_action.sa_mask);
+        sigaction(SIGUSR1, &drain_action, &old_sigusr1_action);
+
+        struct sigaction crash_action{};
+        crash_action.sa_handler = handle_crash_signal;
+        crash_action.sa_flags = SA_RESETHAND;
+        sigemptyset(&crash_action.sa_mask);
+        for (auto i = 0u; i < sizeof(crash_signals)/sizeof(crash_signals[0]); ++i)
+            sigaction(crash_signals[i], &crash_action, &old_crash_actions[i]);
+    }
+
+    flusher = std::thread{[this] { flusher_loop(); }};
+}
+
+repowerd::RingBufferLog::~RingBufferLog()
+{
+    if (signal_handling == SignalHandling::install)
+    {
+        sigaction(SIGUSR1, &old_sigusr1_action, nullptr);
+        for (auto i = 0u; i < sizeof(crash_signals)/sizeof(crash_signals[0]); ++i)
+            sigaction(crash_signals[i], &old_crash_actions[i], nullptr);
+        signal_instance = nullptr;
+    }
+
+    running = false;
+    request_drain();
+    flusher.join();
+
+    drain();
+
+    close(wakeup_pipe[0]);
+    close(wakeup_pipe[1]);
+}
+
+void repowerd::RingBufferLog::vlog(
+    LogLevel level, char const* tag, char const* format, va_list ap)
+{
+    auto& buffer = thread_buffer();
+
+    auto const head = buffer.head.load(std::memory_order_relaxed);
+    auto const tail = buffer.tail.load(std::memory_order_acquire);
+    if (head - tail >= buffer.capacity)
+    {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto& record = *new (&buffer.slot(head)) Record;
+    record.time = std::chrono::steady_clock::now();
+    record.level = level;
+    copy_tag(record, tag);
+    record.format = format;
+
+    capture_args(record, ap);
+
+    buffer.head.store(head + 1, std::memory_order_release);
+
+    // Only wake the flusher when the ring goes from empty to non-empty, so
+    // that an idle daemon doesn't wake up periodically to drain nothing
+    if (head == tail)
+        request_drain();
+}
+
+void repowerd::RingBufferLog::drain()
+{
+    std::lock_guard<std::mutex> drain_lock{drain_mutex};
+
+    std::vector<std::shared_ptr<ThreadBuffer>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock{buffers_mutex};
+        snapshot = buffers;
+    }
+
+    std::vector<Record> records;
+
+    for (auto const& buffer : snapshot)
+    {
+        auto const tail = buffer->tail.load(std::memory_order_relaxed);
+        auto const head = buffer->head.load(std::memory_order_acquire);
+
+        for (auto i = tail; i != head; ++i)
+            records.push_back(buffer->slot(i));
+
+        buffer->tail.store(head, std::memory_order_release);
+
+        if (auto const dropped = buffer->dropped.exchange(0, std::memory_order_relaxed))
+        {
+            sink->write(LogLevel::warning, log_tag, "Dropped %llu log records, buffer full",
+                        static_cast<unsigned long long>(dropped));
+        }
+    }
+
+    std::stable_sort(records.begin(), records.end(),
+                     [] (auto const& a, auto const& b) { return a.time < b.time; });
+
+    for (auto const& record : records)
+        sink->write(record.level, record.tag, "%s", format_record(record).c_str());
+
+    // Forget the buffers of threads that have exited. An exited thread
+    // no longer holds a reference to its buffer in its thread_local
+    // cache, so once our snapshot is gone the list holds the only one.
+    snapshot.clear();
+
+    std::lock_guard<std::mutex> lock{buffers_mutex};
+
+    auto const exited = std::partition(
+        buffers.begin(), buffers.end(),
+        [] (auto const& b)
+        {
+            return b.use_count() > 1 || b->head.load() != b->tail.load();
+        });
+
+    for (auto iter = exited; iter != buffers.end(); ++iter)
+        unpublish_for_crash(iter->get());
+
+    // The crash handler may be reading an unpublished buffer, so leak it
+    if (crashing.load())
+        return;
+
+    buffers.erase(exited, buffers.end());
+}
+
+repowerd::RingBufferLog::ThreadBuffer& repowerd::RingBufferLog::thread_buffer()
+{
+    if (thread_buffer_cache.instance_id == instance_id)
+        return *thread_buffer_cache.buffer;
+
+    std::lock_guard<std::mutex> lock{buffers_mutex};
+
+    auto const iter = std::find_if(
+        buffers.begin(), buffers.end(),
+        [] (auto const& b) { return b->owner == std::this_thread::get_id(); });
+
+    if (iter != buffers.end())
+    {
+        thread_buffer_cache = {instance_id, *iter};
+    }
+    else
+    {
+        buffers.push_back(std::make_shared<ThreadBuffer>(records_per_thread));
+        thread_buffer_cache = {instance_id, buffers.back()};
+        publish_for_crash(buffers.back().get());
+    }
+
+    return *thread_buffer_cache.buffer;
+}
+
+size_t repowerd::RingBufferLog::num_thread_buffers()
+{
+    std::lock_guard<std::mutex> lock{buffers_mutex};
+    return buffers.size();
+}
+
+bool repowerd::RingBufferLog::has_pending_records()
+{
+    // Orders the tail stores of the preceding drain before the head loads,
+    // so that a record whose writer saw a non-empty ring, and therefore
+    // didn't wake us, is seen here
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    std::lock_guard<std::mutex> lock{buffers_mutex};
+
+    return std::any_of(
+        buffers.begin(), buffers.end(),
+        [] (auto const& b)
+        {
+            return b->head.load(std::memory_order_acquire) !=
+                   b->tail.load(std::memory_order_relaxed);
+        });
+}
+
+void repowerd::RingBufferLog::wait_for_wakeup(std::chrono::milliseconds timeout)
+{
+    auto const timeout_ms = timeout < std::chrono::milliseconds::zero() ? -1 :
+        static_cast<int>(std::min<std::chrono::milliseconds::rep>(timeout.count(), INT_MAX));
+
+    pollfd pfd{wakeup_pipe[0], POLLIN, 0};
+    poll(&pfd, 1, timeout_ms);
+
+    char buf[64];
+    while (read(wakeup_pipe[0], buf, sizeof(buf)) > 0) {}
+}
+
+void repowerd::RingBufferLog::flusher_loop()
+{
+    while (running)
+    {
+        // Sleep until something is logged...
+        if (!has_pending_records())
+            wait_for_wakeup(std::chrono::milliseconds{-1});
+
+        // ...then let more lines accumulate for the flush interval, unless
+        // a drain is requested explicitly
+        auto const deadline = std::chrono::steady_clock::now() + flush_interval;
+
+        while (running && !drain_now.exchange(false))
+        {
+            auto const remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            if (remaining <= std::chrono::milliseconds::zero())
+                break;
+            wait_for_wakeup(remaining);
+        }
+
+        drain();
+    }
+}
+
+void repowerd::RingBufferLog::request_drain()
+{
+    char const c{0};
+    if (::write(wakeup_pipe[1], &c, 1)) {}
+}
+
+void repowerd::RingBufferLog::handle_drain_signal(int)
+{
+    if (auto const instance = signal_instance.load())
+    {
+        instance->drain_now = true;
+        instance->request_drain();
+    }
+}
+
+void repowerd::RingBufferLog::publish_for_crash(ThreadBuffer* buffer)
+{
+    for (auto& slot : crash_buffers)
+    {
+        ThreadBuffer* expected{nullptr};
+        if (slot.compare_exchange_strong(expected, buffer))
+            return;
+    }
+}
+
+void repowerd::RingBufferLog::unpublish_for_crash(ThreadBuffer* buffer)
+{
+    for (auto& slot : crash_buffers)
+    {
+        ThreadBuffer* expected{buffer};
+        if (slot.compare_exchange_strong(expected, nullptr))
+            return;
+    }
+}
+
+void repowerd::RingBufferLog::write_out_for_crash(int fd)
+{
+    // Set before reading the published buffers, so that a concurrent drain
+    // which unpublishes a buffer we are about to read doesn't free it
+    crashing.store(true);
+
+    ThreadBuffer* crash_snapshot[max_crash_buffers];
+    uint64_t cursors[max_crash_buffers];
+    uint64_t ends[max_crash_buffers];
+    int num_buffers = 0;
+
+    for (auto& slot : crash_buffers)
+    {
+        auto const buffer = slot.load();
+        if (!buffer)
+            continue;
+
+        auto const tail = buffer->tail.load(std::memory_order_acquire);
+        auto const head = buffer->head.load(std::memory_order_acquire);
+
+        crash_snapshot[num_buffers] = buffer;
+        ends[num_buffers] = head;
+        cursors[num_buffers] = head - tail > buffer->capacity ? head - buffer->capacity : tail;
+        ++num_buffers;
+    }
+
+    CrashLineWriter writer{fd};
+    writer.put(log_tag);
+    writer.put(": Crashed, writing out unflushed log lines");
+    writer.end_line();
+
+    // Merge the buffers in time order without allocating
+    for (;;)
+    {
+        int next = -1;
+        for (int i = 0; i < num_buffers; ++i)
+        {
+            if (cursors[i] != ends[i] &&
+                (next < 0 ||
+                 crash_snapshot[i]->slot(cursors[i]).time <
+                     crash_snapshot[next]->slot(cursors[next]).time))
+            {
+                next = i;
+            }
+        }
+
+        if (next < 0)
+            break;
+
+        write_record_for_crash(writer, crash_snapshot[next]->slot(cursors[next]++));
+    }
+}
+
+void repowerd::RingBufferLog::handle_crash_signal(int sig)
+{
+    // Only async-signal-safe operations from here on: the crash may have
+    // happened inside malloc or with the sink's locks held
+    if (auto const instance = signal_instance.load())
+        instance->write_out_for_crash(STDERR_FILENO);
+
+    raise(sig);
+}
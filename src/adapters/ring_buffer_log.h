@@ -0,0 +1,102 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "src/core/log.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace repowerd
+{
+
+// A Log that only records the tag, the format and the raw arguments of
+// each call into a lock-free ring buffer owned by the calling thread.
+// Formatting happens when the buffers are drained into the sink: from a
+// background flusher, flush_interval after a ring stops being empty, or on
+// SIGUSR1. The flusher sleeps while nothing is logged. On a crash the
+// undrained lines are written to stderr with async-signal-safe code
+// instead. Formats must have static storage duration, which string
+// literals do; tags and string arguments are copied.
+class RingBufferLog : public Log
+{
+public:
+    enum class SignalHandling { none, install };
+
+    RingBufferLog(
+        std::shared_ptr<Log> const& sink,
+        size_t records_per_thread,
+        std::chrono::milliseconds flush_interval,
+        SignalHandling signal_handling);
+    ~RingBufferLog();
+
+    // Formats and writes out all recorded lines, in time order
+    void drain();
+
+    // Writes the undrained lines to fd using only async-signal-safe calls,
+    // as done on a crash. Doesn't consume them.
+    void write_out_for_crash(int fd);
+
+    // For testing only
+    size_t num_thread_buffers();
+
+    struct Record;
+    struct ThreadBuffer;
+
+protected:
+    void vlog(LogLevel level, char const* tag, char const* format, va_list ap) override;
+
+private:
+    ThreadBuffer& thread_buffer();
+    void publish_for_crash(ThreadBuffer* buffer);
+    void unpublish_for_crash(ThreadBuffer* buffer);
+    bool has_pending_records();
+    void wait_for_wakeup(std::chrono::milliseconds timeout);
+    void flusher_loop();
+    void request_drain();
+    static void handle_drain_signal(int sig);
+    static void handle_crash_signal(int sig);
+
+    std::shared_ptr<Log> const sink;
+    size_t const records_per_thread;
+    std::chrono::milliseconds const flush_interval;
+    SignalHandling const signal_handling;
+    uint64_t const instance_id;
+
+    std::mutex buffers_mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+    std::mutex drain_mutex;
+
+    // Buffers readable by the crash handler, which can't take locks
+    static int constexpr max_crash_buffers{64};
+    std::array<std::atomic<ThreadBuffer*>, max_crash_buffers> crash_buffers;
+    std::atomic<bool> crashing;
+
+    int wakeup_pipe[2];
+    std::atomic<bool> drain_now;
+    std::atomic<bool> running;
+    std::thread flusher;
+};
+
+}
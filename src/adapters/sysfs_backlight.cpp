@@ -24,10 +24,13 @@
 
 #include <algorithm>
 #include <cmath>
-#include <fstream>
+#include <cstdlib>
 #include <stdexcept>
+#include <system_error>
 #include <vector>
 
+#include <fcntl.h>
+
 namespace
 {
 char const* const log_tag = "SysfsBacklight";
@@ -98,6 +101,20 @@ int determine_max_brightness(
     return max_brightness;
 }
 
+repowerd::Fd open_brightness_file(
+    repowerd::Filesystem& filesystem, repowerd::Path const& brightness_file)
+{
+    auto fd = filesystem.open(
+        std::string{brightness_file}.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::system_error{
+            errno, std::system_category(),
+            "Failed to open " + std::string{brightness_file}};
+    }
+    return fd;
+}
+
 }
 
 repowerd::SysfsBacklight::SysfsBacklight(
@@ -107,7 +124,9 @@ repowerd::SysfsBacklight::SysfsBacklight(
       sysfs_backlight_dir{determine_sysfs_backlight_dir(*filesystem)},
       sysfs_brightness_file{sysfs_backlight_dir/"brightness"},
       max_brightness{determine_max_brightness(*filesystem, sysfs_backlight_dir)},
-      last_set_brightness{-1.0}
+      brightness_fd{open_brightness_file(*filesystem, sysfs_brightness_file)},
+      last_set_brightness{-1.0},
+      last_written_abs_brightness{-1}
 {
     log->log(log_tag, "Using backlight %s",
              std::string{sysfs_backlight_dir}.c_str());
@@ -115,25 +134,69 @@ repowerd::SysfsBacklight::SysfsBacklight(
 
 void repowerd::SysfsBacklight::set_brightness(double value)
 {
-    auto ostream = filesystem->ostream(sysfs_brightness_file);
-    *ostream << absolute_brightness_for(value);
-    ostream->flush();
+    auto const abs_brightness = absolute_brightness_for(value);
+
+    if (abs_brightness != last_written_abs_brightness)
+        write_absolute_brightness(abs_brightness);
+
     last_set_brightness = value;
 }
 
 double repowerd::SysfsBacklight::get_brightness()
 {
-    auto istream = filesystem->istream(sysfs_brightness_file);
-    int abs_brightness = 0;
-    *istream >> abs_brightness;
+    auto const abs_brightness = read_absolute_brightness();
 
-    if (absolute_brightness_for(last_set_brightness) == abs_brightness)
+    if (abs_brightness == last_written_abs_brightness &&
+        absolute_brightness_for(last_set_brightness) == abs_brightness)
+    {
         return last_set_brightness;
-    else
-        return static_cast<double>(abs_brightness) / max_brightness;
+    }
+
+    // The brightness was changed externally, so our cached value is stale
+    last_written_abs_brightness = abs_brightness;
+    return static_cast<double>(abs_brightness) / max_brightness;
+}
+
+int repowerd::SysfsBacklight::num_brightness_levels()
+{
+    return max_brightness;
 }
 
 int repowerd::SysfsBacklight::absolute_brightness_for(double rel_brightness)
 {
     return static_cast<int>(round(rel_brightness * max_brightness));
 }
+
+int repowerd::SysfsBacklight::read_absolute_brightness()
+{
+    char buf[16];
+    auto const n = filesystem->pread(brightness_fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0)
+        return 0;
+
+    buf[n] = '\0';
+    return strtol(buf, nullptr, 10);
+}
+
+void repowerd::SysfsBacklight::write_absolute_brightness(int abs_brightness)
+{
+    // Format the value by hand into a fixed buffer; this runs for every
+    // step of a brightness transition
+    char buf[16];
+    auto end = buf + sizeof(buf);
+    auto begin = end;
+    auto value = static_cast<unsigned int>(std::max(abs_brightness, 0));
+
+    do
+    {
+        *--begin = '0' + value % 10;
+        value /= 10;
+    }
+    while (value);
+
+    if (filesystem->pwrite(brightness_fd, begin, end - begin, 0) == end - begin)
+        last_written_abs_brightness = abs_brightness;
+    else
+        // The file contents are unknown, so don't skip the next write
+        last_written_abs_brightness = -1;
+}
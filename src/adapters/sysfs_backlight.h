@@ -20,6 +20,7 @@
 
 #include "backlight.h"
 
+#include "fd.h"
 #include "path.h"
 
 #include <memory>
@@ -30,6 +31,8 @@ namespace repowerd
 class Log;
 class Filesystem;
 
+// Keeps the brightness file open and only writes to it when the absolute
+// brightness value changes, since transitions set it many times in a row
 class SysfsBacklight : public Backlight
 {
 public:
@@ -39,15 +42,21 @@ public:
 
     void set_brightness(double) override;
     double get_brightness() override;
+    int num_brightness_levels() override;
 
 private:
     int absolute_brightness_for(double relative_brightness);
+    int read_absolute_brightness();
+    void write_absolute_brightness(int abs_brightness);
 
     std::shared_ptr<Filesystem> const filesystem;
     Path const sysfs_backlight_dir;
     Path const sysfs_brightness_file;
     int const max_brightness;
+    Fd const brightness_fd;
     double last_set_brightness;
+    // Negative while the file contents are unknown
+    int last_written_abs_brightness;
 };
 
 }
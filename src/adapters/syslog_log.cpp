@@ -23,6 +23,22 @@
 
 #include <syslog.h>
 
+namespace
+{
+
+int syslog_priority(repowerd::LogLevel level)
+{
+    switch (level)
+    {
+    case repowerd::LogLevel::error: return LOG_ERR;
+    case repowerd::LogLevel::warning: return LOG_WARNING;
+    case repowerd::LogLevel::info: return LOG_INFO;
+    default: return LOG_DEBUG;
+    }
+}
+
+}
+
 repowerd::SyslogLog::SyslogLog()
 {
     openlog("repowerd", LOG_PID, LOG_DAEMON);
@@ -33,14 +49,10 @@ repowerd::SyslogLog::~SyslogLog()
     closelog();
 }
 
-void repowerd::SyslogLog::log(char const* tag, char const* format, ...)
+void repowerd::SyslogLog::vlog(
+    LogLevel level, char const* tag, char const* format, va_list ap)
 {
     std::string const format_str = std::string{tag} + ": " + format;
 
-    va_list ap;
-    va_start(ap, format);
-
-    vsyslog(LOG_DEBUG, format_str.c_str(), ap);
-
-    va_end(ap);
+    vsyslog(syslog_priority(level), format_str.c_str(), ap);
 }
@@ -29,7 +29,8 @@ public:
     SyslogLog();
     ~SyslogLog();
 
-    void log(char const* tag, char const* format, ...) override;
+protected:
+    void vlog(LogLevel level, char const* tag, char const* format, va_list ap) override;
 };
 
 }
@@ -0,0 +1,286 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "timer_wheel.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+
+uint64_t const no_tick{std::numeric_limits<uint64_t>::max()};
+
+uint64_t floor_ms(std::chrono::steady_clock::duration d)
+{
+    if (d <= d.zero()) return 0;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+}
+
+uint64_t ceil_ms(std::chrono::steady_clock::duration d)
+{
+    if (d <= d.zero()) return 0;
+    auto const ms = std::chrono::duration_cast<std::chrono::milliseconds>(d);
+    return ms.count() + (ms < d ? 1 : 0);
+}
+
+// Rotates the occupancy bitmap so that bit 0 corresponds to the slot after
+// 'slot', and returns the distance to the first occupied slot (1-64), or 0
+uint64_t distance_to_next_occupied(uint64_t occupied, uint64_t slot)
+{
+    if (!occupied) return 0;
+
+    auto const shift = (slot + 1) & 63;
+    auto const rotated = shift ? (occupied >> shift) | (occupied << (64 - shift)) : occupied;
+
+    return __builtin_ctzll(rotated) + 1;
+}
+
+}
+
+repowerd::TimerWheel::TimerWheel(time_point start)
+    : start{start},
+      current_tick{0},
+      free_head{nil}
+{
+    for (auto& level : levels)
+    {
+        level.slots.fill(Slot{nil, nil});
+        level.occupied = 0;
+    }
+}
+
+void repowerd::TimerWheel::add(AlarmId id, time_point deadline)
+{
+    auto const expiry_tick = expiry_tick_for(deadline);
+
+    uint32_t index;
+    if (free_head != nil)
+    {
+        index = free_head;
+        free_head = entries[index].next;
+    }
+    else
+    {
+        index = entries.size();
+        entries.emplace_back();
+    }
+
+    entries[index].id = id;
+    entries[index].expiry_tick = expiry_tick;
+    entries[index].deadline_tick = expiry_tick;
+    index_of[id] = index;
+
+    insert(index);
+}
+
+bool repowerd::TimerWheel::remove(AlarmId id)
+{
+    auto const iter = index_of.find(id);
+    if (iter == index_of.end())
+        return false;
+
+    auto const index = iter->second;
+    index_of.erase(iter);
+
+    unlink(index);
+    entries[index].next = free_head;
+    free_head = index;
+
+    return true;
+}
+
+bool repowerd::TimerWheel::extend(AlarmId id, time_point deadline)
+{
+    auto const iter = index_of.find(id);
+    if (iter == index_of.end())
+        return false;
+
+    auto const index = iter->second;
+    auto& entry = entries[index];
+    auto const deadline_tick = expiry_tick_for(deadline);
+
+    entry.deadline_tick = deadline_tick;
+
+    if (deadline_tick < entry.expiry_tick)
+    {
+        unlink(index);
+        entry.expiry_tick = deadline_tick;
+        insert(index);
+    }
+
+    return true;
+}
+
+void repowerd::TimerWheel::advance(time_point now, std::vector<AlarmId>& expired)
+{
+    auto const target_tick = floor_ms(now - start);
+
+    while (current_tick < target_tick)
+    {
+        auto const next_tick = next_event_tick();
+        if (next_tick > target_tick)
+        {
+            current_tick = target_tick;
+            break;
+        }
+
+        current_tick = next_tick;
+
+        for (int level = num_levels - 1; level > 0; --level)
+        {
+            auto const level_mask = (uint64_t{1} << (slot_bits * level)) - 1;
+            if ((current_tick & level_mask) == 0)
+                cascade(level);
+        }
+
+        expire_current_tick(expired);
+    }
+}
+
+repowerd::TimerWheel::time_point repowerd::TimerWheel::next_event() const
+{
+    auto const tick = next_event_tick();
+    if (tick == no_tick)
+        return time_point::max();
+
+    return start + std::chrono::milliseconds{tick};
+}
+
+size_t repowerd::TimerWheel::size() const
+{
+    return index_of.size();
+}
+
+uint64_t repowerd::TimerWheel::expiry_tick_for(time_point deadline) const
+{
+    return std::max(ceil_ms(deadline - start), current_tick + 1);
+}
+
+uint64_t repowerd::TimerWheel::next_event_tick() const
+{
+    auto next_tick = no_tick;
+
+    for (int level = 0; level < num_levels; ++level)
+    {
+        auto const shift = slot_bits * level;
+        auto const base = current_tick >> shift;
+        auto const distance = distance_to_next_occupied(
+            levels[level].occupied, base & (num_slots - 1));
+
+        if (distance)
+            next_tick = std::min(next_tick, (base + distance) << shift);
+    }
+
+    return next_tick;
+}
+
+void repowerd::TimerWheel::insert(uint32_t index)
+{
+    auto& entry = entries[index];
+    auto const delta = entry.expiry_tick - current_tick;
+
+    int level = 0;
+    while (level < num_levels - 1 && delta >= (uint64_t{1} << (slot_bits * (level + 1))))
+        ++level;
+
+    // Alarms beyond the range of the wheel wait in the last slot of the
+    // coarsest level, and are placed again when that slot is cascaded
+    auto const max_delta = (uint64_t{1} << (slot_bits * num_levels)) - 1;
+    auto const tick = current_tick + std::min(delta, max_delta);
+    auto const slot_index = (tick >> (slot_bits * level)) & (num_slots - 1);
+
+    auto& slot = levels[level].slots[slot_index];
+
+    entry.level = level;
+    entry.slot = slot_index;
+    entry.prev = slot.tail;
+    entry.next = nil;
+
+    if (slot.tail != nil)
+        entries[slot.tail].next = index;
+    else
+        slot.head = index;
+    slot.tail = index;
+
+    levels[level].occupied |= uint64_t{1} << slot_index;
+}
+
+void repowerd::TimerWheel::unlink(uint32_t index)
+{
+    auto const& entry = entries[index];
+    auto& level = levels[entry.level];
+    auto& slot = level.slots[entry.slot];
+
+    if (entry.prev != nil)
+        entries[entry.prev].next = entry.next;
+    else
+        slot.head = entry.next;
+
+    if (entry.next != nil)
+        entries[entry.next].prev = entry.prev;
+    else
+        slot.tail = entry.prev;
+
+    if (slot.head == nil)
+        level.occupied &= ~(uint64_t{1} << entry.slot);
+}
+
+void repowerd::TimerWheel::cascade(int level)
+{
+    auto const slot_index = (current_tick >> (slot_bits * level)) & (num_slots - 1);
+    auto& slot = levels[level].slots[slot_index];
+
+    auto index = slot.head;
+    slot = Slot{nil, nil};
+    levels[level].occupied &= ~(uint64_t{1} << slot_index);
+
+    while (index != nil)
+    {
+        auto const next = entries[index].next;
+        entries[index].expiry_tick = entries[index].deadline_tick;
+        insert(index);
+        index = next;
+    }
+}
+
+void repowerd::TimerWheel::expire_current_tick(std::vector<AlarmId>& expired)
+{
+    auto& slot = levels[0].slots[current_tick & (num_slots - 1)];
+
+    while (slot.head != nil)
+    {
+        auto const index = slot.head;
+        auto const id = entries[index].id;
+
+        unlink(index);
+
+        // Extended alarms are placed again instead of expiring
+        if (entries[index].deadline_tick > current_tick)
+        {
+            entries[index].expiry_tick = entries[index].deadline_tick;
+            insert(index);
+            continue;
+        }
+
+        index_of.erase(id);
+        entries[index].next = free_head;
+        free_head = index;
+
+        expired.push_back(id);
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "src/core/alarm_id.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace repowerd
+{
+
+// Hierarchical timing wheel with millisecond ticks. Adding and removing
+// alarms is O(1); alarms further in the future live in coarser levels and
+// are cascaded towards level 0 as time advances. Not thread-safe.
+class TimerWheel
+{
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    TimerWheel(time_point start);
+
+    void add(AlarmId id, time_point deadline);
+    bool remove(AlarmId id);
+    // Moves the deadline of a pending alarm. Moving it later only records
+    // the new deadline; the alarm is re-placed when its old slot comes due.
+    bool extend(AlarmId id, time_point deadline);
+
+    // Processes all ticks up to now, appending alarms that have expired to
+    // expired in deadline order
+    void advance(time_point now, std::vector<AlarmId>& expired);
+
+    // The next time at which advance() has work to do, either expiring
+    // alarms or cascading them to a finer level. time_point::max() if empty.
+    time_point next_event() const;
+
+    size_t size() const;
+
+private:
+    static int constexpr num_levels{4};
+    static int constexpr slot_bits{6};
+    static int constexpr num_slots{1 << slot_bits};
+    static uint32_t constexpr nil{UINT32_MAX};
+
+    struct Entry
+    {
+        AlarmId id;
+        uint64_t expiry_tick;
+        uint64_t deadline_tick;
+        uint32_t prev;
+        uint32_t next;
+        uint8_t level;
+        uint8_t slot;
+    };
+
+    struct Slot
+    {
+        uint32_t head;
+        uint32_t tail;
+    };
+
+    struct Level
+    {
+        std::array<Slot, num_slots> slots;
+        uint64_t occupied;
+    };
+
+    uint64_t expiry_tick_for(time_point deadline) const;
+    uint64_t next_event_tick() const;
+    void insert(uint32_t index);
+    void unlink(uint32_t index);
+    void cascade(int level);
+    void expire_current_tick(std::vector<AlarmId>& expired);
+
+    time_point const start;
+    uint64_t current_tick;
+    std::array<Level, num_levels> levels;
+    std::vector<Entry> entries;
+    uint32_t free_head;
+    std::unordered_map<AlarmId, uint32_t> index_of;
+};
+
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "timer_wheel_timer.h"
+#include "event_loop_handler_registration.h"
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <system_error>
+
+namespace
+{
+
+auto const null_handler = [](auto){};
+
+timespec to_timespec(std::chrono::steady_clock::time_point const& tp)
+{
+    auto d = tp.time_since_epoch();
+    auto const sec = std::chrono::duration_cast<std::chrono::seconds>(d);
+
+    timespec ts;
+    ts.tv_sec = sec.count();
+    ts.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(d - sec).count();
+
+    return ts;
+}
+
+}
+
+repowerd::TimerWheelTimer::TimerWheelTimer()
+    : timerfd_fd{timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK)},
+      alarm_handler{null_handler},
+      wheel{std::chrono::steady_clock::now()},
+      armed_at{std::chrono::steady_clock::time_point::max()},
+      next_alarm_id{1},
+      event_loop{"Timer"}
+{
+    if (timerfd_fd == -1)
+        throw std::system_error{errno, std::system_category(), "Failed to create timerfd"};
+
+    event_loop.watch_fd(timerfd_fd, [this] { handle_timerfd(); });
+}
+
+repowerd::TimerWheelTimer::~TimerWheelTimer()
+{
+    event_loop.stop();
+}
+
+repowerd::HandlerRegistration repowerd::TimerWheelTimer::register_alarm_handler(
+    AlarmHandler const& handler)
+{
+    return EventLoopHandlerRegistration{
+        event_loop,
+        [this, &handler] { alarm_handler = handler; },
+        [this] { alarm_handler = null_handler; }};
+}
+
+repowerd::AlarmId repowerd::TimerWheelTimer::schedule_alarm_in(
+    std::chrono::milliseconds t)
+{
+    auto const deadline = now() + t;
+
+    std::lock_guard<std::mutex> lock{wheel_mutex};
+
+    auto const alarm_id = next_alarm_id++;
+    wheel.add(alarm_id, deadline);
+
+    auto const next_event = wheel.next_event();
+    if (next_event < armed_at)
+        arm_timerfd(next_event);
+
+    return alarm_id;
+}
+
+void repowerd::TimerWheelTimer::cancel_alarm(AlarmId id)
+{
+    // The timerfd is left armed; an early wakeup just finds nothing to do
+    std::lock_guard<std::mutex> lock{wheel_mutex};
+    wheel.remove(id);
+}
+
+bool repowerd::TimerWheelTimer::extend_alarm_in(
+    AlarmId id, std::chrono::milliseconds t)
+{
+    auto const deadline = now() + t;
+
+    std::lock_guard<std::mutex> lock{wheel_mutex};
+
+    if (!wheel.extend(id, deadline))
+        return false;
+
+    auto const next_event = wheel.next_event();
+    if (next_event < armed_at)
+        arm_timerfd(next_event);
+
+    return true;
+}
+
+std::chrono::steady_clock::time_point repowerd::TimerWheelTimer::now()
+{
+    return std::chrono::steady_clock::now();
+}
+
+void repowerd::TimerWheelTimer::handle_timerfd()
+{
+    uint64_t expirations;
+    if (read(timerfd_fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock{wheel_mutex};
+
+        expired.clear();
+        wheel.advance(now(), expired);
+
+        armed_at = std::chrono::steady_clock::time_point::max();
+        auto const next_event = wheel.next_event();
+        if (next_event != std::chrono::steady_clock::time_point::max())
+            arm_timerfd(next_event);
+    }
+
+    // expired is only touched from within event_loop, so it's safe to use
+    // it without the lock
+    for (auto const id : expired)
+        alarm_handler(id);
+}
+
+void repowerd::TimerWheelTimer::arm_timerfd(std::chrono::steady_clock::time_point tp)
+{
+    timespec const interval{0,0};
+    itimerspec const spec{interval, to_timespec(tp)};
+
+    timerfd_settime(timerfd_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    armed_at = tp;
+}
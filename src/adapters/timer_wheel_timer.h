@@ -0,0 +1,62 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "src/core/timer.h"
+#include "event_loop.h"
+#include "fd.h"
+#include "timer_wheel.h"
+
+#include <mutex>
+#include <vector>
+
+namespace repowerd
+{
+
+// Timer backed by a TimerWheel and a single timerfd. Scheduling and
+// cancelling alarms are O(1) and never wait for the timer thread. Extending
+// an alarm's deadline only touches the timerfd if the deadline moves earlier.
+class TimerWheelTimer : public Timer
+{
+public:
+    TimerWheelTimer();
+    ~TimerWheelTimer();
+
+    HandlerRegistration register_alarm_handler(AlarmHandler const& handler) override;
+    AlarmId schedule_alarm_in(std::chrono::milliseconds t) override;
+    void cancel_alarm(AlarmId id) override;
+    bool extend_alarm_in(AlarmId id, std::chrono::milliseconds t) override;
+    std::chrono::steady_clock::time_point now() override;
+
+private:
+    void handle_timerfd();
+    void arm_timerfd(std::chrono::steady_clock::time_point tp);
+
+    Fd timerfd_fd;
+    AlarmHandler alarm_handler;
+
+    std::mutex wheel_mutex;
+    TimerWheel wheel;
+    std::chrono::steady_clock::time_point armed_at;
+    AlarmId next_alarm_id;
+    std::vector<AlarmId> expired;
+
+    EventLoop event_loop;
+};
+
+}
@@ -18,14 +18,23 @@
 
 #include "timerfd_wakeup_service.h"
 #include "event_loop_handler_registration.h"
+#include "wakeup_resume_cause.h"
+
+#include "src/core/event_latency.h"
+#include "src/core/log.h"
 
 #include <sys/timerfd.h>
+#include <time.h>
 
 #include <system_error>
 
 namespace
 {
 
+char const* const log_tag = "TimerfdWakeupService";
+// Ignores jitter between reading the two clocks in suspend_offset()
+auto const min_suspend_duration = std::chrono::milliseconds{100};
+
 auto null_handler = [](auto){};
 
 timespec to_timespec(std::chrono::system_clock::time_point const& tp)
@@ -40,30 +49,62 @@ timespec to_timespec(std::chrono::system_clock::time_point const& tp)
     return ts;
 }
 
+// CLOCK_BOOTTIME advances during suspend while CLOCK_MONOTONIC doesn't, so
+// the difference grows by the time spent suspended
+std::chrono::nanoseconds suspend_offset()
+{
+    timespec boottime;
+    timespec monotonic;
+    clock_gettime(CLOCK_BOOTTIME, &boottime);
+    clock_gettime(CLOCK_MONOTONIC, &monotonic);
+
+    return std::chrono::seconds{boottime.tv_sec - monotonic.tv_sec} +
+           std::chrono::nanoseconds{boottime.tv_nsec - monotonic.tv_nsec};
+}
+
+long long to_ms(std::chrono::nanoseconds d)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+}
+
 }
 
-repowerd::TimerfdWakeupService::TimerfdWakeupService()
-    : timerfd_fd{timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC)},
-      cookie_pool{1},
+repowerd::TimerfdWakeupService::TimerfdWakeupService(
+    std::shared_ptr<Log> const& log,
+    std::shared_ptr<Filesystem> const& filesystem,
+    std::shared_ptr<EventLatencyStats> const& event_latency_stats,
+    std::chrono::milliseconds default_slack)
+    : log{log},
+      filesystem{filesystem},
+      event_latency_stats{event_latency_stats},
+      default_slack{default_slack},
+      timerfd_fd{timerfd_create(CLOCK_REALTIME_ALARM, TFD_CLOEXEC)},
+      wakes_system_{timerfd_fd != -1},
       wakeup_handler{null_handler},
+      armed_time{std::chrono::system_clock::time_point::max()},
+      armed_suspend_offset{suspend_offset()},
       event_loop{"Wakeup"}
 {
+    if (!wakes_system_)
+    {
+        // EPERM without CAP_WAKE_ALARM, EINVAL if the kernel lacks alarm timers
+        auto const error = std::system_category().message(errno);
+        REPOWERD_LOG_WARNING(
+            *log, log_tag,
+            "Failed to create CLOCK_REALTIME_ALARM timerfd: %s, "
+            "wakeups will not resume the system from suspend",
+            error.c_str());
+
+        timerfd_fd = Fd{timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC)};
+    }
+
     if (timerfd_fd == -1)
         throw std::system_error{errno, std::system_category(), "Failed to create timerfd"};
 
-    event_loop.watch_fd(
-        timerfd_fd,
-        [this]
-        {
-            auto const wakeup = *wakeups.begin();
-
-            cookie_pool.remove(std::stoull(wakeup.second));
-            wakeups.erase(wakeups.begin());
+    log->log(log_tag, "Using %s timerfd",
+             wakes_system_ ? "CLOCK_REALTIME_ALARM" : "CLOCK_REALTIME");
 
-            reset_timerfd();
-
-            wakeup_handler(wakeup.second);
-        });
+    event_loop.watch_fd(timerfd_fd, [this] { dispatch_due_wakeups(); });
 
     reset_timerfd();
 }
@@ -71,18 +112,23 @@ repowerd::TimerfdWakeupService::TimerfdWakeupService()
 std::string repowerd::TimerfdWakeupService::schedule_wakeup_at(
     std::chrono::system_clock::time_point tp)
 {
-    std::string cookie;
+    return schedule_wakeup_at(tp, default_slack);
+}
+
+std::string repowerd::TimerfdWakeupService::schedule_wakeup_at(
+    std::chrono::system_clock::time_point tp, std::chrono::milliseconds slack)
+{
+    WakeupRegistry::Id id{0};
 
     event_loop.enqueue(
-        [this,tp,&cookie]
+        [this,tp,slack,&id]
         {
-            cookie = std::to_string(cookie_pool.generate());
-            wakeups.insert({tp, cookie});
+            id = wakeups.add(tp, slack);
 
             reset_timerfd();
         }).wait();
 
-    return cookie;
+    return WakeupRegistry::to_cookie(id);
 }
 
 void repowerd::TimerfdWakeupService::cancel_wakeup(std::string const& cookie)
@@ -90,20 +136,16 @@ void repowerd::TimerfdWakeupService::cancel_wakeup(std::string const& cookie)
     event_loop.enqueue(
         [this,&cookie]
         {
-            for (auto iter = wakeups.begin(); iter != wakeups.end(); ++iter)
-            {
-                if (iter->second == cookie)
-                {
-                    cookie_pool.remove(std::stoull(cookie));
-                    wakeups.erase(iter);
-                    break;
-                }
-            }
-
-            reset_timerfd();
+            if (wakeups.remove(WakeupRegistry::from_cookie(cookie)))
+                reset_timerfd();
         }).wait();
 }
 
+bool repowerd::TimerfdWakeupService::wakes_system() const
+{
+    return wakes_system_;
+}
+
 repowerd::HandlerRegistration repowerd::TimerfdWakeupService::register_wakeup_handler(
     WakeupHandler const& handler)
 {
@@ -120,20 +162,68 @@ unsigned int repowerd::TimerfdWakeupService::num_stored_elements()
     event_loop.enqueue(
         [this,&elements]
         {
-            elements = cookie_pool.size() + wakeups.size();
+            elements = wakeups.num_stored_elements();
         }).wait();
 
     return elements;
 }
 
+void repowerd::TimerfdWakeupService::dispatch_due_wakeups()
+{
+    auto const dequeued = std::chrono::steady_clock::now();
+    auto const latency = std::max(
+        std::chrono::system_clock::now() - armed_time,
+        std::chrono::system_clock::duration::zero());
+    auto const suspended = suspend_offset() - armed_suspend_offset;
+
+    // The whole batch the timer was armed for is due
+    auto const due = wakeups.take_due(armed_time);
+
+    reset_timerfd();
+
+    if (due.empty())
+        return;
+
+    if (suspended >= min_suspend_duration)
+    {
+        auto const cause = resume_cause(*filesystem, wakes_system_, latency);
+
+        REPOWERD_LOG_INFO(
+            *log, log_tag,
+            "%zu wakeup(s) due after %lldms in suspend, resumed by %s (%s), latency %lldms",
+            due.size(), to_ms(suspended),
+            cause.wakeup_alarm ? "wakeup alarm" : "another wake source",
+            cause.description.c_str(),
+            to_ms(latency));
+    }
+    else
+    {
+        REPOWERD_LOG_DEBUG(
+            *log, log_tag, "%zu wakeup(s) due, latency %lldms",
+            due.size(), to_ms(latency));
+    }
+
+    for (auto const id : due)
+        wakeup_handler(WakeupRegistry::to_cookie(id));
+
+    event_latency_stats->record(
+        EventType::wakeup,
+        dequeued - std::chrono::duration_cast<std::chrono::steady_clock::duration>(latency),
+        dequeued,
+        std::chrono::steady_clock::now());
+}
+
 void repowerd::TimerfdWakeupService::reset_timerfd()
 {
     timespec next_wakeup;
 
+    armed_time = wakeups.next_batch_time();
+    armed_suspend_offset = suspend_offset();
+
     if (wakeups.empty())
         next_wakeup = {0, 0};
     else
-        next_wakeup = to_timespec(wakeups.begin()->first);
+        next_wakeup = to_timespec(armed_time);
 
     timespec const interval{0,0};
     itimerspec const spec{interval, next_wakeup};
@@ -21,32 +21,54 @@
 #include "wakeup_service.h"
 #include "event_loop.h"
 #include "fd.h"
-#include "unique_random_pool.h"
+#include "wakeup_registry.h"
 
-#include <map>
+#include <memory>
 
 namespace repowerd
 {
+class EventLatencyStats;
+class Filesystem;
+class Log;
 
+// Uses a CLOCK_REALTIME_ALARM timerfd, which resumes the system from
+// suspend, if the process has CAP_WAKE_ALARM. Otherwise falls back to
+// CLOCK_REALTIME, whose wakeups fire only once something else resumes
+// the system.
 class TimerfdWakeupService : public WakeupService
 {
 public:
-    TimerfdWakeupService();
+    TimerfdWakeupService(
+        std::shared_ptr<Log> const& log,
+        std::shared_ptr<Filesystem> const& filesystem,
+        std::shared_ptr<EventLatencyStats> const& event_latency_stats,
+        std::chrono::milliseconds default_slack);
 
     std::string schedule_wakeup_at(std::chrono::system_clock::time_point tp) override;
+    std::string schedule_wakeup_at(
+        std::chrono::system_clock::time_point tp, std::chrono::milliseconds slack) override;
     void cancel_wakeup(std::string const& cookie) override;
     HandlerRegistration register_wakeup_handler(WakeupHandler const& handler) override;
 
+    bool wakes_system() const;
+
     // For testing only
     unsigned int num_stored_elements();
 
 private:
     void reset_timerfd();
+    void dispatch_due_wakeups();
 
+    std::shared_ptr<Log> const log;
+    std::shared_ptr<Filesystem> const filesystem;
+    std::shared_ptr<EventLatencyStats> const event_latency_stats;
+    std::chrono::milliseconds const default_slack;
     Fd timerfd_fd;
-    UniqueRandomPool<uint64_t> cookie_pool;
+    bool wakes_system_;
     WakeupHandler wakeup_handler;
-    std::multimap<std::chrono::system_clock::time_point,std::string> wakeups;
+    WakeupRegistry wakeups;
+    std::chrono::system_clock::time_point armed_time;
+    std::chrono::nanoseconds armed_suspend_offset;
 
     EventLoop event_loop;
 };
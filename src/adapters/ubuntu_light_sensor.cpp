@@ -19,18 +19,34 @@
 #include "ubuntu_light_sensor.h"
 #include "event_loop_handler_registration.h"
 
+#include <algorithm>
 #include <stdexcept>
 
 namespace
 {
-auto const null_handler = [](double){};
+auto const null_handler = [](repowerd::LightSamples const&){};
+// Well below the autobrightness debounce delay, so batching doesn't
+// noticeably delay brightness changes
+auto const max_batch_delay = std::chrono::seconds{1};
+
+// Rounded up, so that the batch is due when the flush runs
+std::chrono::milliseconds delay_until(std::chrono::steady_clock::time_point tp)
+{
+    auto const delay = std::chrono::duration_cast<std::chrono::milliseconds>(
+        tp - std::chrono::steady_clock::now()) + std::chrono::milliseconds{1};
+    return std::max(delay, std::chrono::milliseconds{0});
+}
 }
 
-repowerd::UbuntuLightSensor::UbuntuLightSensor()
+repowerd::UbuntuLightSensor::UbuntuLightSensor(
+    int batch_size,
+    std::chrono::milliseconds min_sample_interval)
     : sensor{ua_sensors_light_new()},
       event_loop{"Light"},
+      batcher{batch_size, min_sample_interval, max_batch_delay},
       handler{null_handler},
-      enabled{false}
+      enabled{false},
+      flush_scheduled{false}
 {
     if (!sensor)
         throw std::runtime_error("Failed to allocate light sensor");
@@ -69,6 +85,7 @@ void repowerd::UbuntuLightSensor::disable_light_events()
             {
                 ua_sensors_light_disable(sensor);
                 enabled = false;
+                batcher.reset();
             }
         }).get();
 }
@@ -79,10 +96,42 @@ void repowerd::UbuntuLightSensor::static_sensor_reading_callback(
     auto const uls = static_cast<UbuntuLightSensor*>(context);
     float light_value{0.0f};
     uas_light_event_get_light(event, &light_value);
-    uls->event_loop.enqueue([uls, light_value] { uls->handle_light_event(light_value); });
+    LightSample const sample{std::chrono::steady_clock::now(), light_value};
+    uls->event_loop.post([uls, sample] { uls->handle_light_event(sample); });
+}
+
+void repowerd::UbuntuLightSensor::handle_light_event(LightSample const& sample)
+{
+    if (!enabled)
+        return;
+
+    deliver(batcher.add(sample));
+    schedule_flush();
+}
+
+void repowerd::UbuntuLightSensor::schedule_flush()
+{
+    auto const due_time = batcher.due_time();
+
+    if (flush_scheduled || due_time == LightSampleBatcher::TimePoint::max())
+        return;
+
+    flush_scheduled = true;
+
+    // A flush left over from before the sensor was disabled finds nothing
+    // due, or a newer batch, which it reschedules itself for
+    event_loop.schedule_in(
+        delay_until(due_time),
+        [this]
+        {
+            flush_scheduled = false;
+            deliver(batcher.take_due(std::chrono::steady_clock::now()));
+            schedule_flush();
+        });
 }
 
-void repowerd::UbuntuLightSensor::handle_light_event(double light)
+void repowerd::UbuntuLightSensor::deliver(LightSamples const& samples)
 {
-    handler(light);
+    if (!samples.empty())
+        handler(samples);
 }
@@ -20,6 +20,9 @@
 
 #include "light_sensor.h"
 #include "event_loop.h"
+#include "light_sample_batcher.h"
+
+#include <chrono>
 
 #include <ubuntu/application/sensors/light.h>
 
@@ -29,7 +32,11 @@ namespace repowerd
 class UbuntuLightSensor : public LightSensor
 {
 public:
-    UbuntuLightSensor();
+    // Samples are batched by a LightSampleBatcher with the given batch_size
+    // and min_sample_interval, and held back for at most a second
+    UbuntuLightSensor(
+        int batch_size,
+        std::chrono::milliseconds min_sample_interval);
 
     HandlerRegistration register_light_handler(LightHandler const& handler) override;
 
@@ -38,12 +45,16 @@ public:
 
 private:
     static void static_sensor_reading_callback(UASLightEvent* event, void* context);
-    void handle_light_event(double light_value);
+    void handle_light_event(LightSample const& sample);
+    void schedule_flush();
+    void deliver(LightSamples const& samples);
 
     UASensorsLight* const sensor;
     EventLoop event_loop;
+    LightSampleBatcher batcher;
     LightHandler handler;
     bool enabled;
+    bool flush_scheduled;
 };
 
 }
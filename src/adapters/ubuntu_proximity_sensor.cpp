@@ -32,6 +32,8 @@ namespace
 
 char const* const log_tag = "UbuntuProximitySensor";
 auto const null_handler = [](repowerd::ProximityState){};
+// Longer than any synthetic initial event delay
+auto const max_query_duration = std::chrono::seconds{2};
 
 char const* proximity_state_to_cstr(repowerd::ProximityState state)
 {
@@ -42,7 +44,10 @@ char const* proximity_state_to_cstr(repowerd::ProximityState state)
 
 repowerd::UbuntuProximitySensor::UbuntuProximitySensor(
     std::shared_ptr<Log> const& log,
-    DeviceQuirks const& device_quirks)
+    std::shared_ptr<Chrono> const& chrono,
+    DeviceQuirks const& device_quirks,
+    std::chrono::milliseconds freshness_window,
+    std::chrono::milliseconds linger_period)
     : log{log},
       sensor{ua_sensors_proximity_new()},
       event_loop{"Proximity"},
@@ -53,8 +58,7 @@ repowerd::UbuntuProximitySensor::UbuntuProximitySensor(
           device_quirks.synthetic_initial_proximity_event_type() ==
               DeviceQuirks::ProximityEventType::far ?
                   ProximityState::far : ProximityState::near},
-      is_state_valid{false},
-      state{ProximityState::far}
+      cache{chrono, freshness_window, linger_period}
 {
     if (!sensor)
         throw std::runtime_error("Failed to allocate proximity sensor");
@@ -73,7 +77,19 @@ repowerd::HandlerRegistration repowerd::UbuntuProximitySensor::register_proximit
 
 repowerd::ProximityState repowerd::UbuntuProximitySensor::proximity_state()
 {
-    log->log(log_tag, "proximity_state()");
+    REPOWERD_LOG_DEBUG(*log, log_tag, "proximity_state()");
+
+    {
+        std::lock_guard<std::mutex> lock{state_mutex};
+
+        if (cache.is_valid() || cache.is_fresh())
+        {
+            REPOWERD_LOG_DEBUG(*log, log_tag, "proximity_state() => %s (%s)",
+                               proximity_state_to_cstr(cache.state()),
+                               cache.is_valid() ? "enabled" : "cached");
+            return cache.state();
+        }
+    }
 
     event_loop.enqueue(
         [this]
@@ -83,14 +99,14 @@ repowerd::ProximityState repowerd::UbuntuProximitySensor::proximity_state()
 
     auto const valid_state = wait_for_valid_state();
 
-    event_loop.enqueue(
+    event_loop.post(
         [this]
         {
             disable_proximity_events_unqueued(EnablementMode::without_handler);
         });
 
-    log->log(log_tag, "proximity_state() => %s",
-             proximity_state_to_cstr(valid_state));
+    REPOWERD_LOG_DEBUG(*log, log_tag, "proximity_state() => %s",
+                       proximity_state_to_cstr(valid_state));
 
     return valid_state;
 }
@@ -132,7 +148,7 @@ void repowerd::UbuntuProximitySensor::static_sensor_reading_callback(
     auto const state = (distance == U_PROXIMITY_NEAR) ?
                        ProximityState::near : ProximityState::far;
 
-    ups->event_loop.enqueue([ups, state] { ups->handle_proximity_event(state); });
+    ups->event_loop.post([ups, state] { ups->handle_proximity_event(state); });
 }
 
 void repowerd::UbuntuProximitySensor::handle_proximity_event(ProximityState new_state)
@@ -151,19 +167,25 @@ void repowerd::UbuntuProximitySensor::handle_proximity_event(ProximityState new_
 
     {
         std::lock_guard<std::mutex> lock{state_mutex};
-        state = new_state;
-        is_state_valid = true;
+        cache.record(new_state);
         state_cv.notify_all();
     }
 
     if (should_invoke_handler())
-        handler(state);
+        handler(new_state);
 }
 
 void repowerd::UbuntuProximitySensor::enable_proximity_events_unqueued(
     EnablementMode mode)
 {
-    if (!is_enabled())
+    auto const was_enabled = is_enabled();
+
+    {
+        std::lock_guard<std::mutex> lock{state_mutex};
+        cache.cancel_linger();
+    }
+
+    if (!was_enabled)
     {
         ua_sensors_proximity_enable(sensor);
         schedule_synthetic_initial_event();
@@ -175,19 +197,15 @@ void repowerd::UbuntuProximitySensor::enable_proximity_events_unqueued(
 void repowerd::UbuntuProximitySensor::disable_proximity_events_unqueued(
     EnablementMode mode)
 {
-    if (is_enabled())
+    if (!enablements.empty())
     {
         auto const iter = std::find(
             enablements.begin(), enablements.end(), mode);
         if (iter != enablements.end())
             enablements.erase(iter);
 
-        if (!is_enabled())
-        {
-            ua_sensors_proximity_disable(sensor);
-            std::lock_guard<std::mutex> lock{state_mutex};
-            is_state_valid = false;
-        }
+        if (enablements.empty())
+            start_linger();
     }
 }
 
@@ -195,11 +213,81 @@ repowerd::ProximityState repowerd::UbuntuProximitySensor::wait_for_valid_state()
 {
     std::unique_lock<std::mutex> lock{state_mutex};
 
-    state_cv.wait(
+    auto const got_valid_state = state_cv.wait_for(
         lock,
-        [this] { return is_state_valid; });
+        max_query_duration,
+        [this] { return cache.is_valid(); });
+
+    if (!got_valid_state)
+    {
+        auto const fallback_state =
+            cache.has_state() ? cache.state() : synthetic_event_state;
+        REPOWERD_LOG_WARNING(*log, log_tag, "wait_for_valid_state() timed out, using %s",
+                             proximity_state_to_cstr(fallback_state));
+        return fallback_state;
+    }
+
+    return cache.state();
+}
+
+void repowerd::UbuntuProximitySensor::disable_sensor()
+{
+    ua_sensors_proximity_disable(sensor);
+
+    std::lock_guard<std::mutex> lock{state_mutex};
+    cache.sensor_powered_off();
+}
 
-    return state;
+void repowerd::UbuntuProximitySensor::start_linger()
+{
+    bool lingering;
+
+    {
+        std::lock_guard<std::mutex> lock{state_mutex};
+        lingering = cache.start_linger();
+    }
+
+    if (lingering)
+        schedule_linger_expiry();
+    else
+        disable_sensor();
+}
+
+void repowerd::UbuntuProximitySensor::schedule_linger_expiry()
+{
+    std::chrono::milliseconds time_left;
+
+    {
+        std::lock_guard<std::mutex> lock{state_mutex};
+        time_left = cache.linger_time_left();
+    }
+
+    // Expiries of lingers that were cancelled in the meantime, or restarted
+    // later, find nothing to do, or reschedule for the current one
+    event_loop.schedule_in(time_left,
+        [this]
+        {
+            std::chrono::milliseconds time_left;
+            bool lingering;
+
+            {
+                std::lock_guard<std::mutex> lock{state_mutex};
+                lingering = cache.is_lingering();
+                time_left = cache.linger_time_left();
+            }
+
+            if (!lingering)
+                return;
+
+            if (time_left > std::chrono::milliseconds::zero())
+            {
+                schedule_linger_expiry();
+                return;
+            }
+
+            log->log(log_tag, "linger period expired, disabling sensor");
+            disable_sensor();
+        });
 }
 
 void repowerd::UbuntuProximitySensor::schedule_synthetic_initial_event()
@@ -236,7 +324,8 @@ void repowerd::UbuntuProximitySensor::invalidate_synthetic_initial_event()
 
 bool repowerd::UbuntuProximitySensor::is_enabled()
 {
-    return !enablements.empty();
+    std::lock_guard<std::mutex> lock{state_mutex};
+    return !enablements.empty() || cache.is_lingering();
 }
 
 bool repowerd::UbuntuProximitySensor::should_invoke_handler()
@@ -20,7 +20,9 @@
 
 #include "src/core/proximity_sensor.h"
 #include "event_loop.h"
+#include "proximity_state_cache.h"
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <condition_variable>
@@ -31,6 +33,7 @@
 namespace repowerd
 {
 
+class Chrono;
 class DeviceQuirks;
 class Log;
 
@@ -39,7 +42,10 @@ class UbuntuProximitySensor : public ProximitySensor
 public:
     UbuntuProximitySensor(
         std::shared_ptr<Log> const& log,
-        DeviceQuirks const& device_quirks);
+        std::shared_ptr<Chrono> const& chrono,
+        DeviceQuirks const& device_quirks,
+        std::chrono::milliseconds freshness_window,
+        std::chrono::milliseconds linger_period);
 
     HandlerRegistration register_proximity_handler(
         ProximityHandler const& handler) override;
@@ -51,6 +57,8 @@ public:
     void emit_proximity_event(ProximityState state);
 
 private:
+    // Besides these, the sensor lingers powered for a while after the last
+    // real user goes away, so that queries soon after are cheap
     enum class EnablementMode{with_handler, without_handler};
 
     static void static_sensor_reading_callback(UASProximityEvent* event, void* context);
@@ -58,6 +66,9 @@ private:
     void enable_proximity_events_unqueued(EnablementMode mode);
     void disable_proximity_events_unqueued(EnablementMode mode);
     ProximityState wait_for_valid_state();
+    void disable_sensor();
+    void start_linger();
+    void schedule_linger_expiry();
     void schedule_synthetic_initial_event();
     void invalidate_synthetic_initial_event();
 
@@ -77,8 +88,7 @@ private:
 
     std::mutex state_mutex;
     std::condition_variable state_cv;
-    bool is_state_valid;
-    ProximityState state;
+    ProximityStateCache cache;
 };
 
 }
@@ -206,8 +206,8 @@ void repowerd::UnityDisplay::dbus_query_active_outputs()
 
     if (!result)
     {
-        log->log(log_tag, "dbus_get_active_outputs() failed to get ActiveOutputs: %s",
-                 error.message_str().c_str());
+        REPOWERD_LOG_WARNING(*log, log_tag, "dbus_get_active_outputs() failed to get ActiveOutputs: %s",
+                             error.message_str().c_str());
         return;
     }
 
@@ -19,8 +19,8 @@
 #include "unity_screen_service.h"
 #include "unity_screen_power_state_change_reason.h"
 #include "brightness_notification.h"
+#include "dbus_sender_credentials.h"
 #include "event_loop_handler_registration.h"
-#include "scoped_g_error.h"
 #include "temporary_suspend_inhibition.h"
 #include "wakeup_service.h"
 
@@ -166,11 +166,13 @@ repowerd::UnityScreenService::UnityScreenService(
     std::shared_ptr<Log> const& log,
     std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
     DeviceConfig const& device_config,
+    std::shared_ptr<DBusSenderCredentials> const& sender_credentials,
     std::string const& dbus_bus_address)
     : wakeup_service{wakeup_service},
       brightness_notification{brightness_notification},
       temporary_suspend_inhibition{temporary_suspend_inhibition},
       log{log},
+      sender_credentials{sender_credentials},
       dbus_connection{dbus_bus_address},
       dbus_event_loop{"DBusService"},
       disable_inactivity_timeout_handler{null_arg2_handler},
@@ -255,13 +257,13 @@ void repowerd::UnityScreenService::start_processing()
             temporary_suspend_inhibition->inhibit_suspend_for(
                 std::chrono::seconds{3}, "Wakeup_" + cookie);
 
-            dbus_event_loop.enqueue([this] { dbus_emit_Wakeup(); });
+            dbus_event_loop.post([this] { dbus_emit_Wakeup(); });
         });
 
     brightness_handler_registration = brightness_notification->register_brightness_handler(
         [this] (double brightness)
         {
-            dbus_event_loop.enqueue([this,brightness] { dbus_emit_brightness(brightness); });
+            dbus_event_loop.post([this,brightness] { dbus_emit_brightness(brightness); });
         });
 
     dbus_connection.request_name(dbus_screen_service_name);
@@ -623,6 +625,8 @@ void repowerd::UnityScreenService::dbus_NameOwnerChanged(
     std::string const& old_owner,
     std::string const& new_owner)
 {
+    sender_credentials->name_owner_changed(name, old_owner, new_owner);
+
     if (keep_display_on_ids.find(name) != keep_display_on_ids.end() ||
         request_sys_state_ids.find(name) != request_sys_state_ids.end() ||
         active_notifications.find(name) != active_notifications.end())
@@ -886,36 +890,8 @@ void repowerd::UnityScreenService::dbus_unknown_method(
 pid_t repowerd::UnityScreenService::dbus_get_invocation_sender_pid(
     GDBusMethodInvocation* invocation)
 {
-    int constexpr timeout = 1000;
-    auto constexpr null_cancellable = nullptr;
-    ScopedGError error;
     auto const sender = g_dbus_method_invocation_get_sender(invocation);
-
-    auto const result = g_dbus_connection_call_sync(
-        dbus_connection,
-        "org.freedesktop.DBus",
-        "/org/freedesktop/DBus",
-        "org.freedesktop.DBus",
-        "GetConnectionUnixProcessID",
-        g_variant_new("(s)", sender),
-        G_VARIANT_TYPE("(u)"),
-        G_DBUS_CALL_FLAGS_NONE,
-        timeout,
-        null_cancellable,
-        error);
-
-    if (!result)
-    {
-        log->log(log_tag, "failed to get pid of '%s': %s",
-                 sender, error.message_str().c_str());
-        return -1;
-    }
-
-    guint pid;
-    g_variant_get(result, "(u)", &pid);
-    g_variant_unref(result);
-
-    return pid;
+    return sender_credentials->pid_for(dbus_connection, sender ? sender : "");
 }
 
 
@@ -38,6 +38,7 @@
 namespace repowerd
 {
 class BrightnessNotification;
+class DBusSenderCredentials;
 class DeviceConfig;
 class Log;
 class TemporarySuspendInhibition;
@@ -54,6 +55,7 @@ public:
         std::shared_ptr<Log> const& log,
         std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
         DeviceConfig const& device_config,
+        std::shared_ptr<DBusSenderCredentials> const& sender_credentials,
         std::string const& dbus_bus_address);
 
     void start_processing() override;
@@ -147,6 +149,7 @@ private:
     std::shared_ptr<BrightnessNotification> const brightness_notification;
     std::shared_ptr<TemporarySuspendInhibition> const temporary_suspend_inhibition;
     std::shared_ptr<Log> const log;
+    std::shared_ptr<DBusSenderCredentials> const sender_credentials;
     DBusConnectionHandle dbus_connection;
     DBusEventLoop dbus_event_loop;
 
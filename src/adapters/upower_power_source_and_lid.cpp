@@ -17,6 +17,7 @@
  */
 
 #include "upower_power_source_and_lid.h"
+#include "chrono.h"
 #include "device_config.h"
 #include "event_loop_handler_registration.h"
 #include "scoped_g_error.h"
@@ -24,6 +25,7 @@
 
 #include "src/core/log.h"
 #include <algorithm>
+#include <cstring>
 
 namespace
 {
@@ -33,6 +35,8 @@ auto const null_arg_handler = [](auto){};
 char const* const dbus_upower_name = "org.freedesktop.UPower";
 char const* const dbus_upower_path = "/org/freedesktop/UPower";
 char const* const dbus_upower_interface = "org.freedesktop.UPower";
+char const* const dbus_upower_device_interface = "org.freedesktop.UPower.Device";
+char const* const dbus_properties_interface = "org.freedesktop.DBus.Properties";
 char const* const display_device_path = "/org/freedesktop/UPower/devices/DisplayDevice";
 
 enum class DeviceState
@@ -99,18 +103,49 @@ catch (...)
     return 68.0;
 }
 
+// Interned once, so that property deltas can be matched without
+// allocating or comparing strings
+struct PropertyKeys
+{
+    GQuark const type{g_quark_from_static_string("Type")};
+    GQuark const is_present{g_quark_from_static_string("IsPresent")};
+    GQuark const state{g_quark_from_static_string("State")};
+    GQuark const percentage{g_quark_from_static_string("Percentage")};
+    GQuark const temperature{g_quark_from_static_string("Temperature")};
+    GQuark const energy_rate{g_quark_from_static_string("EnergyRate")};
+    GQuark const lid_is_closed{g_quark_from_static_string("LidIsClosed")};
+    GQuark const on_battery{g_quark_from_static_string("OnBattery")};
+};
+
+PropertyKeys const& property_keys()
+{
+    static PropertyKeys const keys;
+    return keys;
+}
+
 double constexpr critical_percentage{2.0};
 double constexpr non_critical_percentage{3.0};
+// Predicted time to empty below which the battery is critical, on top of
+// the expected time until the next update, so that there is enough time
+// left to shut down cleanly
+std::chrono::seconds constexpr critical_time_to_empty{60};
+// Consecutive estimates needed below the critical time to empty, so that a
+// single noisy estimate can't shut the device down
+unsigned int constexpr critical_time_to_empty_estimates{2};
 
 }
 
 repowerd::UPowerPowerSourceAndLid::UPowerPowerSourceAndLid(
     std::shared_ptr<Log> const& log,
     std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
+    std::shared_ptr<Chrono> const& chrono,
+    std::shared_ptr<BatteryEstimates> const& battery_estimates,
     DeviceConfig const& device_config,
     std::string const& dbus_bus_address)
     : log{log},
       temporary_suspend_inhibition{temporary_suspend_inhibition},
+      chrono{chrono},
+      battery_estimates{battery_estimates},
       critical_temperature{get_critical_temperature(device_config)},
       dbus_connection{dbus_bus_address},
       dbus_event_loop{"UPower"},
@@ -119,38 +154,84 @@ repowerd::UPowerPowerSourceAndLid::UPowerPowerSourceAndLid(
       lid_handler{null_arg_handler},
       started{false},
       highest_seen_percentage{0.0},
-      display_device{}
+      short_time_to_empty_estimates{0},
+      display_device{},
+      power_snapshot{PowerSnapshot{OnBattery::unknown, 0}},
+      avoided_on_battery_queries_{0}
 {
 }
 
+template <typename Update>
+void repowerd::UPowerPowerSourceAndLid::update_power_snapshot(Update const& update)
+{
+    auto snapshot = power_snapshot.load();
+    PowerSnapshot new_snapshot;
+
+    do
+    {
+        new_snapshot = snapshot;
+        update(new_snapshot);
+    }
+    while (!power_snapshot.compare_exchange_weak(snapshot, new_snapshot));
+}
+
 void repowerd::UPowerPowerSourceAndLid::start_processing()
 {
     if (started) return;
 
-    dbus_signal_handler_registration = dbus_event_loop.register_signal_handler(
-        dbus_connection,
-        dbus_upower_name,
-        nullptr,
-        nullptr,
-        nullptr,
-        [this] (
-            GDBusConnection* connection,
-            gchar const* sender,
-            gchar const* object_path,
-            gchar const* interface_name,
-            gchar const* signal_name,
-            GVariant* parameters)
-        {
-            handle_dbus_signal(
-                connection, sender, object_path, interface_name,
-                signal_name, parameters);
-        });
+    dbus_signal_handler_registrations.push_back(
+        dbus_event_loop.register_signal_handler(
+            dbus_connection,
+            dbus_upower_name,
+            dbus_upower_interface,
+            nullptr,
+            dbus_upower_path,
+            [this] (
+                GDBusConnection* /*connection*/,
+                gchar const* /*sender*/,
+                gchar const* /*object_path*/,
+                gchar const* /*interface_name*/,
+                gchar const* signal_name,
+                GVariant* parameters)
+            {
+                handle_upower_signal(signal_name, parameters);
+            }));
+
+    dbus_signal_handler_registrations.push_back(
+        dbus_event_loop.register_signal_handler(
+            dbus_connection,
+            dbus_upower_name,
+            dbus_properties_interface,
+            "PropertiesChanged",
+            dbus_upower_path,
+            [this] (
+                GDBusConnection* /*connection*/,
+                gchar const* /*sender*/,
+                gchar const* /*object_path*/,
+                gchar const* /*interface_name*/,
+                gchar const* /*signal_name*/,
+                GVariant* parameters)
+            {
+                handle_upower_properties_changed(parameters);
+            }));
+
+    dbus_signal_handler_registrations.push_back(
+        register_device_signal_handler(display_device_path));
 
     dbus_event_loop.enqueue(
         [this]
         {
             add_display_device();
             add_existing_batteries();
+
+            auto const on_battery = dbus_get_on_battery();
+            update_power_snapshot(
+                [on_battery] (PowerSnapshot& snapshot)
+                {
+                    // Don't overwrite a value that arrived through a signal
+                    if (snapshot.on_battery == OnBattery::unknown)
+                        snapshot.on_battery = on_battery;
+                });
         }).get();
 
     started = true;
@@ -187,43 +268,50 @@ repowerd::HandlerRegistration repowerd::UPowerPowerSourceAndLid::register_lid_ha
 
 bool repowerd::UPowerPowerSourceAndLid::is_using_battery_power()
 {
-    int constexpr timeout = 1000;
-    auto constexpr null_cancellable = nullptr;
-    ScopedGError error;
+    auto const snapshot = power_snapshot.load();
+    auto on_battery = snapshot.on_battery;
 
-    auto const result = g_dbus_connection_call_sync(
-        dbus_connection,
-        dbus_upower_name,
-        "/org/freedesktop/UPower",
-        "org.freedesktop.DBus.Properties",
-        "Get",
-        g_variant_new("(ss)", "org.freedesktop.UPower", "OnBattery"),
-        G_VARIANT_TYPE("(v)"),
-        G_DBUS_CALL_FLAGS_NONE,
-        timeout,
-        null_cancellable,
-        error);
-
-    if (!result)
+    if (on_battery != OnBattery::unknown)
     {
-        log->log(log_tag, "is_using_battery_power() failed, assuming true, more info: %s",
-                 error.message_str().c_str());
-        return true;
+        ++avoided_on_battery_queries_;
+    }
+    else
+    {
+        on_battery = dbus_get_on_battery();
+        update_power_snapshot(
+            [on_battery] (PowerSnapshot& snapshot)
+            {
+                if (snapshot.on_battery == OnBattery::unknown)
+                    snapshot.on_battery = on_battery;
+            });
     }
 
-    GVariant* on_battery;
-    g_variant_get(result, "(v)", &on_battery);
-
-    auto const ret = g_variant_get_boolean(on_battery);
+    bool ret;
 
-    g_variant_unref(on_battery);
-    g_variant_unref(result);
+    if (on_battery != OnBattery::unknown)
+    {
+        ret = on_battery == OnBattery::yes;
+    }
+    else
+    {
+        auto const state = snapshot.display_device_state;
+        ret = state != static_cast<uint32_t>(DeviceState::charging) &&
+              state != static_cast<uint32_t>(DeviceState::fully_charged) &&
+              state != static_cast<uint32_t>(DeviceState::pending_charge);
+        log->log(log_tag, "is_using_battery_power() falling back to display device state %s",
+                 device_state_to_str(state).c_str());
+    }
 
     log->log(log_tag, "is_using_battery_power() => %s", ret ? "true" : "false");
 
     return ret;
 }
 
+uint64_t repowerd::UPowerPowerSourceAndLid::avoided_on_battery_queries() const
+{
+    return avoided_on_battery_queries_;
+}
+
 std::unordered_set<std::string> repowerd::UPowerPowerSourceAndLid::tracked_batteries()
 {
     std::unordered_set<std::string> ret_batteries;
@@ -236,41 +324,41 @@ std::unordered_set<std::string> repowerd::UPowerPowerSourceAndLid::tracked_batte
     return ret_batteries;
 }
 
-void repowerd::UPowerPowerSourceAndLid::handle_dbus_signal(
-    GDBusConnection* /*connection*/,
-    gchar const* /*sender*/,
-    gchar const* object_path_cstr,
-    gchar const* /*interface_name*/,
-    gchar const* signal_name_cstr,
-    GVariant* parameters)
+repowerd::HandlerRegistration
+repowerd::UPowerPowerSourceAndLid::register_device_signal_handler(
+    std::string const& device_path)
 {
-    std::string const object_path{object_path_cstr ? object_path_cstr : ""};
-    std::string const signal_name{signal_name_cstr ? signal_name_cstr : ""};
-
-    if (signal_name == "PropertiesChanged")
-    {
-        char const* properties_interface_cstr{""};
-        GVariantIter* properties_iter;
-        g_variant_get(parameters, "(&sa{sv}as)",
-                      &properties_interface_cstr, &properties_iter, nullptr);
-
-        std::string const properties_interface{properties_interface_cstr};
+    return dbus_event_loop.register_signal_handler(
+        dbus_connection,
+        dbus_upower_name,
+        dbus_properties_interface,
+        "PropertiesChanged",
+        device_path.c_str(),
+        [this, device_path] (
+            GDBusConnection* /*connection*/,
+            gchar const* /*sender*/,
+            gchar const* /*object_path*/,
+            gchar const* /*interface_name*/,
+            gchar const* /*signal_name*/,
+            GVariant* parameters)
+        {
+            handle_device_properties_changed(device_path, parameters);
+        });
+}
 
-        if (properties_interface == "org.freedesktop.UPower.Device")
-            change_device(object_path, properties_iter);
-        else if (properties_interface == "org.freedesktop.UPower")
-            change_upower(properties_iter);
+void repowerd::UPowerPowerSourceAndLid::handle_upower_signal(
+    char const* signal_name, GVariant* parameters)
+{
+    if (!signal_name) return;
 
-        g_variant_iter_free(properties_iter);
-    }
-    else if (signal_name == "DeviceAdded")
+    if (strcmp(signal_name, "DeviceAdded") == 0)
     {
         char const* device{""};
         g_variant_get(parameters, "(&o)", &device);
 
         add_device_if_battery(device);
     }
-    else if (signal_name == "DeviceRemoved")
+    else if (strcmp(signal_name, "DeviceRemoved") == 0)
     {
         char const* device{""};
         g_variant_get(parameters, "(&o)", &device);
@@ -279,12 +367,48 @@ void repowerd::UPowerPowerSourceAndLid::handle_dbus_signal(
     }
 }
 
+void repowerd::UPowerPowerSourceAndLid::handle_upower_properties_changed(
+    GVariant* parameters)
+{
+    char const* properties_interface{""};
+    GVariant* properties{nullptr};
+    GVariant* invalidated{nullptr};
+    g_variant_get(parameters, "(&s@a{sv}@as)",
+                  &properties_interface, &properties, &invalidated);
+
+    if (strcmp(properties_interface, dbus_upower_interface) == 0)
+        change_upower(properties, invalidated);
+
+    g_variant_unref(invalidated);
+    g_variant_unref(properties);
+}
+
+void repowerd::UPowerPowerSourceAndLid::handle_device_properties_changed(
+    std::string const& device_path, GVariant* parameters)
+{
+    char const* properties_interface{""};
+    GVariant* properties{nullptr};
+    g_variant_get(parameters, "(&s@a{sv}as)",
+                  &properties_interface, &properties, nullptr);
+
+    if (strcmp(properties_interface, dbus_upower_device_interface) == 0)
+        change_device(device_path, properties);
+
+    g_variant_unref(properties);
+}
+
 void repowerd::UPowerPowerSourceAndLid::add_display_device()
 {
     display_device = create_device(display_device_path);
 
     highest_seen_percentage = display_device.percentage;
 
+    auto const state = display_device.state;
+    update_power_snapshot(
+        [state] (PowerSnapshot& snapshot) { snapshot.display_device_state = state; });
+
+    update_estimate(display_device);
+
     log_device("add_display_device", display_device);
 }
 
@@ -310,8 +434,8 @@ void repowerd::UPowerPowerSourceAndLid::add_existing_batteries()
 
     if (!result)
     {
-        log->log(log_tag, "add_existing_batteries() failed to EnumerateDevices: %s",
-                 error.message_str().c_str());
+        REPOWERD_LOG_WARNING(*log, log_tag, "add_existing_batteries() failed to EnumerateDevices: %s",
+                             error.message_str().c_str());
         return;
     }
 
@@ -329,12 +453,20 @@ void repowerd::UPowerPowerSourceAndLid::add_existing_batteries()
 void repowerd::UPowerPowerSourceAndLid::add_device_if_battery(
     std::string const& device_path)
 {
-    auto const device = create_device(device_path);
+    auto device = create_device(device_path);
 
     if (device.type == static_cast<uint32_t>(DeviceType::battery))
     {
+        // Refresh after subscribing, so that no change falls in between
+        battery_signal_handler_registrations[device_path] =
+            register_device_signal_handler(device_path);
+        auto const refreshed_device = create_device(device_path);
+        if (refreshed_device.path == device_path)
+            device = refreshed_device;
+
         log_device("add_device_if_battery", device);
         batteries[device.path] = device;
+        update_estimate(device);
     }
 }
 
@@ -345,29 +477,51 @@ void repowerd::UPowerPowerSourceAndLid::remove_device(std::string const& device_
 
     log->log(log_tag, "remove_device(%s)", device_path.c_str());
 
+    battery_signal_handler_registrations.erase(device_path);
     batteries.erase(device_path);
+    discharge_estimators.erase(device_path);
+    battery_estimates->remove(device_path);
 }
 
 void repowerd::UPowerPowerSourceAndLid::change_device(
-    std::string const& device_path, GVariantIter* properties_iter)
+    std::string const& device_path, GVariant* properties)
 {
     bool const is_display_device = device_path == display_device_path;
 
-    if (!is_display_device && batteries.find(device_path) == batteries.end())
+    auto const iter = batteries.find(device_path);
+    if (!is_display_device && iter == batteries.end())
         return;
 
-    auto& device = is_display_device ? display_device : batteries[device_path];
-    auto const old_info = device;
-    update_device(device, properties_iter);
-    auto new_info = device;
+    auto& device = is_display_device ? display_device : iter->second;
+    DeviceProperties const old_info = device;
+    update_device(device, properties);
+    DeviceProperties const new_info = device;
 
-    log_device("change_device", new_info);
+    log_device("change_device", device);
+
+    BatteryEstimate estimate{0.0, std::chrono::seconds{0}};
+    bool estimated{false};
+    if (old_info.is_present != new_info.is_present ||
+        old_info.state != new_info.state ||
+        old_info.percentage != new_info.percentage ||
+        old_info.energy_rate != new_info.energy_rate)
+    {
+        estimate = update_estimate(device);
+        estimated = true;
+    }
 
     bool critical{false};
     bool change{false};
 
     if (is_display_device)
     {
+        if (old_info.state != new_info.state)
+        {
+            auto const state = new_info.state;
+            update_power_snapshot(
+                [state] (PowerSnapshot& snapshot) { snapshot.display_device_state = state; });
+        }
+
         if (old_info.is_present != new_info.is_present ||
             old_info.type != new_info.type)
         {
@@ -398,6 +552,33 @@ void repowerd::UPowerPowerSourceAndLid::change_device(
                 critical = true;
             }
         }
+
+        auto const time_to_empty_limit = critical_time_to_empty +
+            discharge_estimators[device_path].mean_sample_interval();
+
+        if (estimated)
+        {
+            if (estimate.time_to_empty > std::chrono::seconds{0} &&
+                estimate.time_to_empty <= time_to_empty_limit)
+            {
+                ++short_time_to_empty_estimates;
+            }
+            else
+            {
+                short_time_to_empty_estimates = 0;
+            }
+        }
+
+        if (!critical && new_info.is_present &&
+            short_time_to_empty_estimates >= critical_time_to_empty_estimates &&
+            highest_seen_percentage >= non_critical_percentage &&
+            is_using_battery_power())
+        {
+            log->log(log_tag, "Battery is predicted to be empty in %lld s at %.1f%%/h\n",
+                     static_cast<long long>(estimate.time_to_empty.count()),
+                     estimate.discharge_rate);
+            critical = true;
+        }
     }
     else
     {
@@ -421,6 +602,7 @@ void repowerd::UPowerPowerSourceAndLid::change_device(
     if (critical)
     {
         highest_seen_percentage = 0.0;
+        short_time_to_empty_estimates = 0;
         power_source_critical_handler();
     }
 
@@ -429,16 +611,21 @@ void repowerd::UPowerPowerSourceAndLid::change_device(
 }
 
 void repowerd::UPowerPowerSourceAndLid::change_upower(
-    GVariantIter* properties_iter)
+    GVariant* properties, GVariant* invalidated)
 {
+    auto const& keys = property_keys();
+
+    GVariantIter properties_iter;
+    g_variant_iter_init(&properties_iter, properties);
+
     char const* key_cstr{""};
     GVariant* value{nullptr};
 
-    while (g_variant_iter_next(properties_iter, "{&sv}", &key_cstr, &value))
+    while (g_variant_iter_next(&properties_iter, "{&sv}", &key_cstr, &value))
     {
-        auto const key_str = std::string{key_cstr};
+        auto const key = g_quark_try_string(key_cstr);
 
-        if (key_str == "LidIsClosed")
+        if (key == keys.lid_is_closed)
         {
             auto const lid_is_closed = g_variant_get_boolean(value);
             log->log(log_tag, "change_upower(), lid_is_closed=%s",
@@ -449,9 +636,70 @@ void repowerd::UPowerPowerSourceAndLid::change_upower(
                 lid_handler(LidState::open);
             }
         }
+        else if (key == keys.on_battery)
+        {
+            auto const on_battery = g_variant_get_boolean(value) ? OnBattery::yes : OnBattery::no;
+            log->log(log_tag, "change_upower(), on_battery=%s",
+                     on_battery == OnBattery::yes ? "true" : "false");
+            update_power_snapshot(
+                [on_battery] (PowerSnapshot& snapshot) { snapshot.on_battery = on_battery; });
+        }
 
         g_variant_unref(value);
     }
+
+    GVariantIter invalidated_iter;
+    g_variant_iter_init(&invalidated_iter, invalidated);
+
+    char const* invalidated_cstr{""};
+
+    while (g_variant_iter_next(&invalidated_iter, "&s", &invalidated_cstr))
+    {
+        // The next query fetches the new value
+        if (g_quark_try_string(invalidated_cstr) == keys.on_battery)
+        {
+            update_power_snapshot(
+                [] (PowerSnapshot& snapshot) { snapshot.on_battery = OnBattery::unknown; });
+        }
+    }
+}
+
+repowerd::UPowerPowerSourceAndLid::OnBattery
+repowerd::UPowerPowerSourceAndLid::dbus_get_on_battery()
+{
+    int constexpr timeout = 1000;
+    auto constexpr null_cancellable = nullptr;
+    ScopedGError error;
+
+    auto const result = g_dbus_connection_call_sync(
+        dbus_connection,
+        dbus_upower_name,
+        dbus_upower_path,
+        dbus_properties_interface,
+        "Get",
+        g_variant_new("(ss)", dbus_upower_interface, "OnBattery"),
+        G_VARIANT_TYPE("(v)"),
+        G_DBUS_CALL_FLAGS_NONE,
+        timeout,
+        null_cancellable,
+        error);
+
+    if (!result)
+    {
+        REPOWERD_LOG_WARNING(*log, log_tag, "dbus_get_on_battery() failed: %s",
+                             error.message_str().c_str());
+        return OnBattery::unknown;
+    }
+
+    GVariant* on_battery;
+    g_variant_get(result, "(v)", &on_battery);
+
+    auto const ret = g_variant_get_boolean(on_battery);
+
+    g_variant_unref(on_battery);
+    g_variant_unref(result);
+
+    return ret ? OnBattery::yes : OnBattery::no;
 }
 
 GVariant* repowerd::UPowerPowerSourceAndLid::get_device_properties(std::string const& device)
@@ -464,9 +712,9 @@ GVariant* repowerd::UPowerPowerSourceAndLid::get_device_properties(std::string c
         dbus_connection,
         dbus_upower_name,
         device.c_str(),
-        "org.freedesktop.DBus.Properties",
+        dbus_properties_interface,
         "GetAll",
-        g_variant_new("(s)", "org.freedesktop.UPower.Device"),
+        g_variant_new("(s)", dbus_upower_device_interface),
         G_VARIANT_TYPE("(a{sv})"),
         G_DBUS_CALL_FLAGS_NONE,
         timeout_default,
@@ -475,8 +723,8 @@ GVariant* repowerd::UPowerPowerSourceAndLid::get_device_properties(std::string c
 
     if (!result)
     {
-        log->log(log_tag, "get_device_properties() failed: %s",
-                 error.message_str().c_str());
+        REPOWERD_LOG_WARNING(*log, log_tag, "get_device_properties() failed: %s",
+                             error.message_str().c_str());
     }
 
     return result;
@@ -494,12 +742,10 @@ repowerd::UPowerPowerSourceAndLid::create_device(std::string const& device_path)
     Device device{};
     device.path = device_path;
 
-    GVariantIter* properties_iter;
-    g_variant_get(properties, "(a{sv})", &properties_iter);
-
-    update_device(device, properties_iter);
+    auto const properties_dict = g_variant_get_child_value(properties, 0);
+    update_device(device, properties_dict);
 
-    g_variant_iter_free(properties_iter);
+    g_variant_unref(properties_dict);
     g_variant_unref(properties);
 
     return device;
@@ -507,36 +753,61 @@ repowerd::UPowerPowerSourceAndLid::create_device(std::string const& device_path)
 
 
 void repowerd::UPowerPowerSourceAndLid::update_device(
-    Device& device, GVariantIter* properties_iter)
+    DeviceProperties& device, GVariant* properties)
 {
+    auto const& keys = property_keys();
+
+    GVariantIter properties_iter;
+    g_variant_iter_init(&properties_iter, properties);
+
     char const* key_cstr{""};
     GVariant* value{nullptr};
 
-    while (g_variant_iter_next(properties_iter, "{&sv}", &key_cstr, &value))
+    while (g_variant_iter_next(&properties_iter, "{&sv}", &key_cstr, &value))
     {
-        auto const key_str = std::string{key_cstr};
-        if (key_str == "Type")
+        auto const key = g_quark_try_string(key_cstr);
+
+        if (key == keys.type)
             device.type = g_variant_get_uint32(value);
-        else if (key_str == "IsPresent")
+        else if (key == keys.is_present)
             device.is_present = g_variant_get_boolean(value);
-        else if (key_str == "State")
+        else if (key == keys.state)
             device.state = g_variant_get_uint32(value);
-        else if (key_str == "Percentage")
+        else if (key == keys.percentage)
             device.percentage = g_variant_get_double(value);
-        else if (key_str == "Temperature")
+        else if (key == keys.temperature)
             device.temperature = g_variant_get_double(value);
+        else if (key == keys.energy_rate)
+            device.energy_rate = g_variant_get_double(value);
 
         g_variant_unref(value);
     }
 }
 
-void repowerd::UPowerPowerSourceAndLid::log_device(
-    std::string const& method, Device const& device)
+repowerd::BatteryEstimate repowerd::UPowerPowerSourceAndLid::update_estimate(
+    Device const& device)
 {
-    auto const msg =
-        method + "(%s), type=%s, is_present=%d, state=%s, percentage=%.2f, temperature=%.2f";
+    if (device.path.empty())
+        return BatteryEstimate{0.0, std::chrono::seconds{0}};
+
+    auto& estimator = discharge_estimators[device.path];
+
+    if (device.is_present && device.state == static_cast<uint32_t>(DeviceState::discharging))
+        estimator.add_sample(chrono->steady_now(), device.percentage, device.energy_rate);
+    else
+        estimator.reset();
+
+    auto const estimate = estimator.estimate();
+    battery_estimates->update(device.path, estimate);
 
-    log->log(log_tag, msg.c_str(),
+    return estimate;
+}
+
+void repowerd::UPowerPowerSourceAndLid::log_device(
+    char const* method, Device const& device)
+{
+    log->log(log_tag, "%s(%s), type=%s, is_present=%d, state=%s, percentage=%.2f, temperature=%.2f",
+             method,
              device.path.c_str(),
              device_type_to_str(device.type).c_str(),
              device.is_present,
@@ -21,14 +21,18 @@
 #include "src/core/power_source.h"
 #include "src/core/lid.h"
 
+#include "battery_discharge_estimator.h"
 #include "dbus_connection_handle.h"
 #include "dbus_event_loop.h"
 
+#include <atomic>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace repowerd
 {
+class Chrono;
 class Log;
 class DeviceConfig;
 class TemporarySuspendInhibition;
@@ -39,6 +43,8 @@ public:
     UPowerPowerSourceAndLid(
         std::shared_ptr<Log> const& log,
         std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
+        std::shared_ptr<Chrono> const& chrono,
+        std::shared_ptr<BatteryEstimates> const& battery_estimates,
         DeviceConfig const& device_config,
         std::string const& dbus_bus_address);
 
@@ -57,43 +63,65 @@ public:
 
     std::unordered_set<std::string> tracked_batteries();
 
+    // Number of is_using_battery_power() calls answered from the tracked
+    // OnBattery value instead of a D-Bus round trip
+    uint64_t avoided_on_battery_queries() const;
+
 private:
-    struct Device
+    enum class OnBattery : uint32_t { unknown, no, yes };
+
+    // Updated from UPower signals, read without blocking from any thread
+    struct PowerSnapshot
+    {
+        OnBattery on_battery;
+        uint32_t display_device_state;
+    };
+
+    struct DeviceProperties
     {
-        std::string path;
         uint32_t type;
         bool is_present;
         uint32_t state;
         double percentage;
         double temperature;
+        double energy_rate;
     };
 
-    void handle_dbus_signal(
-        GDBusConnection* connection,
-        gchar const* sender,
-        gchar const* object_path,
-        gchar const* interface_name,
-        gchar const* signal_name,
-        GVariant* parameters);
+    struct Device : DeviceProperties
+    {
+        std::string path;
+    };
+
+    HandlerRegistration register_device_signal_handler(std::string const& device_path);
+    void handle_upower_signal(char const* signal_name, GVariant* parameters);
+    void handle_upower_properties_changed(GVariant* parameters);
+    void handle_device_properties_changed(
+        std::string const& device_path, GVariant* parameters);
 
     void add_display_device();
     void add_existing_batteries();
     void add_device_if_battery(std::string const& device_path);
     void remove_device(std::string const& device_path);
-    void change_device(std::string const& device_path, GVariantIter* properties_iter);
-    void change_upower(GVariantIter* properties_iter);
+    void change_device(std::string const& device_path, GVariant* properties);
+    void change_upower(GVariant* properties, GVariant* invalidated);
+    OnBattery dbus_get_on_battery();
+    template <typename Update> void update_power_snapshot(Update const& update);
     GVariant* get_device_properties(std::string const& device);
     Device create_device(std::string const& device_path);
-    void update_device(Device& device, GVariantIter* properties_iter);
-    void log_device(std::string const& method, Device const& device);
+    void update_device(DeviceProperties& device, GVariant* properties);
+    BatteryEstimate update_estimate(Device const& device);
+    void log_device(char const* method, Device const& device);
 
     std::shared_ptr<Log> const log;
     std::shared_ptr<TemporarySuspendInhibition> const temporary_suspend_inhibition;
+    std::shared_ptr<Chrono> const chrono;
+    std::shared_ptr<BatteryEstimates> const battery_estimates;
     double const critical_temperature;
 
     DBusConnectionHandle dbus_connection;
     DBusEventLoop dbus_event_loop;
-    HandlerRegistration dbus_signal_handler_registration;
+    std::vector<HandlerRegistration> dbus_signal_handler_registrations;
+    std::unordered_map<std::string,HandlerRegistration> battery_signal_handler_registrations;
 
     PowerSourceChangeHandler power_source_change_handler;
     PowerSourceChangeHandler power_source_critical_handler;
@@ -101,9 +129,15 @@ private:
 
     bool started;
     double highest_seen_percentage;
+    // Consecutive estimates of the display device predicting it to be empty soon
+    unsigned int short_time_to_empty_estimates;
 
     Device display_device;
     std::unordered_map<std::string,Device> batteries;
+    std::unordered_map<std::string,BatteryDischargeEstimator> discharge_estimators;
+
+    std::atomic<PowerSnapshot> power_snapshot;
+    std::atomic<uint64_t> avoided_on_battery_queries_;
 };
 
 }
@@ -0,0 +1,134 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "wakeup_registry.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+
+repowerd::WakeupRegistry::WakeupRegistry()
+    : id_generator{std::random_device{}()},
+      next_sequence{0}
+{
+}
+
+repowerd::WakeupRegistry::Id repowerd::WakeupRegistry::add(
+    time_point tp, std::chrono::milliseconds slack)
+{
+    Id id;
+    do
+    {
+        id = id_generator();
+    }
+    while (id == 0 || entries.find(id) != entries.end());
+
+    auto const max_slack =
+        std::chrono::duration_cast<std::chrono::milliseconds>(time_point::max() - tp);
+    auto const deadline =
+        slack < max_slack ? tp + std::chrono::duration_cast<time_point::duration>(slack)
+                          : time_point::max();
+
+    auto const sequence = next_sequence++;
+
+    entries.emplace(id, Entry{tp, sequence, deadline});
+    by_start.emplace(tp, sequence, id);
+
+    return id;
+}
+
+bool repowerd::WakeupRegistry::remove(Id id)
+{
+    auto const iter = entries.find(id);
+    if (iter == entries.end())
+        return false;
+
+    by_start.erase(StartKey{iter->second.start, iter->second.sequence, id});
+    entries.erase(iter);
+
+    return true;
+}
+
+repowerd::WakeupRegistry::time_point repowerd::WakeupRegistry::next_batch_time() const
+{
+    if (by_start.empty())
+        return time_point::max();
+
+    auto batch_time = std::get<0>(*by_start.begin());
+    auto batch_end = time_point::max();
+
+    for (auto const& key : by_start)
+    {
+        auto const start = std::get<0>(key);
+        if (start > batch_end)
+            break;
+
+        batch_time = start;
+        batch_end = std::min(batch_end, entries.at(std::get<2>(key)).deadline);
+    }
+
+    return batch_time;
+}
+
+std::vector<repowerd::WakeupRegistry::Id> repowerd::WakeupRegistry::take_due(time_point tp)
+{
+    std::vector<Id> due;
+
+    while (!by_start.empty() && std::get<0>(*by_start.begin()) <= tp)
+    {
+        auto const id = std::get<2>(*by_start.begin());
+        due.push_back(id);
+        entries.erase(id);
+        by_start.erase(by_start.begin());
+    }
+
+    return due;
+}
+
+bool repowerd::WakeupRegistry::empty() const
+{
+    return entries.empty();
+}
+
+size_t repowerd::WakeupRegistry::size() const
+{
+    return entries.size();
+}
+
+size_t repowerd::WakeupRegistry::num_stored_elements() const
+{
+    return entries.size() + by_start.size();
+}
+
+std::string repowerd::WakeupRegistry::to_cookie(Id id)
+{
+    return std::to_string(id);
+}
+
+repowerd::WakeupRegistry::Id repowerd::WakeupRegistry::from_cookie(std::string const& cookie)
+{
+    if (cookie.empty() || cookie[0] < '0' || cookie[0] > '9')
+        return 0;
+
+    char* end;
+    errno = 0;
+    auto const id = strtoull(cookie.c_str(), &end, 10);
+
+    if (errno != 0 || *end != '\0')
+        return 0;
+
+    return id;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace repowerd
+{
+
+// Pending wakeups indexed by integer handle and ordered by time. A wakeup
+// may be deferred by up to its slack, so that wakeups whose windows
+// overlap are handed out as one batch and need a single device resume.
+// Adding and removing are O(log n). Not thread-safe.
+class WakeupRegistry
+{
+public:
+    using Id = uint64_t;
+    using time_point = std::chrono::system_clock::time_point;
+
+    WakeupRegistry();
+
+    Id add(time_point tp, std::chrono::milliseconds slack);
+    bool remove(Id id);
+
+    // The time the next batch is due: the latest start among the earliest
+    // wakeups whose windows all overlap. time_point::max() if empty.
+    time_point next_batch_time() const;
+
+    // Removes and returns the wakeups that have started by tp, in time order
+    // and, for equal times, in the order they were added
+    std::vector<Id> take_due(time_point tp);
+
+    bool empty() const;
+    size_t size() const;
+    // For testing only
+    size_t num_stored_elements() const;
+
+    // Handles are exposed to clients as decimal strings; 0 is never a
+    // valid handle and is returned for malformed cookies
+    static std::string to_cookie(Id id);
+    static Id from_cookie(std::string const& cookie);
+
+private:
+    struct Entry
+    {
+        time_point start;
+        uint64_t sequence;
+        time_point deadline;
+    };
+
+    using StartKey = std::tuple<time_point, uint64_t, Id>;
+
+    std::mt19937_64 id_generator;
+    uint64_t next_sequence;
+    std::unordered_map<Id, Entry> entries;
+    std::set<StartKey> by_start;
+};
+
+}
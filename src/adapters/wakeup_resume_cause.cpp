@@ -0,0 +1,94 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "wakeup_resume_cause.h"
+#include "filesystem.h"
+
+#include <sstream>
+
+namespace
+{
+
+char const* const wakeup_irq_path = "/sys/power/pm_wakeup_irq";
+char const* const interrupts_path = "/proc/interrupts";
+
+// Name of the handler registered for the IRQ, empty if unknown
+std::string irq_name(repowerd::Filesystem const& filesystem, int irq)
+{
+    auto const interrupts = filesystem.istream(interrupts_path);
+    auto const irq_prefix = std::to_string(irq) + ":";
+    std::string line;
+
+    while (std::getline(*interrupts, line))
+    {
+        std::istringstream fields{line};
+        std::string field;
+
+        if (!(fields >> field) || field != irq_prefix)
+            continue;
+
+        std::string name;
+        while (fields >> field)
+            name = field;
+
+        return name;
+    }
+
+    return {};
+}
+
+bool contains(std::string const& str, char const* part)
+{
+    return str.find(part) != std::string::npos;
+}
+
+long long to_ms(std::chrono::nanoseconds d)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+}
+
+}
+
+repowerd::ResumeCause repowerd::resume_cause(
+    Filesystem const& filesystem,
+    bool alarm_wakes_system,
+    std::chrono::nanoseconds expiry_latency)
+{
+    int irq{0};
+    auto const wakeup_irq = filesystem.istream(wakeup_irq_path);
+
+    if (*wakeup_irq >> irq && irq > 0)
+    {
+        auto const name = irq_name(filesystem, irq);
+        auto const description =
+            "kernel wakeup IRQ " + std::to_string(irq) +
+            (name.empty() ? "" : " " + name);
+
+        if (contains(name, "rtc") || contains(name, "alarm"))
+            return {alarm_wakes_system, description};
+
+        if (!contains(name, "acpi"))
+            return {false, description};
+    }
+
+    auto const description =
+        "guessed from expiry " + std::to_string(to_ms(expiry_latency)) + "ms earlier";
+
+    return {alarm_wakes_system && expiry_latency <= max_alarm_resume_latency,
+            description};
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace repowerd
+{
+class Filesystem;
+
+struct ResumeCause
+{
+    // Whether the wakeup alarm is taken to have resumed the system
+    bool wakeup_alarm;
+    // How the cause was determined, for logging
+    std::string description;
+};
+
+// Attributes the last resume from suspend to the wakeup alarm or to another
+// wake source. Prefers the IRQ the kernel recorded in
+// /sys/power/pm_wakeup_irq (CONFIG_PM_SLEEP_DEBUG), named in
+// /proc/interrupts: an RTC or alarm IRQ is the alarm, any other IRQ is not,
+// except for the ACPI SCI, which is shared by all ACPI wake events including
+// the CMOS RTC. Without a usable IRQ, guesses from how late after expiry the
+// wakeups were dispatched: only a resume within max_alarm_resume_latency of
+// expiry counts as the alarm, which still misattributes a resume by another
+// source shortly before expiry.
+ResumeCause resume_cause(
+    Filesystem const& filesystem,
+    bool alarm_wakes_system,
+    std::chrono::nanoseconds expiry_latency);
+
+// Covers the kernel and userspace resume path after the alarm fires
+std::chrono::milliseconds constexpr max_alarm_resume_latency{3000};
+
+}
@@ -35,6 +35,10 @@ public:
     virtual ~WakeupService() = default;
 
     virtual std::string schedule_wakeup_at(std::chrono::system_clock::time_point tp) = 0;
+    // The wakeup may be deferred by up to slack, to share a device resume
+    // with other wakeups
+    virtual std::string schedule_wakeup_at(
+        std::chrono::system_clock::time_point tp, std::chrono::milliseconds slack) = 0;
     virtual void cancel_wakeup(std::string const& cookie) = 0;
     virtual HandlerRegistration register_wakeup_handler(WakeupHandler const& handler) = 0;
 
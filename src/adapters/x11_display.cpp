@@ -35,6 +35,7 @@ namespace
     char const* const x11_display_bus_name = "org.thinkglobally.Gemian.Display";
     char const* const x11_display_object_path = "/org/thinkglobally/Gemian/Display";
     char const* const x11_display_interface_name = "org.thinkglobally.Gemian.Display";
+    char const* const x11_output_name = "hwcomposer";
     char const* const log_tag = "X11Display";
 
     std::string filter_to_str(repowerd::DisplayPowerControlFilter filter)
@@ -59,13 +60,15 @@ namespace
 repowerd::X11Display::X11Display(
         std::shared_ptr<Log> const& log,
         std::shared_ptr<Exec> const& exec,
-        std::string const& dbus_bus_address)
+        std::string const& dbus_bus_address,
+        std::string const& x11_display_name)
         : log{log},
           exec{exec},
           dbus_connection{dbus_bus_address},
           dbus_event_loop{"Display"},
           has_active_external_displays_{false},
-          active_username_{}
+          active_username_{},
+          x11_connection{log, x11_display_name, x11_output_name}
 {
 
     dbus_signal_handler_registration = dbus_event_loop.register_signal_handler(
@@ -87,6 +90,27 @@ repowerd::X11Display::X11Display(
                         signal_name, parameters);
             });
 
+    // The X server only accepts the active user's credentials, so follow
+    // session switches to reconnect with the right Xauthority
+    dbus_seat_handler_registration = dbus_event_loop.register_signal_handler(
+            dbus_connection,
+            dbus_logind_name,
+            "org.freedesktop.DBus.Properties",
+            "PropertiesChanged",
+            dbus_seat_path,
+            [this] (
+                    GDBusConnection* connection,
+                    gchar const* sender,
+                    gchar const* object_path,
+                    gchar const* interface_name,
+                    gchar const* signal_name,
+                    GVariant* parameters)
+            {
+                handle_dbus_signal(
+                        connection, sender, object_path, interface_name,
+                        signal_name, parameters);
+            });
+
     dbus_event_loop.enqueue([this] { dbus_query_active_session(); }).get();
     dbus_event_loop.enqueue([this] { dbus_query_active_outputs(); }).get();
 }
@@ -97,6 +121,14 @@ void repowerd::X11Display::turn_on(DisplayPowerControlFilter filter)
 
     log->log(log_tag, "turn_on(%s)", filter_str.c_str());
 
+    std::lock_guard<std::mutex> lock{active_user_mutex};
+
+    if (x11_connection.turn_on(true))
+    {
+        log->log(log_tag, "turned_on(%s) - x11", filter_str.c_str());
+        return;
+    }
+
     std::string on_cmd = std::string("/bin/su - ")+active_username_+" -c \"DISPLAY=:0 xrandr --output hwcomposer --auto; DISPLAY=:0 xset dpms force on\"";
     int ret = exec->exec(on_cmd.c_str());
 
@@ -109,6 +141,14 @@ void repowerd::X11Display::turn_off(DisplayPowerControlFilter filter, bool lid_c
 
     log->log(log_tag, "turn_off(%s)", filter_str.c_str());
 
+    std::lock_guard<std::mutex> lock{active_user_mutex};
+
+    if (x11_connection.turn_off(lid_closed))
+    {
+        log->log(log_tag, "turned_off(%s) - x11", filter_str.c_str());
+        return;
+    }
+
     std::string off_cmd = std::string("/bin/su - ")+active_username_;
     if (lid_closed) {
         off_cmd += " -c \"DISPLAY=:0 xrandr --output hwcomposer --off; DISPLAY=:0 xset dpms force off\"";
@@ -127,6 +167,7 @@ bool repowerd::X11Display::has_active_external_displays()
 
 std::string repowerd::X11Display::active_username()
 {
+    std::lock_guard<std::mutex> lock{active_user_mutex};
     return active_username_;
 }
 
@@ -151,6 +192,8 @@ void repowerd::X11Display::handle_dbus_signal(
 
         if (properties_interface == x11_display_interface_name)
             dbus_PropertiesChanged(properties_iter);
+        else if (properties_interface == dbus_seat_interface)
+            dbus_query_active_session();
 
         g_variant_iter_free(properties_iter);
     }
@@ -211,8 +254,8 @@ void repowerd::X11Display::dbus_query_active_outputs()
 
     if (!result)
     {
-        log->log(log_tag, "dbus_get_active_outputs() failed to get ActiveOutputs: %s",
-                 error.message_str().c_str());
+        REPOWERD_LOG_WARNING(*log, log_tag, "dbus_get_active_outputs() failed to get ActiveOutputs: %s",
+                             error.message_str().c_str());
         return;
     }
 
@@ -235,7 +278,11 @@ void repowerd::X11Display::dbus_query_active_session()
     auto const active_session = dbus_get_active_session();
     if (!active_session.first.empty())
     {
-        active_username_ = dbus_get_session_user_name(active_session.second);
+        auto const username = dbus_get_session_user_name(active_session.second);
+
+        std::lock_guard<std::mutex> lock{active_user_mutex};
+        active_username_ = username;
+        x11_connection.set_user(username);
     }
 }
 
@@ -260,8 +307,8 @@ std::pair<std::string,std::string> repowerd::X11Display::dbus_get_active_session
 
     if (!result)
     {
-        log->log(log_tag, "dbus_get_active_session() failed to get ActiveSession: %s",
-                 error.message_str().c_str());
+        REPOWERD_LOG_WARNING(*log, log_tag, "dbus_get_active_session() failed to get ActiveSession: %s",
+                             error.message_str().c_str());
         return {"",""};
     }
 
@@ -302,8 +349,8 @@ std::string repowerd::X11Display::dbus_get_session_user_name(std::string const&
 
     if (!result)
     {
-        log->log(log_tag, "dbus_get_session_type() failed to get session Name: %s",
-                 error.message_str().c_str());
+        REPOWERD_LOG_WARNING(*log, log_tag, "dbus_get_session_type() failed to get session Name: %s",
+                             error.message_str().c_str());
         return "";
     }
 
@@ -323,5 +370,6 @@ std::string repowerd::X11Display::dbus_get_session_user_name(std::string const&
 
 void repowerd::X11Display::set_active_username(const char *string)
 {
+    std::lock_guard<std::mutex> lock{active_user_mutex};
     active_username_ = string;
 }
@@ -28,8 +28,10 @@
 
 #include "dbus_connection_handle.h"
 #include "dbus_event_loop.h"
+#include "x11_display_connection.h"
 
 #include <memory>
+#include <mutex>
 #include <atomic>
 
 namespace repowerd
@@ -42,7 +44,8 @@ namespace repowerd
         X11Display(
                 std::shared_ptr<Log> const& log,
                 std::shared_ptr<Exec> const& exec,
-                std::string const& dbus_bus_address);
+                std::string const& dbus_bus_address,
+                std::string const& x11_display_name);
 
         // From DisplayPowerControl
         void turn_on(DisplayPowerControlFilter filter) override;
@@ -72,8 +75,12 @@ namespace repowerd
         DBusConnectionHandle dbus_connection;
         DBusEventLoop dbus_event_loop;
         HandlerRegistration dbus_signal_handler_registration;
+        HandlerRegistration dbus_seat_handler_registration;
         std::atomic<bool> has_active_external_displays_;
+
+        std::mutex active_user_mutex;
         std::string active_username_;
+        X11DisplayConnection x11_connection;
 
         std::pair<std::string, std::string> dbus_get_active_session();
 
@@ -0,0 +1,426 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "x11_display_connection.h"
+
+#include "src/core/log.h"
+
+#include <X11/Xauth.h>
+#include <X11/Xlib.h>
+#include <X11/extensions/Xrandr.h>
+#include <X11/extensions/dpms.h>
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include <csignal>
+#include <csetjmp>
+#include <pwd.h>
+#include <pthread.h>
+#include <unistd.h>
+
+namespace
+{
+char const* const log_tag = "X11DisplayConnection";
+char const* const cookie_auth_name = "MIT-MAGIC-COOKIE-1";
+
+// Protocol errors are reported asynchronously and the default Xlib handler
+// exits the process, which is never what we want for a failed DPMS or RandR
+// request, so ignore them; the requests we send are best effort anyway
+int ignore_x_error(Display*, XErrorEvent*)
+{
+    return 0;
+}
+
+#ifdef REPOWERD_HAVE_XSETIOERROREXITHANDLER
+void mark_connection_lost(Display*, void* connection_lost)
+{
+    *static_cast<bool*>(connection_lost) = true;
+}
+#else
+// Without XSetIOErrorExitHandler (libX11 < 1.7), Xlib exits the process
+// once the I/O error handler returns, so the handler must not return but
+// jump back to the X11DisplayConnection call that hit the error instead
+thread_local sigjmp_buf* io_error_recovery{nullptr};
+
+int recover_from_io_error(Display*)
+{
+    if (io_error_recovery)
+        siglongjmp(*io_error_recovery, 1);
+    return 0;
+}
+#endif
+
+// Writing to a connection the X server has closed raises SIGPIPE, which
+// would terminate the daemon instead of letting Xlib report the lost connection
+class ScopedSigpipeBlock
+{
+public:
+    ScopedSigpipeBlock()
+    {
+        sigemptyset(&sigpipe);
+        sigaddset(&sigpipe, SIGPIPE);
+
+        sigset_t pending;
+        sigpending(&pending);
+        was_pending = sigismember(&pending, SIGPIPE);
+
+        pthread_sigmask(SIG_BLOCK, &sigpipe, &old_mask);
+    }
+
+    ~ScopedSigpipeBlock()
+    {
+        sigset_t pending;
+        sigpending(&pending);
+        if (!was_pending && sigismember(&pending, SIGPIPE))
+        {
+            timespec const no_wait{0, 0};
+            sigtimedwait(&sigpipe, nullptr, &no_wait);
+        }
+
+        pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+    }
+
+private:
+    sigset_t sigpipe;
+    sigset_t old_mask;
+    bool was_pending;
+};
+
+std::string home_dir_of(std::string const& username)
+{
+    std::vector<char> buffer(16384);
+    passwd pwd;
+    passwd* result{nullptr};
+
+    if (getpwnam_r(username.c_str(), &pwd, buffer.data(), buffer.size(), &result) != 0 ||
+        result == nullptr || result->pw_dir == nullptr)
+    {
+        return {};
+    }
+
+    return result->pw_dir;
+}
+
+// The display number part of names like ":0" or "host:0.1"
+std::string display_number_of(std::string const& display_name)
+{
+    auto const colon = display_name.rfind(':');
+    if (colon == std::string::npos)
+        return {};
+
+    auto const number = display_name.substr(colon + 1);
+    return number.substr(0, number.find('.'));
+}
+
+std::string read_cookie(
+    std::string const& xauthority_path, std::string const& display_number)
+{
+    auto const file = fopen(xauthority_path.c_str(), "rbe");
+    if (!file)
+        return {};
+
+    std::string cookie;
+
+    while (auto const auth = XauReadAuth(file))
+    {
+        std::string const name{auth->name, auth->name_length};
+        std::string const number{auth->number, auth->number_length};
+
+        if (cookie.empty() && name == cookie_auth_name &&
+            (number.empty() || number == display_number))
+        {
+            cookie.assign(auth->data, auth->data_length);
+        }
+
+        XauDisposeAuth(auth);
+    }
+
+    fclose(file);
+
+    return cookie;
+}
+
+}
+
+repowerd::X11DisplayConnection::X11DisplayConnection(
+    std::shared_ptr<Log> const& log,
+    std::string const& display_name,
+    std::string const& output_name)
+    : log{log},
+      display_name{display_name},
+      output_name{output_name},
+      display{nullptr},
+      connection_lost{false},
+      dpms_capable{false},
+      output{None},
+      output_crtc{None},
+      output_mode{None},
+      output_enabled{true},
+      num_connections_{0}
+{
+}
+
+repowerd::X11DisplayConnection::~X11DisplayConnection()
+{
+    disconnect();
+}
+
+void repowerd::X11DisplayConnection::set_user(std::string const& username)
+{
+    auto const home = username.empty() ? std::string{} : home_dir_of(username);
+    set_xauthority(home.empty() ? std::string{} : home + "/.Xauthority");
+}
+
+void repowerd::X11DisplayConnection::set_xauthority(std::string const& xauthority_path)
+{
+    if (xauthority_path == this->xauthority_path)
+        return;
+
+    log->log(log_tag, "set_xauthority(%s)", xauthority_path.c_str());
+
+    this->xauthority_path = xauthority_path;
+    disconnect();
+}
+
+bool repowerd::X11DisplayConnection::turn_on(bool enable_output)
+{
+    ScopedSigpipeBlock const sigpipe_block;
+
+    return with_io_error_recovery(
+        [this, enable_output]
+        {
+            if (!ensure_connected())
+                return false;
+
+            if (enable_output && !output_enabled)
+                set_output_enabled(true);
+
+            if (dpms_capable)
+                DPMSForceLevel(display, DPMSModeOn);
+
+            return flush() && (output_enabled || !enable_output);
+        });
+}
+
+bool repowerd::X11DisplayConnection::turn_off(bool disable_output)
+{
+    ScopedSigpipeBlock const sigpipe_block;
+
+    return with_io_error_recovery(
+        [this, disable_output]
+        {
+            if (!ensure_connected())
+                return false;
+
+            if (disable_output && output_enabled)
+                set_output_enabled(false);
+
+            if (dpms_capable)
+                DPMSForceLevel(display, DPMSModeOff);
+
+            // Without DPMS only disabling the output turns the display off
+            auto const turned_off = dpms_capable || (disable_output && !output_enabled);
+
+            return flush() && turned_off;
+        });
+}
+
+template <typename Requests>
+bool repowerd::X11DisplayConnection::with_io_error_recovery(Requests const& requests)
+{
+#ifdef REPOWERD_HAVE_XSETIOERROREXITHANDLER
+    return requests();
+#else
+    sigjmp_buf recovery;
+
+    if (sigsetjmp(recovery, 0))
+    {
+        // Xlib can't be used on the lost connection any more, not even to
+        // close it, so leave it behind
+        io_error_recovery = nullptr;
+        log->log(log_tag, "Lost connection to X display %s", display_name.c_str());
+        display = nullptr;
+        disconnect();
+        return false;
+    }
+
+    io_error_recovery = &recovery;
+    auto const result = requests();
+    io_error_recovery = nullptr;
+
+    return result;
+#endif
+}
+
+int repowerd::X11DisplayConnection::num_connections() const
+{
+    return num_connections_;
+}
+
+bool repowerd::X11DisplayConnection::ensure_connected()
+{
+    if (display && !connection_lost)
+        return true;
+
+    disconnect();
+
+    static std::once_flag error_handler_once;
+    std::call_once(
+        error_handler_once,
+        []
+        {
+            XSetErrorHandler(ignore_x_error);
+#ifndef REPOWERD_HAVE_XSETIOERROREXITHANDLER
+            XSetIOErrorHandler(recover_from_io_error);
+#endif
+        });
+
+    auto cookie = xauthority_path.empty() ?
+        std::string{} : read_cookie(xauthority_path, display_number_of(display_name));
+
+    if (!cookie.empty())
+    {
+        XSetAuthorization(
+            const_cast<char*>(cookie_auth_name), strlen(cookie_auth_name),
+            &cookie[0], cookie.size());
+    }
+
+    display = XOpenDisplay(display_name.c_str());
+
+    if (!cookie.empty())
+        XSetAuthorization(nullptr, 0, nullptr, 0);
+
+    if (!display)
+    {
+        REPOWERD_LOG_WARNING(*log, log_tag, "Failed to connect to X display %s", display_name.c_str());
+        return false;
+    }
+
+    ++num_connections_;
+    connection_lost = false;
+#ifdef REPOWERD_HAVE_XSETIOERROREXITHANDLER
+    XSetIOErrorExitHandler(display, mark_connection_lost, &connection_lost);
+#endif
+
+    int event_base{0};
+    int error_base{0};
+    dpms_capable = DPMSQueryExtension(display, &event_base, &error_base) &&
+                   DPMSCapable(display);
+    // Forcing a DPMS level fails unless DPMS is enabled, as xset does
+    if (dpms_capable)
+        DPMSEnable(display);
+
+    find_output();
+
+    log->log(log_tag, "Connected to X display %s, dpms=%s, output=%s",
+             display_name.c_str(),
+             dpms_capable ? "yes" : "no",
+             output != None ? output_name.c_str() : "(none)");
+
+    return true;
+}
+
+bool repowerd::X11DisplayConnection::flush()
+{
+    XFlush(display);
+
+    if (connection_lost)
+    {
+        log->log(log_tag, "Lost connection to X display %s", display_name.c_str());
+        disconnect();
+        return false;
+    }
+
+    return true;
+}
+
+void repowerd::X11DisplayConnection::disconnect()
+{
+    if (display)
+    {
+        ScopedSigpipeBlock const sigpipe_block;
+        XCloseDisplay(display);
+    }
+
+    display = nullptr;
+    connection_lost = false;
+    dpms_capable = false;
+    output = None;
+    output_crtc = None;
+    output_mode = None;
+    output_enabled = true;
+}
+
+void repowerd::X11DisplayConnection::find_output()
+{
+    int event_base{0};
+    int error_base{0};
+    if (!XRRQueryExtension(display, &event_base, &error_base))
+        return;
+
+    auto const resources = XRRGetScreenResourcesCurrent(display, DefaultRootWindow(display));
+    if (!resources)
+        return;
+
+    for (int i = 0; i < resources->noutput; ++i)
+    {
+        auto const info = XRRGetOutputInfo(display, resources, resources->outputs[i]);
+        if (!info)
+            continue;
+
+        if (output_name == std::string(info->name, info->nameLen))
+        {
+            output = resources->outputs[i];
+            output_crtc = info->crtc != None ? info->crtc :
+                          info->ncrtc > 0 ? info->crtcs[0] : None;
+            // Preferred modes come first, which is what xrandr --auto picks
+            output_mode = info->nmode > 0 ? info->modes[0] : None;
+            output_enabled = info->crtc != None;
+        }
+
+        XRRFreeOutputInfo(info);
+    }
+
+    XRRFreeScreenResources(resources);
+}
+
+void repowerd::X11DisplayConnection::set_output_enabled(bool enabled)
+{
+    if (output == None || output_crtc == None || output_mode == None)
+        return;
+
+    auto const resources = XRRGetScreenResourcesCurrent(display, DefaultRootWindow(display));
+    if (!resources)
+        return;
+
+    RROutput outputs[] = {output};
+    auto const status = enabled ?
+        XRRSetCrtcConfig(display, resources, output_crtc, CurrentTime,
+                         0, 0, output_mode, RR_Rotate_0, outputs, 1) :
+        XRRSetCrtcConfig(display, resources, output_crtc, CurrentTime,
+                         0, 0, None, RR_Rotate_0, nullptr, 0);
+
+    XRRFreeScreenResources(resources);
+
+    if (status == RRSetConfigSuccess)
+        output_enabled = enabled;
+    else
+        REPOWERD_LOG_WARNING(*log, log_tag, "Failed to %s output %s", enabled ? "enable" : "disable", output_name.c_str());
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+struct _XDisplay;
+
+namespace repowerd
+{
+class Log;
+
+// A long-lived connection to an X server used to change display power
+// with DPMS and RandR requests, instead of forking xset/xrandr.
+// Not thread safe; callers are expected to serialize access.
+class X11DisplayConnection
+{
+public:
+    X11DisplayConnection(
+        std::shared_ptr<Log> const& log,
+        std::string const& display_name,
+        std::string const& output_name);
+    ~X11DisplayConnection();
+
+    // Uses the Xauthority file of the given user from the next connection
+    // on, dropping the current connection if the user has changed
+    void set_user(std::string const& username);
+    void set_xauthority(std::string const& xauthority_path);
+
+    // Return false if the X server could not be reached, or could not be
+    // asked to reach the requested state (e.g. turning off without DPMS
+    // while leaving the output enabled)
+    bool turn_on(bool enable_output);
+    bool turn_off(bool disable_output);
+
+    int num_connections() const;
+
+private:
+    X11DisplayConnection(X11DisplayConnection const&) = delete;
+    X11DisplayConnection& operator=(X11DisplayConnection const&) = delete;
+
+    bool ensure_connected();
+    template <typename Requests>
+    bool with_io_error_recovery(Requests const& requests);
+    bool flush();
+    void disconnect();
+    void find_output();
+    void set_output_enabled(bool enabled);
+
+    std::shared_ptr<Log> const log;
+    std::string const display_name;
+    std::string const output_name;
+
+    std::string xauthority_path;
+    _XDisplay* display;
+    bool connection_lost;
+    bool dpms_capable;
+    unsigned long output;
+    unsigned long output_crtc;
+    unsigned long output_mode;
+    bool output_enabled;
+    int num_connections_;
+};
+
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace repowerd
+{
+
+// A move-only, type-erased void() callable. Callables that fit in
+// inline_size bytes are stored in place, so constructing, moving and
+// invoking an Action does not touch the allocator.
+class Action
+{
+public:
+    static std::size_t constexpr inline_size = 64;
+
+    Action() noexcept : ops{nullptr} {}
+
+    template <typename F,
+              typename = std::enable_if_t<!std::is_same<std::decay_t<F>, Action>::value>>
+    Action(F&& f)
+        : ops{&ops_for<std::decay_t<F>>::value}
+    {
+        ops_for<std::decay_t<F>>::construct(&storage, std::forward<F>(f));
+    }
+
+    Action(Action&& other) noexcept
+        : ops{other.ops}
+    {
+        if (ops)
+        {
+            ops->move(&storage, &other.storage);
+            other.ops = nullptr;
+        }
+    }
+
+    Action& operator=(Action&& other) noexcept
+    {
+        if (&other != this)
+        {
+            reset();
+            if (other.ops)
+            {
+                other.ops->move(&storage, &other.storage);
+                ops = other.ops;
+                other.ops = nullptr;
+            }
+        }
+
+        return *this;
+    }
+
+    ~Action() { reset(); }
+
+    void operator()() { ops->invoke(&storage); }
+
+    explicit operator bool() const noexcept { return ops != nullptr; }
+
+    void reset() noexcept
+    {
+        if (ops)
+        {
+            ops->destroy(&storage);
+            ops = nullptr;
+        }
+    }
+
+private:
+    Action(Action const&) = delete;
+    Action& operator=(Action const&) = delete;
+
+    using Storage = std::aligned_storage_t<inline_size, alignof(std::max_align_t)>;
+
+    struct Ops
+    {
+        void (*invoke)(void*);
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void*);
+    };
+
+    template <typename Callable>
+    static constexpr bool fits_inline()
+    {
+        return sizeof(Callable) <= inline_size &&
+               alignof(Callable) <= alignof(Storage) &&
+               std::is_nothrow_move_constructible<Callable>::value;
+    }
+
+    template <typename Callable, bool = fits_inline<Callable>()>
+    struct ops_for
+    {
+        template <typename F>
+        static void construct(void* s, F&& f)
+        {
+            new (s) Callable(std::forward<F>(f));
+        }
+        static void invoke(void* s) { (*static_cast<Callable*>(s))(); }
+        static void move(void* dst, void* src) noexcept
+        {
+            new (dst) Callable(std::move(*static_cast<Callable*>(src)));
+            static_cast<Callable*>(src)->~Callable();
+        }
+        static void destroy(void* s) noexcept { static_cast<Callable*>(s)->~Callable(); }
+        static Ops const value;
+    };
+
+    template <typename Callable>
+    struct ops_for<Callable, false>
+    {
+        template <typename F>
+        static void construct(void* s, F&& f)
+        {
+            new (s) Callable*(new Callable(std::forward<F>(f)));
+        }
+        static Callable*& ptr(void* s) { return *static_cast<Callable**>(s); }
+        static void invoke(void* s) { (*ptr(s))(); }
+        static void move(void* dst, void* src) noexcept
+        {
+            new (dst) Callable*(ptr(src));
+        }
+        static void destroy(void* s) noexcept { delete ptr(s); }
+        static Ops const value;
+    };
+
+    Storage storage;
+    Ops const* ops;
+};
+
+template <typename Callable, bool Inline>
+Action::Ops const Action::ops_for<Callable, Inline>::value{
+    &Action::ops_for<Callable, Inline>::invoke,
+    &Action::ops_for<Callable, Inline>::move,
+    &Action::ops_for<Callable, Inline>::destroy};
+
+template <typename Callable>
+Action::Ops const Action::ops_for<Callable, false>::value{
+    &Action::ops_for<Callable, false>::invoke,
+    &Action::ops_for<Callable, false>::move,
+    &Action::ops_for<Callable, false>::destroy};
+
+}
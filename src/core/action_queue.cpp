@@ -0,0 +1,224 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "action_queue.h"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <system_error>
+
+namespace
+{
+std::size_t const priority_capacity{16};
+
+bool is_power_of_two(std::size_t n)
+{
+    return n != 0 && (n & (n - 1)) == 0;
+}
+}
+
+repowerd::ActionQueue::Ring::Ring(std::size_t capacity)
+    : cells{new Cell[capacity]},
+      mask{capacity - 1},
+      enqueue_pos{0},
+      dequeue_pos{0},
+      overflowing{false}
+{
+    if (!is_power_of_two(capacity))
+        throw std::invalid_argument{"ActionQueue capacity must be a power of two"};
+
+    for (std::size_t i = 0; i < capacity; ++i)
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+void repowerd::ActionQueue::Ring::push(Action& action)
+{
+    if (!overflowing.load() && try_push_cell(action))
+        return;
+
+    std::lock_guard<std::mutex> lock{overflow_mutex};
+    overflowing.store(true);
+    overflow.push_back(std::move(action));
+}
+
+bool repowerd::ActionQueue::Ring::try_pop(Action& action)
+{
+    if (try_pop_cell(action))
+        return true;
+
+    // Spilled actions are newer than everything in the cells, so only take
+    // them once the cells are empty
+    if (!overflowing.load())
+        return false;
+
+    std::lock_guard<std::mutex> lock{overflow_mutex};
+
+    if (overflow.empty())
+        return false;
+
+    action = std::move(overflow.front());
+    overflow.pop_front();
+    if (overflow.empty())
+        overflowing.store(false);
+
+    return true;
+}
+
+bool repowerd::ActionQueue::Ring::try_push_cell(Action& action)
+{
+    auto pos = enqueue_pos.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+        auto& cell = cells[pos & mask];
+        auto const seq = cell.sequence.load(std::memory_order_acquire);
+        auto const diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+
+        if (diff == 0)
+        {
+            if (enqueue_pos.compare_exchange_weak(
+                    pos, pos + 1, std::memory_order_relaxed))
+            {
+                cell.action = std::move(action);
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool repowerd::ActionQueue::Ring::try_pop_cell(Action& action)
+{
+    auto& cell = cells[dequeue_pos & mask];
+    auto const seq = cell.sequence.load(std::memory_order_acquire);
+
+    if (seq != dequeue_pos + 1)
+        return false;
+
+    action = std::move(cell.action);
+    cell.sequence.store(dequeue_pos + mask + 1, std::memory_order_release);
+    ++dequeue_pos;
+
+    return true;
+}
+
+repowerd::ActionQueue::ActionQueue(std::size_t capacity)
+    : priority_ring{priority_capacity},
+      ring{capacity},
+      event_fd{eventfd(0, EFD_CLOEXEC)},
+      consumer_waiting{true}
+{
+    if (event_fd == -1)
+        throw std::system_error{errno, std::system_category(), "Failed to create eventfd"};
+}
+
+repowerd::ActionQueue::~ActionQueue()
+{
+    close(event_fd);
+}
+
+void repowerd::ActionQueue::push(Action&& action)
+{
+    push_to(ring, std::move(action));
+}
+
+void repowerd::ActionQueue::push_priority(Action&& action)
+{
+    push_to(priority_ring, std::move(action));
+}
+
+void repowerd::ActionQueue::push_to(Ring& target, Action&& action)
+{
+    target.push(action);
+    wake_consumer();
+}
+
+void repowerd::ActionQueue::wake_consumer()
+{
+    // The exchange pairs with the one in pop(), so either the consumer sees
+    // our action on its re-check or we see that it is about to sleep
+    if (consumer_waiting.exchange(false))
+    {
+        uint64_t const one{1};
+        while (write(event_fd, &one, sizeof(one)) == -1 && errno == EINTR)
+            continue;
+    }
+}
+
+repowerd::Action repowerd::ActionQueue::pop()
+{
+    Action action;
+
+    while (true)
+    {
+        if (priority_ring.try_pop(action) || ring.try_pop(action))
+            return action;
+
+        consumer_waiting.exchange(true);
+
+        // Re-check after announcing that we are about to sleep, so that
+        // a push racing with the check above is not missed
+        if (priority_ring.try_pop(action) || ring.try_pop(action))
+        {
+            consumer_waiting.store(false);
+            return action;
+        }
+
+        uint64_t count;
+        while (read(event_fd, &count, sizeof(count)) == -1 && errno == EINTR)
+            continue;
+    }
+}
+
+bool repowerd::ActionQueue::try_pop(Action& action)
+{
+    if (priority_ring.try_pop(action) || ring.try_pop(action))
+        return true;
+
+    consumer_waiting.exchange(true);
+
+    if (priority_ring.try_pop(action) || ring.try_pop(action))
+    {
+        consumer_waiting.store(false);
+        return true;
+    }
+
+    return false;
+}
+
+int repowerd::ActionQueue::wakeup_fd() const
+{
+    return event_fd;
+}
+
+void repowerd::ActionQueue::clear_wakeup()
+{
+    uint64_t count;
+    while (read(event_fd, &count, sizeof(count)) == -1 && errno == EINTR)
+        continue;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "action.h"
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace repowerd
+{
+
+// Lock-free multi-producer/single-consumer queue of Actions.
+// Producers only take a lock when a ring is full, to spill into an
+// overflow list instead of waiting for the consumer, which may well be the
+// pushing thread itself. The consumer sleeps on an eventfd when both the
+// priority and the normal ring are empty.
+class ActionQueue
+{
+public:
+    ActionQueue(std::size_t capacity);
+    ~ActionQueue();
+
+    // Safe to call from any thread, including the consumer. Never blocks.
+    void push(Action&& action);
+    void push_priority(Action&& action);
+
+    // Must only be called from a single consumer thread
+    Action pop();
+
+    // Non-blocking alternative to pop(), for consumers that poll
+    // wakeup_fd() in their own main loop instead. When the queue is found
+    // empty, wakeup_fd() becomes readable on the next push; the consumer
+    // must then call clear_wakeup() before draining again.
+    bool try_pop(Action& action);
+    int wakeup_fd() const;
+    void clear_wakeup();
+
+private:
+    ActionQueue(ActionQueue const&) = delete;
+    ActionQueue& operator=(ActionQueue const&) = delete;
+
+    class Ring
+    {
+    public:
+        Ring(std::size_t capacity);
+
+        void push(Action& action);
+        bool try_pop(Action& action);
+
+    private:
+        bool try_push_cell(Action& action);
+        bool try_pop_cell(Action& action);
+
+        struct Cell
+        {
+            std::atomic<std::size_t> sequence;
+            Action action;
+        };
+
+        std::unique_ptr<Cell[]> const cells;
+        std::size_t const mask;
+        std::atomic<std::size_t> enqueue_pos;
+        std::size_t dequeue_pos;
+
+        // Once an action has spilled, later ones follow it into the
+        // overflow list until the consumer has emptied it, to keep each
+        // producer's actions in order
+        std::atomic<bool> overflowing;
+        std::mutex overflow_mutex;
+        std::deque<Action> overflow;
+    };
+
+    void push_to(Ring& ring, Action&& action);
+    void wake_consumer();
+
+    Ring priority_ring;
+    Ring ring;
+    int const event_fd;
+    std::atomic<bool> consumer_waiting;
+};
+
+}
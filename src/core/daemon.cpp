@@ -47,6 +47,127 @@
 
 char const* const log_tag = "Daemon";
 
+namespace
+{
+std::size_t const action_queue_capacity{1024};
+
+// The pending user activity action is tracked together with the number of
+// actions being pushed to the queue, in a single word, as
+// (actions in flight << 4) | mergeable bit | tail bit | type bits,
+// so that queuing an action and merging into the pending activity action
+// can't interleave. No type bits means no activity action is pending. The
+// tail bit is set while no action has been queued after it, if none was
+// still being pushed when it was queued (and so could end up behind it in
+// the queue); it becomes mergeable once it has been pushed itself.
+uint64_t const extend_power_state_bit{1};
+uint64_t const change_power_state_bit{2};
+uint64_t const tail_bit{4};
+uint64_t const mergeable_bit{8};
+uint64_t const one_in_flight{16};
+
+uint64_t user_activity_bit(repowerd::UserActivityType type)
+{
+    return type == repowerd::UserActivityType::change_power_state ?
+        change_power_state_bit : extend_power_state_bit;
+}
+
+uint64_t pending_type_bits(uint64_t state) { return state & 3; }
+uint64_t in_flight(uint64_t state) { return state / one_in_flight; }
+}
+
+// Wraps an action so that the time from event ingress (i.e. when the
+// adapter invokes our handler) to dequeue and to handler completion is
+// recorded in the event latency stats
+template <typename Callable>
+auto repowerd::Daemon::traced(EventType type, Callable&& callable)
+{
+    auto const ingress = std::chrono::steady_clock::now();
+
+    return
+        [this, type, ingress, callable]
+        {
+            auto const dequeued = std::chrono::steady_clock::now();
+            callable();
+            event_latency_stats->record(
+                type, ingress, dequeued, std::chrono::steady_clock::now());
+        };
+}
+
+template <typename SessionAction>
+void repowerd::Daemon::enqueue_action_to_active_session(
+    SessionAction&& session_action)
+{
+    enqueue_action(
+        [this, session_action] { session_action(active_session); });
+}
+
+template <typename SessionAction>
+void repowerd::Daemon::enqueue_action_to_active_session(
+    EventType type, SessionAction&& session_action)
+{
+    enqueue_action(
+        traced(type, [this, session_action] { session_action(active_session); }));
+}
+
+template <typename SessionAction>
+void repowerd::Daemon::enqueue_action_to_all_sessions(
+    SessionAction&& session_action)
+{
+    enqueue_action(
+        [this, session_action]
+        {
+            for (auto& kv : sessions)
+                session_action(&kv.second);
+        });
+}
+
+template <typename SessionAction>
+void repowerd::Daemon::enqueue_action_to_all_sessions(
+    EventType type, SessionAction&& session_action)
+{
+    enqueue_action(
+        traced(type,
+            [this, session_action]
+            {
+                for (auto& kv : sessions)
+                    session_action(&kv.second);
+            }));
+}
+
+template <typename SessionAction>
+void repowerd::Daemon::enqueue_action_to_sessions(
+    std::vector<std::string>&& target_sessions,
+    SessionAction&& session_action)
+{
+    enqueue_action(
+        [this, target_sessions = std::move(target_sessions), session_action]
+        {
+            for (auto const& session_id : target_sessions)
+            {
+                auto const iter = sessions.find(session_id);
+                if (iter != sessions.end())
+                    session_action(&iter->second);
+            }
+        });
+}
+
+template <typename SessionAction>
+void repowerd::Daemon::enqueue_action_to_sessions(
+    std::function<std::vector<std::string>()>&& sessions_func,
+    SessionAction&& session_action)
+{
+    enqueue_action(
+        [this, sessions_func = std::move(sessions_func), session_action]
+        {
+            for (auto const& session_id : sessions_func())
+            {
+                auto const iter = sessions.find(session_id);
+                if (iter != sessions.end())
+                    session_action(&iter->second);
+            }
+        });
+}
+
 repowerd::Daemon::Session::Session(
     std::shared_ptr<StateMachine> const& state_machine)
     : state_machine{state_machine},
@@ -57,6 +178,7 @@ repowerd::Daemon::Session::Session(
 repowerd::Daemon::Daemon(DaemonConfig& config)
     : the_log{config.the_log()},
       the_exec{config.the_exec()},
+      event_latency_stats{config.the_event_latency_stats()},
       brightness_control{config.the_brightness_control()},
       client_requests{config.the_client_requests()},
       client_settings{config.the_client_settings()},
@@ -74,7 +196,11 @@ repowerd::Daemon::Daemon(DaemonConfig& config)
       timer{config.the_timer()},
       user_activity{config.the_user_activity()},
       voice_call_service{config.the_voice_call_service()},
-      running{false}
+      running{false},
+      action_queue{action_queue_capacity},
+      action_queue_state{0},
+      user_activity_dispatched{0},
+      user_activity_merged{0}
 {
     sessions.emplace(repowerd::invalid_session_id, Session{std::make_shared<NullStateMachine>()});
     active_session = &sessions.at(repowerd::invalid_session_id);
@@ -89,7 +215,7 @@ void repowerd::Daemon::run()
 
     while (running)
     {
-        auto const ev = dequeue_action();
+        auto ev = dequeue_action();
         ev();
     }
 }
@@ -123,11 +249,13 @@ repowerd::Daemon::register_event_handlers()
                 if (state == PowerButtonState::released)
                 {
                     enqueue_action_to_active_session(
+                        EventType::power_button_release,
                         [this] (Session* s) { s->state_machine->handle_power_button_release(); });
                 }
                 else
                 {
                     enqueue_action_to_active_session(
+                        EventType::power_button_press,
                         [this, state] (Session* s) { s->state_machine->handle_power_button_press(state); });
                 }
             }));
@@ -137,24 +265,13 @@ repowerd::Daemon::register_event_handlers()
             [this] (AlarmId id)
             {
                 enqueue_action_to_all_sessions(
+                    EventType::alarm,
                     [this, id] (Session* s) { s->state_machine->handle_alarm(id); });
             }));
 
     registrations.push_back(
         user_activity->register_user_activity_handler(
-            [this] (UserActivityType type)
-            {
-                if (type == UserActivityType::change_power_state)
-                {
-                    enqueue_action_to_active_session(
-                        [this] (Session* s) { s->state_machine->handle_user_activity_changing_power_state(); });
-                }
-                else if (type == UserActivityType::extend_power_state)
-                {
-                    enqueue_action_to_active_session(
-                        [this] (Session* s) { s->state_machine->handle_user_activity_extending_power_state(); });
-                }
-            }));
+            [this] (UserActivityType type) { enqueue_user_activity(type); }));
 
     registrations.push_back(
         proximity_sensor->register_proximity_handler(
@@ -163,11 +280,13 @@ repowerd::Daemon::register_event_handlers()
                 if (state == ProximityState::far)
                 {
                     enqueue_action_to_active_session(
+                        EventType::proximity_far,
                         [this] (Session* s) { s->state_machine->handle_proximity_far(); });
                 }
                 else if (state == ProximityState::near)
                 {
                     enqueue_action_to_active_session(
+                        EventType::proximity_near,
                         [this] (Session* s) { s->state_machine->handle_proximity_near(); });
                 }
             }));
@@ -321,6 +440,7 @@ repowerd::Daemon::register_event_handlers()
             [this]
             {
                 enqueue_action_to_active_session(
+                    EventType::power_source_change,
                     [this] (Session* s) { s->state_machine->handle_power_source_change(); });
             }));
 
@@ -329,6 +449,7 @@ repowerd::Daemon::register_event_handlers()
             [this]
             {
                 enqueue_action_to_active_session(
+                    EventType::power_source_critical,
                     [this] (Session* s) { s->state_machine->handle_power_source_critical(); });
             }));
 
@@ -359,11 +480,13 @@ repowerd::Daemon::register_event_handlers()
                 if (lid_state == LidState::closed)
                 {
                     enqueue_action_to_active_session(
+                        EventType::lid,
                         [this] (Session* s) { s->state_machine->handle_lid_closed(); });
                 }
                 else if (lid_state == LidState::open)
                 {
                     enqueue_action_to_active_session(
+                        EventType::lid,
                         [this] (Session* s) { s->state_machine->handle_lid_open(); });
                 }
             }));
@@ -421,11 +544,13 @@ repowerd::Daemon::register_event_handlers()
                 if (lock_state == LockState::active)
                 {
                     enqueue_action_to_active_session(
+                        EventType::lock,
                         [this] (Session* s) { s->state_machine->handle_lock_active(); });
                 }
                 else if (lock_state == LockState::inactive)
                 {
                     enqueue_action_to_active_session(
+                        EventType::lock,
                         [this] (Session* s) { s->state_machine->handle_lock_inactive(); });
                 }
             }));
@@ -475,6 +600,7 @@ repowerd::Daemon::register_event_handlers()
             [this]
             {
                 enqueue_action_to_active_session(
+                    EventType::system_resume,
                     [this] (Session* s) { s->state_machine->handle_system_resume(); });
             }));
 
@@ -518,80 +644,120 @@ void repowerd::Daemon::start_event_processing()
     voice_call_service->start_processing();
 }
 
-void repowerd::Daemon::enqueue_action(Action const& action)
+void repowerd::Daemon::enqueue_action(Action&& action)
 {
-    std::lock_guard<std::mutex> lock{action_queue_mutex};
-
-    action_queue.push_back(action);
-    action_queue_cv.notify_one();
+    begin_queuing_action();
+    action_queue.push(std::move(action));
+    end_queuing_action();
 }
 
-void repowerd::Daemon::enqueue_priority_action(Action const& action)
+void repowerd::Daemon::enqueue_priority_action(Action&& action)
 {
-    std::lock_guard<std::mutex> lock{action_queue_mutex};
-
-    action_queue.push_front(action);
-    action_queue_cv.notify_one();
+    begin_queuing_action();
+    action_queue.push_priority(std::move(action));
+    end_queuing_action();
 }
 
-void repowerd::Daemon::enqueue_action_to_active_session(
-    SessionAction const& session_action)
+void repowerd::Daemon::begin_queuing_action()
 {
-    enqueue_action(
-        [this, session_action] { session_action(active_session); });
+    // Nothing can be merged behind this action any more
+    auto state = action_queue_state.load();
+    while (!action_queue_state.compare_exchange_weak(
+               state, (state & ~(tail_bit | mergeable_bit)) + one_in_flight))
+    {
+        continue;
+    }
 }
 
-void repowerd::Daemon::enqueue_action_to_all_sessions(
-    SessionAction const& session_action)
+void repowerd::Daemon::end_queuing_action()
 {
-    enqueue_action(
-        [this, session_action]
-        {
-            for (auto& kv : sessions)
-                session_action(&kv.second);
-        });
+    action_queue_state.fetch_sub(one_in_flight);
 }
 
-void repowerd::Daemon::enqueue_action_to_sessions(
-    std::vector<std::string> const& target_sessions,
-    SessionAction const& session_action)
+repowerd::Action repowerd::Daemon::dequeue_action()
 {
-    enqueue_action(
-        [this, target_sessions, session_action]
-        {
-            for (auto const& session_id : target_sessions)
-            {
-                auto const iter = sessions.find(session_id);
-                if (iter != sessions.end())
-                    session_action(&iter->second);
-            }
-        });
+    return action_queue.pop();
 }
 
-void repowerd::Daemon::enqueue_action_to_sessions(
-    std::function<std::vector<std::string>()> const& sessions_func,
-    SessionAction const& session_action)
+// Bursts of user activity (e.g. sustained touch input) are collapsed into
+// the activity action that is already at the tail of the queue, as long as
+// no other action has been queued after it. A merged activity thus keeps
+// its order relative to all other actions, and is just handled earlier.
+// A changing activity subsumes an extending one, so merging only ever
+// upgrades the pending type.
+void repowerd::Daemon::enqueue_user_activity(UserActivityType type)
 {
-    enqueue_action(
-        [this, sessions_func, session_action]
+    auto const bit = user_activity_bit(type);
+    auto state = action_queue_state.load();
+    bool mergeable;
+
+    while (true)
+    {
+        if (state & mergeable_bit)
         {
-            for (auto const& session_id : sessions_func())
+            if (action_queue_state.compare_exchange_weak(state, state | bit))
             {
-                auto const iter = sessions.find(session_id);
-                if (iter != sessions.end())
-                    session_action(&iter->second);
+                ++user_activity_merged;
+                return;
             }
-        });
+            continue;
+        }
+
+        // Only one activity action can be pending for merging at a time;
+        // if another one is still queued this action is dispatched as-is
+        mergeable = pending_type_bits(state) == 0;
+
+        auto new_state = (state & ~tail_bit) + one_in_flight;
+        if (mergeable)
+        {
+            new_state |= bit;
+            if (in_flight(state) == 0)
+                new_state |= tail_bit;
+        }
+
+        if (action_queue_state.compare_exchange_weak(state, new_state))
+            break;
+    }
+
+    action_queue.push(
+        traced(EventType::user_activity,
+            [this, type, mergeable] { dispatch_user_activity(mergeable, type); }));
+
+    state = action_queue_state.load();
+    uint64_t new_state;
+
+    do
+    {
+        new_state = state - one_in_flight;
+        if (mergeable && (state & tail_bit))
+            new_state |= mergeable_bit;
+    }
+    while (!action_queue_state.compare_exchange_weak(state, new_state));
 }
 
-repowerd::Daemon::Action repowerd::Daemon::dequeue_action()
+void repowerd::Daemon::dispatch_user_activity(
+    bool mergeable, UserActivityType type)
 {
-    std::unique_lock<std::mutex> lock{action_queue_mutex};
+    if (mergeable)
+    {
+        // Take the merged types, leaving the actions in flight as they are
+        auto const taken = action_queue_state.fetch_and(~(one_in_flight - 1));
+        if (pending_type_bits(taken) & change_power_state_bit)
+            type = UserActivityType::change_power_state;
+    }
 
-    action_queue_cv.wait(lock, [this] { return !action_queue.empty(); });
-    auto ev = action_queue.front();
-    action_queue.pop_front();
-    return ev;
+    ++user_activity_dispatched;
+
+    if (type == UserActivityType::change_power_state)
+        active_session->state_machine->handle_user_activity_changing_power_state();
+    else
+        active_session->state_machine->handle_user_activity_extending_power_state();
+}
+
+repowerd::Daemon::UserActivityCounters
+repowerd::Daemon::user_activity_counters() const
+{
+    return {user_activity_dispatched.load(), user_activity_merged.load()};
 }
 
 void repowerd::Daemon::handle_session_activated(
@@ -18,16 +18,18 @@
 
 #pragma once
 
+#include "action_queue.h"
 #include "daemon_config.h"
+#include "event_latency.h"
 #include "handler_registration.h"
 #include "state_event_adapter.h"
 #include "session_tracker.h"
+#include "user_activity.h"
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <vector>
-#include <deque>
-#include <mutex>
-#include <condition_variable>
 #include <functional>
 #include <unordered_map>
 #include <string>
@@ -44,6 +46,14 @@ public:
     void stop();
     void flush();
 
+    struct UserActivityCounters
+    {
+        uint64_t dispatched;
+        uint64_t merged;
+    };
+
+    UserActivityCounters user_activity_counters() const;
+
 private:
     struct Session
     {
@@ -52,22 +62,33 @@ private:
         StateEventAdapter state_event_adapter;
     };
 
-    using Action = std::function<void()>;
-    using SessionAction = std::function<void(Session*)>;
-
     std::vector<HandlerRegistration> register_event_handlers();
     void start_event_processing();
-    void enqueue_action(Action const& action);
-    void enqueue_priority_action(Action const& action);
-    void enqueue_action_to_active_session(SessionAction const& action);
-    void enqueue_action_to_all_sessions(SessionAction const& action);
+    void enqueue_action(Action&& action);
+    void enqueue_priority_action(Action&& action);
+    void begin_queuing_action();
+    void end_queuing_action();
+    template <typename Callable>
+    auto traced(EventType type, Callable&& callable);
+    template <typename SessionAction>
+    void enqueue_action_to_active_session(SessionAction&& action);
+    template <typename SessionAction>
+    void enqueue_action_to_active_session(EventType type, SessionAction&& action);
+    template <typename SessionAction>
+    void enqueue_action_to_all_sessions(SessionAction&& action);
+    template <typename SessionAction>
+    void enqueue_action_to_all_sessions(EventType type, SessionAction&& action);
+    template <typename SessionAction>
     void enqueue_action_to_sessions(
-        std::vector<std::string> const& sessions,
-        SessionAction const& action);
+        std::vector<std::string>&& sessions,
+        SessionAction&& action);
+    template <typename SessionAction>
     void enqueue_action_to_sessions(
-        std::function<std::vector<std::string>()> const& sessions_func,
-        SessionAction const& action);
+        std::function<std::vector<std::string>()>&& sessions_func,
+        SessionAction&& action);
     Action dequeue_action();
+    void enqueue_user_activity(UserActivityType type);
+    void dispatch_user_activity(bool mergeable, UserActivityType type);
 
     void handle_session_activated(std::string const&, repowerd::SessionType);
     void handle_session_removed(std::string const&);
@@ -77,6 +98,7 @@ private:
 
     std::shared_ptr<Log> const the_log;
     std::shared_ptr<Exec> const the_exec;
+    std::shared_ptr<EventLatencyStats> const event_latency_stats;
     std::shared_ptr<BrightnessControl> const brightness_control;
     std::shared_ptr<ClientRequests> const client_requests;
     std::shared_ptr<ClientSettings> const client_settings;
@@ -101,9 +123,11 @@ private:
     std::vector<std::string> sessions_with_active_calls;
     Session* active_session;
 
-    std::mutex action_queue_mutex;
-    std::condition_variable action_queue_cv;
-    std::deque<Action> action_queue;
+    ActionQueue action_queue;
+    // Actions in flight and pending user activity, see daemon.cpp
+    std::atomic<uint64_t> action_queue_state;
+    std::atomic<uint64_t> user_activity_dispatched;
+    std::atomic<uint64_t> user_activity_merged;
 };
 
 }
@@ -30,6 +30,7 @@ class ClientRequests;
 class ClientSettings;
 class DisplayPowerControl;
 class DisplayPowerEventSink;
+class EventLatencyStats;
 class Lid;
 class Lock;
 class Log;
@@ -63,6 +64,7 @@ public:
     virtual std::shared_ptr<ClientSettings> the_client_settings() = 0;
     virtual std::shared_ptr<DisplayPowerControl> the_display_power_control() = 0;
     virtual std::shared_ptr<DisplayPowerEventSink> the_display_power_event_sink() = 0;
+    virtual std::shared_ptr<EventLatencyStats> the_event_latency_stats() = 0;
     virtual std::shared_ptr<Lid> the_lid() = 0;
     virtual std::shared_ptr<Lock> the_lock() = 0;
     virtual std::shared_ptr<Log> the_log() = 0;
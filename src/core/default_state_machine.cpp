@@ -631,7 +631,7 @@ void repowerd::DefaultStateMachine::handle_proximity_near()
 
 void repowerd::DefaultStateMachine::handle_user_activity_changing_power_state()
 {
-    log->log(log_tag, "handle_user_activity_changing_power_state - %d", display_power_mode==DisplayPowerMode::on);
+    REPOWERD_LOG_DEBUG(*log, log_tag, "handle_user_activity_changing_power_state - %d", display_power_mode==DisplayPowerMode::on);
 
     if (display_power_mode == DisplayPowerMode::on)
     {
@@ -647,7 +647,7 @@ void repowerd::DefaultStateMachine::handle_user_activity_changing_power_state()
 
 void repowerd::DefaultStateMachine::handle_user_activity_extending_power_state()
 {
-    log->log(log_tag, "handle_user_activity_extending_power_state - %d", display_power_mode==DisplayPowerMode::on);
+    REPOWERD_LOG_DEBUG(*log, log_tag, "handle_user_activity_extending_power_state - %d", display_power_mode==DisplayPowerMode::on);
 
     if (display_power_mode == DisplayPowerMode::on)
     {
@@ -830,6 +830,16 @@ void repowerd::DefaultStateMachine::cancel_notification_expiration_alarm()
     }
 }
 
+void repowerd::DefaultStateMachine::reschedule_alarm_in(
+    AlarmId& id, std::chrono::milliseconds t)
+{
+    // Extending a pending alarm in place is cheaper than cancelling it and
+    // scheduling a new one, which matters since this runs on every bit of
+    // user activity
+    if (id == AlarmId::invalid || !timer->extend_alarm_in(id, t))
+        id = timer->schedule_alarm_in(t);
+}
+
 void repowerd::DefaultStateMachine::schedule_normal_user_inactivity_alarm()
 {
     schedule_normal_user_inactivity_display_off_alarm();
@@ -838,39 +848,50 @@ void repowerd::DefaultStateMachine::schedule_normal_user_inactivity_alarm()
 
 void repowerd::DefaultStateMachine::schedule_normal_user_inactivity_display_off_alarm()
 {
-    cancel_user_inactivity_display_off_alarm();
-    scheduled_timeout_type = ScheduledTimeoutType::normal;
-
     if (user_inactivity_normal_display_off_timeout.get() == repowerd::infinite_timeout)
     {
+        cancel_user_inactivity_display_off_alarm();
+        scheduled_timeout_type = ScheduledTimeoutType::normal;
         user_inactivity_display_off_time_point = std::chrono::steady_clock::time_point::max();
     }
     else
     {
+        scheduled_timeout_type = ScheduledTimeoutType::normal;
         user_inactivity_display_off_time_point =
             timer->now() + user_inactivity_normal_display_off_timeout.get();
+
         if (user_inactivity_normal_display_off_timeout.get() > user_inactivity_normal_display_dim_duration)
         {
-            user_inactivity_display_dim_alarm_id =
-                timer->schedule_alarm_in(
-                    user_inactivity_normal_display_off_timeout.get() -
-                    user_inactivity_normal_display_dim_duration);
+            reschedule_alarm_in(
+                user_inactivity_display_dim_alarm_id,
+                user_inactivity_normal_display_off_timeout.get() -
+                user_inactivity_normal_display_dim_duration);
+        }
+        else if (user_inactivity_display_dim_alarm_id != AlarmId::invalid)
+        {
+            timer->cancel_alarm(user_inactivity_display_dim_alarm_id);
+            user_inactivity_display_dim_alarm_id = AlarmId::invalid;
         }
 
-        user_inactivity_display_off_alarm_id =
-            timer->schedule_alarm_in(user_inactivity_normal_display_off_timeout.get());
+        reschedule_alarm_in(
+            user_inactivity_display_off_alarm_id,
+            user_inactivity_normal_display_off_timeout.get());
     }
 }
 
 void repowerd::DefaultStateMachine::schedule_normal_user_inactivity_suspend_alarm()
 {
-    cancel_user_inactivity_suspend_alarm();
     cancel_suspend_when_allowed();
 
     if (user_inactivity_normal_suspend_timeout.get() != repowerd::infinite_timeout)
     {
-        user_inactivity_suspend_alarm_id =
-            timer->schedule_alarm_in(user_inactivity_normal_suspend_timeout.get());
+        reschedule_alarm_in(
+            user_inactivity_suspend_alarm_id,
+            user_inactivity_normal_suspend_timeout.get());
+    }
+    else
+    {
+        cancel_user_inactivity_suspend_alarm();
     }
 }
 
@@ -127,6 +127,7 @@ private:
     void cancel_user_inactivity_display_off_alarm();
     void cancel_user_inactivity_suspend_alarm();
     void cancel_notification_expiration_alarm();
+    void reschedule_alarm_in(AlarmId& id, std::chrono::milliseconds t);
     void schedule_normal_user_inactivity_alarm();
     void schedule_normal_user_inactivity_display_off_alarm();
     void schedule_normal_user_inactivity_suspend_alarm();
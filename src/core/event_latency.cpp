@@ -0,0 +1,158 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "event_latency.h"
+
+#include <algorithm>
+
+namespace
+{
+
+using namespace std::chrono;
+
+std::size_t const linear_buckets{16};
+std::size_t const sub_bucket_bits{3};
+
+std::size_t bucket_for(uint64_t us)
+{
+    if (us < linear_buckets)
+        return us;
+
+    auto const msb = 63 - __builtin_clzll(us);
+    auto const sub = (us >> (msb - sub_bucket_bits)) & ((1u << sub_bucket_bits) - 1);
+    auto const index = linear_buckets + (msb - 4) * (1u << sub_bucket_bits) + sub;
+
+    return std::min<std::size_t>(
+        index, repowerd::EventLatencyStats::num_histogram_buckets - 1);
+}
+
+uint64_t bucket_upper_bound(std::size_t index)
+{
+    if (index < linear_buckets)
+        return index;
+
+    auto const msb = (index - linear_buckets) / (1u << sub_bucket_bits) + 4;
+    auto const sub = (index - linear_buckets) % (1u << sub_bucket_bits);
+    auto const width = uint64_t{1} << (msb - sub_bucket_bits);
+
+    return (uint64_t{1} << msb) + (sub + 1) * width - 1;
+}
+
+uint64_t to_us(repowerd::EventLatencyStats::TimePoint::duration d)
+{
+    auto const us = duration_cast<microseconds>(d).count();
+    return us < 0 ? 0 : us;
+}
+
+}
+
+char const* repowerd::event_type_to_string(EventType type)
+{
+    switch (type)
+    {
+    case EventType::alarm: return "alarm";
+    case EventType::power_button_press: return "power_button_press";
+    case EventType::power_button_release: return "power_button_release";
+    case EventType::proximity_near: return "proximity_near";
+    case EventType::proximity_far: return "proximity_far";
+    case EventType::user_activity: return "user_activity";
+    case EventType::lid: return "lid";
+    case EventType::lock: return "lock";
+    case EventType::power_source_change: return "power_source_change";
+    case EventType::power_source_critical: return "power_source_critical";
+    case EventType::system_resume: return "system_resume";
+    case EventType::wakeup: return "wakeup";
+    case EventType::count: break;
+    }
+
+    return "unknown";
+}
+
+repowerd::EventLatencyStats::Histogram::Histogram()
+    : total{0},
+      max_value{0}
+{
+    for (auto& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+void repowerd::EventLatencyStats::Histogram::add(microseconds value)
+{
+    uint64_t const us = value.count() < 0 ? 0 : value.count();
+
+    buckets[bucket_for(us)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+
+    auto current_max = max_value.load(std::memory_order_relaxed);
+    while (us > current_max &&
+           !max_value.compare_exchange_weak(current_max, us, std::memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t repowerd::EventLatencyStats::Histogram::count() const
+{
+    return total.load(std::memory_order_relaxed);
+}
+
+microseconds repowerd::EventLatencyStats::Histogram::percentile(double p) const
+{
+    auto const n = count();
+    if (n == 0)
+        return microseconds{0};
+
+    auto const rank = static_cast<uint64_t>(p * (n - 1)) + 1;
+    uint64_t seen = 0;
+
+    for (std::size_t i = 0; i < num_histogram_buckets; ++i)
+    {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+            return microseconds{std::min(bucket_upper_bound(i), max_value.load())};
+    }
+
+    return max();
+}
+
+microseconds repowerd::EventLatencyStats::Histogram::max() const
+{
+    return microseconds{max_value.load(std::memory_order_relaxed)};
+}
+
+repowerd::EventLatencyStats::EventLatencyStats() = default;
+
+void repowerd::EventLatencyStats::record(
+    EventType type, TimePoint ingress, TimePoint dequeued, TimePoint completed)
+{
+    auto& entry = entries[static_cast<std::size_t>(type)];
+
+    entry.queue.add(microseconds{to_us(dequeued - ingress)});
+    entry.total.add(microseconds{to_us(completed - ingress)});
+}
+
+repowerd::EventLatencySummary repowerd::EventLatencyStats::summary(EventType type) const
+{
+    auto const& entry = entries[static_cast<std::size_t>(type)];
+
+    return {
+        entry.total.count(),
+        entry.queue.percentile(0.50),
+        entry.queue.percentile(0.99),
+        entry.queue.max(),
+        entry.total.percentile(0.50),
+        entry.total.percentile(0.99),
+        entry.total.max()};
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace repowerd
+{
+
+enum class EventType
+{
+    alarm,
+    power_button_press,
+    power_button_release,
+    proximity_near,
+    proximity_far,
+    user_activity,
+    lid,
+    lock,
+    power_source_change,
+    power_source_critical,
+    system_resume,
+    // Queue latency is from the wakeup timer expiring to the wakeup handler
+    wakeup,
+    count
+};
+
+char const* event_type_to_string(EventType type);
+
+struct EventLatencySummary
+{
+    uint64_t count;
+    // Ingress to dequeue by the daemon thread
+    std::chrono::microseconds queue_p50;
+    std::chrono::microseconds queue_p99;
+    std::chrono::microseconds queue_max;
+    // Ingress to completion of the state machine handler
+    std::chrono::microseconds total_p50;
+    std::chrono::microseconds total_p99;
+    std::chrono::microseconds total_max;
+};
+
+// Per event type latency histograms. Recording and querying are lock-free,
+// so stats can be queried from any thread while the daemon records them.
+// Percentiles are approximate: values are kept in log-linear buckets with
+// 8 sub-buckets per power of two, i.e. within 12.5% of the true value.
+class EventLatencyStats
+{
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+    static std::size_t constexpr num_histogram_buckets{16 + 28 * 8};
+
+    EventLatencyStats();
+
+    void record(EventType type, TimePoint ingress, TimePoint dequeued, TimePoint completed);
+    EventLatencySummary summary(EventType type) const;
+
+private:
+    EventLatencyStats(EventLatencyStats const&) = delete;
+    EventLatencyStats& operator=(EventLatencyStats const&) = delete;
+
+    class Histogram
+    {
+    public:
+        Histogram();
+
+        void add(std::chrono::microseconds value);
+        uint64_t count() const;
+        std::chrono::microseconds percentile(double p) const;
+        std::chrono::microseconds max() const;
+
+    private:
+        std::array<std::atomic<uint32_t>, num_histogram_buckets> buckets;
+        std::atomic<uint64_t> total;
+        std::atomic<uint64_t> max_value;
+    };
+
+    struct Entry
+    {
+        Histogram queue;
+        Histogram total;
+    };
+
+    std::array<Entry, static_cast<std::size_t>(EventType::count)> entries;
+};
+
+}
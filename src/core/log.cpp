@@ -0,0 +1,184 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "log.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+
+char const* const level_names[] = {"error", "warning", "info", "debug", "trace"};
+
+std::string trim(std::string const& str)
+{
+    auto const begin = str.find_first_not_of(" \t");
+    if (begin == std::string::npos)
+        return "";
+    auto const end = str.find_last_not_of(" \t");
+    return str.substr(begin, end - begin + 1);
+}
+
+}
+
+char const* repowerd::log_level_to_string(LogLevel level)
+{
+    return level_names[static_cast<int>(level)];
+}
+
+repowerd::LogLevel repowerd::log_level_from_string(std::string const& str)
+{
+    for (auto i = 0u; i < sizeof(level_names)/sizeof(level_names[0]); ++i)
+    {
+        if (str == level_names[i])
+            return static_cast<LogLevel>(i);
+    }
+
+    throw std::invalid_argument{"Invalid log level: " + str};
+}
+
+repowerd::LogLevels::LogLevels(LogLevel default_level)
+    : default_level_{default_level},
+      min_level{static_cast<int>(default_level)},
+      max_level{static_cast<int>(default_level)}
+{
+}
+
+repowerd::LogLevel repowerd::LogLevels::default_level() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return default_level_;
+}
+
+void repowerd::LogLevels::set_default_level(LogLevel level)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    default_level_ = level;
+    update_bounds();
+}
+
+std::map<std::string,repowerd::LogLevel,std::less<>> repowerd::LogLevels::tag_levels() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return tag_levels_;
+}
+
+void repowerd::LogLevels::set_tag_level(std::string const& tag, LogLevel level)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    tag_levels_[tag] = level;
+    update_bounds();
+}
+
+void repowerd::LogLevels::reset_tag_level(std::string const& tag)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    tag_levels_.erase(tag);
+    update_bounds();
+}
+
+void repowerd::LogLevels::configure(std::string const& spec)
+{
+    std::string::size_type pos = 0;
+    std::string invalid_items;
+
+    while (pos <= spec.size())
+    {
+        auto end = spec.find(',', pos);
+        if (end == std::string::npos) end = spec.size();
+
+        auto const item = trim(spec.substr(pos, end - pos));
+        auto const eq = item.find('=');
+
+        try
+        {
+            if (eq != std::string::npos)
+                set_tag_level(trim(item.substr(0, eq)), log_level_from_string(trim(item.substr(eq + 1))));
+            else if (!item.empty())
+                set_default_level(log_level_from_string(item));
+        }
+        catch (std::invalid_argument const&)
+        {
+            invalid_items += (invalid_items.empty() ? "" : ",") + item;
+        }
+
+        pos = end + 1;
+    }
+
+    if (!invalid_items.empty())
+        throw std::invalid_argument{"Invalid log level items: " + invalid_items};
+}
+
+bool repowerd::LogLevels::is_enabled_for_tag(LogLevel level, char const* tag) const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const iter = tag_levels_.find(tag);
+    auto const threshold = iter != tag_levels_.end() ? iter->second : default_level_;
+
+    return level <= threshold;
+}
+
+void repowerd::LogLevels::update_bounds()
+{
+    auto min = static_cast<int>(default_level_);
+    auto max = min;
+
+    for (auto const& kv : tag_levels_)
+    {
+        min = std::min(min, static_cast<int>(kv.second));
+        max = std::max(max, static_cast<int>(kv.second));
+    }
+
+    min_level = min;
+    max_level = max;
+}
+
+repowerd::Log::Log()
+    : levels_{LogLevel::info}
+{
+}
+
+void repowerd::Log::log(char const* tag, char const* format, ...)
+{
+    if (!is_enabled(LogLevel::info, tag))
+        return;
+
+    va_list ap;
+    va_start(ap, format);
+    vlog(LogLevel::info, tag, format, ap);
+    va_end(ap);
+}
+
+void repowerd::Log::log(LogLevel level, char const* tag, char const* format, ...)
+{
+    if (!is_enabled(level, tag))
+        return;
+
+    va_list ap;
+    va_start(ap, format);
+    vlog(level, tag, format, ap);
+    va_end(ap);
+}
+
+void repowerd::Log::write(LogLevel level, char const* tag, char const* format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    vlog(level, tag, format, ap);
+    va_end(ap);
+}
@@ -18,21 +18,118 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdarg>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Sites above this level are compiled out by the REPOWERD_LOG_* macros:
+// 0=error 1=warning 2=info 3=debug 4=trace
+#ifndef REPOWERD_LOG_COMPILED_LEVEL
+#define REPOWERD_LOG_COMPILED_LEVEL 4
+#endif
+
+// The level checks happen before the arguments are evaluated
+#define REPOWERD_LOG_AT(log_ref, level, tag, ...) \
+    do { \
+        if (static_cast<int>(level) <= REPOWERD_LOG_COMPILED_LEVEL && \
+            (log_ref).is_enabled((level), (tag))) \
+            (log_ref).write((level), (tag), __VA_ARGS__); \
+    } while (false)
+
+#define REPOWERD_LOG_ERROR(log_ref, tag, ...) \
+    REPOWERD_LOG_AT(log_ref, ::repowerd::LogLevel::error, tag, __VA_ARGS__)
+#define REPOWERD_LOG_WARNING(log_ref, tag, ...) \
+    REPOWERD_LOG_AT(log_ref, ::repowerd::LogLevel::warning, tag, __VA_ARGS__)
+#define REPOWERD_LOG_INFO(log_ref, tag, ...) \
+    REPOWERD_LOG_AT(log_ref, ::repowerd::LogLevel::info, tag, __VA_ARGS__)
+#define REPOWERD_LOG_DEBUG(log_ref, tag, ...) \
+    REPOWERD_LOG_AT(log_ref, ::repowerd::LogLevel::debug, tag, __VA_ARGS__)
+#define REPOWERD_LOG_TRACE(log_ref, tag, ...) \
+    REPOWERD_LOG_AT(log_ref, ::repowerd::LogLevel::trace, tag, __VA_ARGS__)
+
 namespace repowerd
 {
 
+enum class LogLevel { error, warning, info, debug, trace };
+
+char const* log_level_to_string(LogLevel level);
+LogLevel log_level_from_string(std::string const& str);
+
+// The runtime level threshold, globally and per tag. Checks are lock-free
+// unless a tag override falls between the global bounds.
+class LogLevels
+{
+public:
+    LogLevels(LogLevel default_level);
+
+    bool is_enabled(LogLevel level, char const* tag) const
+    {
+        auto const l = static_cast<int>(level);
+        if (l <= min_level.load(std::memory_order_relaxed)) return true;
+        if (l > max_level.load(std::memory_order_relaxed)) return false;
+        return is_enabled_for_tag(level, tag);
+    }
+
+    LogLevel default_level() const;
+    void set_default_level(LogLevel level);
+    std::map<std::string,LogLevel,std::less<>> tag_levels() const;
+    void set_tag_level(std::string const& tag, LogLevel level);
+    void reset_tag_level(std::string const& tag);
+
+    // Applies a comma separated list of "level" and "tag=level" items.
+    // Invalid items are skipped; if there are any, std::invalid_argument
+    // naming them is thrown after the valid items have been applied.
+    void configure(std::string const& spec);
+
+private:
+    LogLevels(LogLevels const&) = delete;
+    LogLevels& operator=(LogLevels const&) = delete;
+
+    bool is_enabled_for_tag(LogLevel level, char const* tag) const;
+    void update_bounds();
+
+    mutable std::mutex mutex;
+    LogLevel default_level_;
+    std::map<std::string,LogLevel,std::less<>> tag_levels_;
+    std::atomic<int> min_level;
+    std::atomic<int> max_level;
+};
+
 class Log
 {
 public:
     virtual ~Log() = default;
 
-    virtual void log(char const* tag, char const* format, ...) 
-        __attribute__ ((format (printf, 3, 4))) = 0;
+    // Logs at LogLevel::info
+    void log(char const* tag, char const* format, ...)
+        __attribute__ ((format (printf, 3, 4)));
+
+    void log(LogLevel level, char const* tag, char const* format, ...)
+        __attribute__ ((format (printf, 4, 5)));
+
+    // Writes out a message without checking its level
+    void write(LogLevel level, char const* tag, char const* format, ...)
+        __attribute__ ((format (printf, 4, 5)));
+
+    bool is_enabled(LogLevel level, char const* tag) const
+    {
+        return levels_.is_enabled(level, tag);
+    }
+
+    LogLevels& levels() { return levels_; }
 
 protected:
-    Log() = default;
+    Log();
     Log(Log const&) = delete;
     Log& operator=(Log const&) = delete;
+
+    virtual void vlog(LogLevel level, char const* tag, char const* format, va_list ap) = 0;
+
+private:
+    LogLevels levels_;
 };
 
 }
@@ -37,6 +37,10 @@ public:
     virtual HandlerRegistration register_alarm_handler(AlarmHandler const& handler) = 0;
     virtual AlarmId schedule_alarm_in(std::chrono::milliseconds t) = 0;
     virtual void cancel_alarm(AlarmId id) = 0;
+    // Moves the deadline of a pending alarm to t from now, keeping its id.
+    // Returns false if the alarm is not pending anymore, e.g. because it
+    // has already fired, in which case nothing is changed.
+    virtual bool extend_alarm_in(AlarmId id, std::chrono::milliseconds t) = 0;
     virtual std::chrono::steady_clock::time_point now() = 0;
 
 protected:
@@ -18,16 +18,20 @@
 
 #include "default_daemon_config.h"
 #include "core/default_state_machine_factory.h"
+#include "core/event_latency.h"
 
 #include "adapters/android_autobrightness_algorithm.h"
 #include "adapters/android_backlight.h"
 #include "adapters/android_device_config.h"
 #include "adapters/android_device_quirks.h"
 #include "adapters/backlight_brightness_control.h"
+#include "adapters/battery_discharge_estimator.h"
 #include "adapters/console_log.h"
+#include "adapters/dbus_connection_handle.h"
+#include "adapters/dbus_sender_credentials.h"
 #include "adapters/default_state_machine_options.h"
 #include "adapters/dev_alarm_wakeup_service.h"
-#include "adapters/event_loop_timer.h"
+#include "adapters/event_loop.h"
 #include "adapters/libsuspend_system_power_control.h"
 #include "adapters/logind_session_tracker.h"
 #include "adapters/logind_system_power_control.h"
@@ -39,9 +43,11 @@
 #include "adapters/real_filesystem.h"
 #include "adapters/real_temporary_suspend_inhibition.h"
 #include "adapters/repowerd_service.h"
+#include "adapters/ring_buffer_log.h"
 #include "adapters/sysfs_backlight.h"
 #include "adapters/syslog_log.h"
 #include "adapters/sys_exec.h"
+#include "adapters/timer_wheel_timer.h"
 #include "adapters/timerfd_wakeup_service.h"
 #include "adapters/ubuntu_light_sensor.h"
 #include "adapters/ubuntu_performance_booster.h"
@@ -56,6 +62,10 @@
 #include "adapters/unity_user_activity.h"
 #include "adapters/upower_power_source_and_lid.h"
 
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+
 namespace
 {
 char const* const log_tag = "DefaultDaemonConfig";
@@ -155,6 +165,44 @@ struct NullSystemPowerControl : repowerd::SystemPowerControl
     void disallow_default_system_handlers() override {}
 };
 
+// Reads an integer tuning knob from the environment. A malformed or out of
+// range value is reported and replaced by the default, so that a typo
+// doesn't take the daemon, or the adapter the knob tunes, down with it.
+int env_int(repowerd::Log& log, char const* name, int default_value, int min_value)
+{
+    auto const env_cstr = getenv(name);
+    if (!env_cstr)
+        return default_value;
+
+    char* end;
+    errno = 0;
+    auto const value = strtol(env_cstr, &end, 10);
+
+    if (end == env_cstr || *end != '\0' || errno != 0 ||
+        value < min_value || value > INT_MAX)
+    {
+        REPOWERD_LOG_WARNING(
+            log, log_tag, "Ignoring invalid %s=%s (expected an integer >= %d), using %d",
+            name, env_cstr, min_value, default_value);
+        return default_value;
+    }
+
+    return static_cast<int>(value);
+}
+
+}
+
+repowerd::DefaultDaemonConfig::DefaultDaemonConfig()
+{
+    auto const event_loop_env_cstr = getenv("REPOWERD_EVENT_LOOP");
+    std::string const event_loop_env{event_loop_env_cstr ? event_loop_env_cstr : ""};
+    if (event_loop_env == "shared")
+        EventLoop::enable_shared_reactor(true);
+
+    auto const dbus_connection_env_cstr = getenv("REPOWERD_DBUS_CONNECTION");
+    std::string const dbus_connection_env{dbus_connection_env_cstr ? dbus_connection_env_cstr : ""};
+    if (dbus_connection_env != "private")
+        DBusConnectionHandle::enable_shared_connections(true);
 }
 
 std::shared_ptr<repowerd::DisplayInformation>
@@ -205,7 +253,11 @@ repowerd::DefaultDaemonConfig::the_client_settings()
     if (!client_settings)
     {
         client_settings = std::make_shared<RepowerdService>(
-            the_log(), the_dbus_bus_address());
+            the_log(),
+            the_event_latency_stats(),
+            the_battery_estimates(),
+            the_dbus_sender_credentials(),
+            the_dbus_bus_address());
     }
 
     return client_settings;
@@ -223,6 +275,15 @@ repowerd::DefaultDaemonConfig::the_display_power_event_sink()
     return the_unity_screen_service();
 }
 
+std::shared_ptr<repowerd::EventLatencyStats>
+repowerd::DefaultDaemonConfig::the_event_latency_stats()
+{
+    if (!event_latency_stats)
+        event_latency_stats = std::make_shared<EventLatencyStats>();
+
+    return event_latency_stats;
+}
+
 std::shared_ptr<repowerd::ModemPowerControl>
 repowerd::DefaultDaemonConfig::the_modem_power_control()
 {
@@ -288,12 +349,23 @@ repowerd::DefaultDaemonConfig::the_power_source()
 std::shared_ptr<repowerd::ProximitySensor>
 repowerd::DefaultDaemonConfig::the_proximity_sensor()
 {
-    if (!proximity_sensor)
+    if (proximity_sensor)
+        return proximity_sensor;
+
+    // Proximity readings younger than the freshness window are reused
+    // without powering up the sensor, and the sensor stays powered for
+    // the linger period after its last user goes away
+    auto const freshness_ms = env_int(*the_log(), "REPOWERD_PROXIMITY_FRESHNESS_MS", 1000, 0);
+    auto const linger_ms = env_int(*the_log(), "REPOWERD_PROXIMITY_LINGER_MS", 3000, 0);
+
     try
     {
         proximity_sensor = std::make_shared<UbuntuProximitySensor>(
             the_log(),
-            *the_device_quirks());
+            the_chrono(),
+            *the_device_quirks(),
+            std::chrono::milliseconds{freshness_ms},
+            std::chrono::milliseconds{linger_ms});
     }
     catch (std::exception const& e)
     {
@@ -377,7 +449,7 @@ std::shared_ptr<repowerd::Timer>
 repowerd::DefaultDaemonConfig::the_timer()
 {
     if (!timer)
-        timer = std::make_shared<EventLoopTimer>();
+        timer = std::make_shared<TimerWheelTimer>();
     return timer;
 }
 
@@ -423,24 +495,68 @@ repowerd::DefaultDaemonConfig::the_backlight_brightness_control()
 {
     if (!backlight_brightness_control)
     {
+        // Autobrightness logs its per-sample lines at debug level, which
+        // this still enables without having to know the tag
         auto const ab_log_env_cstr = getenv("REPOWERD_LOG_AUTOBRIGHTNESS");
         std::string const ab_log_env{ab_log_env_cstr ? ab_log_env_cstr : ""};
 
-        auto const ab_log = ab_log_env.empty() ? std::make_shared<NullLog>() : the_log();
+        if (!ab_log_env.empty())
+            the_log()->levels().set_tag_level("AndroidAutobrightnessAlgorithm", LogLevel::debug);
+
+        auto const easing_env_cstr = getenv("REPOWERD_BRIGHTNESS_EASING");
+        std::string const easing_env{easing_env_cstr ? easing_env_cstr : "linear"};
+        auto easing = BrightnessCurve::Easing::linear;
+
+        try
+        {
+            easing = BrightnessCurve::easing_from_string(easing_env);
+        }
+        catch (std::invalid_argument const& e)
+        {
+            REPOWERD_LOG_WARNING(
+                *the_log(), log_tag, "Ignoring REPOWERD_BRIGHTNESS_EASING: %s, using linear",
+                e.what());
+        }
+
+        auto const space_env_cstr = getenv("REPOWERD_BRIGHTNESS_SPACE");
+        std::string const space_env{space_env_cstr ? space_env_cstr : "perceptual"};
+
+        if (space_env != "linear" && space_env != "perceptual")
+        {
+            REPOWERD_LOG_WARNING(
+                *the_log(), log_tag,
+                "Ignoring unknown REPOWERD_BRIGHTNESS_SPACE=%s, using perceptual",
+                space_env.c_str());
+        }
+
+        // Stepping the backlight faster than the panel refreshes wastes writes
+        auto const max_fps = env_int(*the_log(), "REPOWERD_BRIGHTNESS_MAX_FPS", 60, 0);
+
+        BrightnessCurve const brightness_curve{easing, space_env != "linear", max_fps};
 
         backlight_brightness_control = std::make_shared<BacklightBrightnessControl>(
             the_backlight(),
             the_light_sensor(),
-            std::make_shared<AndroidAutobrightnessAlgorithm>(*the_device_config(), ab_log), 
+            std::make_shared<AndroidAutobrightnessAlgorithm>(*the_device_config(), the_log()),
             the_chrono(),
             the_log(),
             *the_device_config(),
-            *the_device_quirks());
+            *the_device_quirks(),
+            brightness_curve);
     }
 
     return backlight_brightness_control;
 }
 
+std::shared_ptr<repowerd::BatteryEstimates>
+repowerd::DefaultDaemonConfig::the_battery_estimates()
+{
+    if (!battery_estimates)
+        battery_estimates = std::make_shared<BatteryEstimates>();
+
+    return battery_estimates;
+}
+
 std::shared_ptr<repowerd::BrightnessNotification>
 repowerd::DefaultDaemonConfig::the_brightness_notification()
 {
@@ -477,6 +593,15 @@ std::string repowerd::DefaultDaemonConfig::the_dbus_bus_address()
     return address ? address.get() : std::string{};
 }
 
+std::shared_ptr<repowerd::DBusSenderCredentials>
+repowerd::DefaultDaemonConfig::the_dbus_sender_credentials()
+{
+    if (!dbus_sender_credentials)
+        dbus_sender_credentials = std::make_shared<DBusSenderCredentials>(the_log());
+
+    return dbus_sender_credentials;
+}
+
 std::shared_ptr<repowerd::DeviceConfig>
 repowerd::DefaultDaemonConfig::the_device_config()
 {
@@ -522,10 +647,18 @@ repowerd::DefaultDaemonConfig::the_filesystem()
 std::shared_ptr<repowerd::LightSensor>
 repowerd::DefaultDaemonConfig::the_light_sensor()
 {
-    if (!light_sensor)
+    if (light_sensor)
+        return light_sensor;
+
+    // Decimate and batch light samples at the source, since the
+    // autobrightness algorithm only acts on them every few seconds
+    auto const batch_size = env_int(*the_log(), "REPOWERD_LIGHT_BATCH_SIZE", 8, 1);
+    auto const min_interval_ms = env_int(*the_log(), "REPOWERD_LIGHT_MIN_INTERVAL_MS", 100, 0);
+
     try
     {
-        light_sensor = std::make_shared<UbuntuLightSensor>();
+        light_sensor = std::make_shared<UbuntuLightSensor>(
+            batch_size, std::chrono::milliseconds{min_interval_ms});
     }
     catch (std::exception const& e)
     {
@@ -583,8 +716,38 @@ repowerd::DefaultDaemonConfig::the_log()
             log = std::make_shared<ConsoleLog>();
         else if (log_env == "null")
             log = std::make_shared<NullLog>();
-        else
+        else if (log_env == "syslog")
             log = std::make_shared<SyslogLog>();
+        else
+        {
+            // Record log lines cheaply and format them off the hot paths;
+            // SIGUSR1 forces a flush and a crash writes what is left to stderr
+            auto const sink = std::make_shared<SyslogLog>();
+
+            // Warnings about the knobs go straight to the sink, since
+            // the log they configure doesn't exist yet
+            auto const records = env_int(*sink, "REPOWERD_LOG_BUFFER_RECORDS", 256, 1);
+            auto const flush_ms = env_int(*sink, "REPOWERD_LOG_FLUSH_MS", 500, 0);
+
+            log = std::make_shared<RingBufferLog>(
+                sink,
+                static_cast<size_t>(records),
+                std::chrono::milliseconds{flush_ms},
+                RingBufferLog::SignalHandling::install);
+        }
+
+        // E.g. "info,BacklightBrightnessControl=debug"; adjustable at
+        // runtime through the SetLogLevel D-Bus method
+        auto const level_env_cstr = getenv("REPOWERD_LOG_LEVEL");
+        if (level_env_cstr)
+        try
+        {
+            log->levels().configure(level_env_cstr);
+        }
+        catch (std::invalid_argument const& e)
+        {
+            REPOWERD_LOG_WARNING(*log, log_tag, "Ignoring parts of REPOWERD_LOG_LEVEL: %s", e.what());
+        }
     }
     return log;
 }
@@ -619,7 +782,8 @@ repowerd::DefaultDaemonConfig::the_x11_display()
         x11_display = std::make_shared<X11Display>(
             the_log(),
             the_exec(),
-            the_dbus_bus_address());
+            the_dbus_bus_address(),
+            ":0");
     }
     return x11_display;
 }
@@ -647,6 +811,7 @@ repowerd::DefaultDaemonConfig::the_unity_screen_service()
             the_log(),
             the_temporary_suspend_inhibition(),
             *the_device_config(),
+            the_dbus_sender_credentials(),
             the_dbus_bus_address());
     }
 
@@ -685,6 +850,8 @@ repowerd::DefaultDaemonConfig::the_upower_power_source_and_lid()
         upower_power_source_and_lid = std::make_shared<UPowerPowerSourceAndLid>(
             the_log(),
             the_temporary_suspend_inhibition(),
+            the_chrono(),
+            the_battery_estimates(),
             *the_device_config(),
             the_dbus_bus_address());
     }
@@ -695,10 +862,19 @@ repowerd::DefaultDaemonConfig::the_upower_power_source_and_lid()
 std::shared_ptr<repowerd::WakeupService>
 repowerd::DefaultDaemonConfig::the_wakeup_service()
 {
-    if (!wakeup_service)
+    if (wakeup_service)
+        return wakeup_service;
+
+    // Slack applied to wakeups scheduled without an explicit one. Raising
+    // it lets nearby wakeups share a device resume, at the cost of firing
+    // them up to that much later than requested.
+    auto const default_slack = std::chrono::milliseconds{
+        env_int(*the_log(), "REPOWERD_WAKEUP_SLACK_MS", 0, 0)};
+
     try
     {
-        wakeup_service = std::make_shared<DevAlarmWakeupService>(the_filesystem());
+        wakeup_service = std::make_shared<DevAlarmWakeupService>(
+            the_filesystem(), default_slack);
     }
     catch (std::exception const& e)
     {
@@ -707,7 +883,8 @@ repowerd::DefaultDaemonConfig::the_wakeup_service()
     }
 
     if (!wakeup_service)
-        wakeup_service = std::make_shared<TimerfdWakeupService>();
+        wakeup_service = std::make_shared<TimerfdWakeupService>(
+            the_log(), the_filesystem(), the_event_latency_stats(), default_slack);
 
     return wakeup_service;
 }
@@ -25,8 +25,10 @@ namespace repowerd
 
 class Backlight;
 class BacklightBrightnessControl;
+class BatteryEstimates;
 class BrightnessNotification;
 class Chrono;
+class DBusSenderCredentials;
 class DeviceConfig;
 class DeviceQuirks;
 class Filesystem;
@@ -46,12 +48,15 @@ class WakeupService;
 class DefaultDaemonConfig : public DaemonConfig
 {
 public:
+    DefaultDaemonConfig();
+
     std::shared_ptr<DisplayInformation> the_display_information() override;
     std::shared_ptr<BrightnessControl> the_brightness_control() override;
     std::shared_ptr<ClientRequests> the_client_requests() override;
     std::shared_ptr<ClientSettings> the_client_settings() override;
     std::shared_ptr<DisplayPowerControl> the_display_power_control() override;
     std::shared_ptr<DisplayPowerEventSink> the_display_power_event_sink() override;
+    std::shared_ptr<EventLatencyStats> the_event_latency_stats() override;
     std::shared_ptr<Lid> the_lid() override;
     std::shared_ptr<Lock> the_lock() override;
     std::shared_ptr<Log> the_log() override;
@@ -76,9 +81,11 @@ public:
 
     std::shared_ptr<Backlight> the_backlight();
     std::shared_ptr<BacklightBrightnessControl> the_backlight_brightness_control();
+    std::shared_ptr<BatteryEstimates> the_battery_estimates();
     std::shared_ptr<BrightnessNotification> the_brightness_notification();
     std::shared_ptr<Chrono> the_chrono();
     std::string the_dbus_bus_address();
+    std::shared_ptr<DBusSenderCredentials> the_dbus_sender_credentials();
     std::shared_ptr<DeviceConfig> the_device_config();
     std::shared_ptr<DeviceQuirks> the_device_quirks();
     std::shared_ptr<Filesystem> the_filesystem();
@@ -99,13 +106,16 @@ private:
     std::shared_ptr<DisplayInformation> display_information;
     std::shared_ptr<Backlight> backlight;
     std::shared_ptr<BacklightBrightnessControl> backlight_brightness_control;
+    std::shared_ptr<BatteryEstimates> battery_estimates;
     std::shared_ptr<BrightnessControl> brightness_control;
     std::shared_ptr<CallControl> call_control;
     std::shared_ptr<BrightnessNotification> brightness_notification;
     std::shared_ptr<Chrono> chrono;
     std::shared_ptr<ClientSettings> client_settings;
+    std::shared_ptr<DBusSenderCredentials> dbus_sender_credentials;
     std::shared_ptr<DeviceConfig> device_config;
     std::shared_ptr<DeviceQuirks> device_quirks;
+    std::shared_ptr<EventLatencyStats> event_latency_stats;
     std::shared_ptr<Filesystem> filesystem;
     std::shared_ptr<LightSensor> light_sensor;
     std::shared_ptr<Log> log;
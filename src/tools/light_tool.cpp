@@ -31,9 +31,10 @@ int main()
     auto const light_sensor = config.the_light_sensor();
 
     auto registration = light_sensor->register_light_handler(
-        [] (double light)
+        [] (repowerd::LightSamples const& samples)
         {
-            std::cout << "LIGHT: " << light << std::endl;
+            for (auto const& sample : samples)
+                std::cout << "LIGHT: " << sample.light << std::endl;
         });
 
     bool running = true;
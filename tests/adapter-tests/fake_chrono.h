@@ -33,7 +33,7 @@ public:
 
     void sleep_for(std::chrono::nanoseconds t) override;
 
-    std::chrono::steady_clock::time_point steady_now();
+    std::chrono::steady_clock::time_point steady_now() override;
 
 private:
     std::mutex now_mutex;
@@ -47,6 +47,7 @@ char const* const upower_device_introspection = R"(<!DOCTYPE node PUBLIC '-//fre
         <property type="b" name="Online" access="read"/>
         <property type="d" name="Percentage" access="read"/>
         <property type="d" name="Temperature" access="read"/>
+        <property type="d" name="EnergyRate" access="read"/>
         <property type="b" name="IsPresent" access="read"/>
         <property type="u" name="State" access="read"/>
     </interface>
@@ -63,6 +64,7 @@ rt::FakeUPower::DeviceInfo rt::FakeUPower::DeviceInfo::for_battery(DeviceState s
     info.online = false;
     info.percentage = 100.0;
     info.temperature = 18.0;
+    info.energy_rate = 0.0;
     info.is_present = true;
     info.state = state;
     return info;
@@ -75,6 +77,7 @@ rt::FakeUPower::DeviceInfo rt::FakeUPower::DeviceInfo::for_plugged_line_power()
     info.online = true;
     info.percentage = 0.0;
     info.temperature = 0.0;
+    info.energy_rate = 0.0;
     info.is_present = true;
     info.state = DeviceState::unknown;
     return info;
@@ -87,6 +90,7 @@ rt::FakeUPower::DeviceInfo rt::FakeUPower::DeviceInfo::for_unplugged_line_power(
     info.online = false;
     info.percentage = 0.0;
     info.temperature = 0.0;
+    info.energy_rate = 0.0;
     info.is_present = true;
     info.state = DeviceState::unknown;
     return info;
@@ -95,7 +99,8 @@ rt::FakeUPower::DeviceInfo rt::FakeUPower::DeviceInfo::for_unplugged_line_power(
 rt::FakeUPower::FakeUPower(
     std::string const& dbus_address)
     : rt::DBusClient{dbus_address, "org.freedesktop.UPower", "/org/freedesktop/UPower"},
-      num_enumerate_device_calls_{0}
+      num_enumerate_device_calls_{0},
+      num_on_battery_get_calls_{0}
 {
     connection.request_name("org.freedesktop.UPower");
 
@@ -120,10 +125,15 @@ rt::FakeUPower::FakeUPower(
 
 void rt::FakeUPower::add_device(std::string const& device_path, DeviceInfo const& info)
 {
+    bool old_on_battery;
+    bool new_on_battery;
+
     {
         std::lock_guard<std::mutex> lock{devices_mutex};
 
+        old_on_battery = is_using_battery_power();
         devices[device_path] = info;
+        new_on_battery = is_using_battery_power();
     }
 
     device_handler_registrations[device_path] = event_loop.register_object_handler(
@@ -144,6 +154,8 @@ void rt::FakeUPower::add_device(std::string const& device_path, DeviceInfo const
                 method_name, parameters, invocation);
         });
 
+    emit_on_battery_if_changed(old_on_battery, new_on_battery);
+
     auto const params = g_variant_new_parsed("(@o %o,)", device_path.c_str());
     emit_signal_full("/org/freedesktop/UPower", "org.freedesktop.UPower", "DeviceAdded", params);
 }
@@ -151,14 +163,20 @@ void rt::FakeUPower::add_device(std::string const& device_path, DeviceInfo const
 void rt::FakeUPower::change_device(std::string const& device_path, DeviceInfo const& info)
 {
     DeviceInfo old_info;
+    bool old_on_battery;
+    bool new_on_battery;
 
     {
         std::lock_guard<std::mutex> lock{devices_mutex};
 
+        old_on_battery = is_using_battery_power();
         old_info = devices[device_path];
         devices[device_path] = info;
+        new_on_battery = is_using_battery_power();
     }
 
+    emit_on_battery_if_changed(old_on_battery, new_on_battery);
+
     std::string changed_properties_str;
     if (old_info.type != info.type)
     {
@@ -180,6 +198,11 @@ void rt::FakeUPower::change_device(std::string const& device_path, DeviceInfo co
         if (!changed_properties_str.empty()) changed_properties_str += ", ";
         changed_properties_str += "'Temperature': <" + std::to_string(info.temperature) + ">";
     }
+    if (old_info.energy_rate != info.energy_rate)
+    {
+        if (!changed_properties_str.empty()) changed_properties_str += ", ";
+        changed_properties_str += "'EnergyRate': <" + std::to_string(info.energy_rate) + ">";
+    }
     if (old_info.is_present != info.is_present)
     {
         if (!changed_properties_str.empty()) changed_properties_str += ", ";
@@ -202,13 +225,20 @@ void rt::FakeUPower::change_device(std::string const& device_path, DeviceInfo co
 
 void rt::FakeUPower::remove_device(std::string const& device_path)
 {
+    bool old_on_battery;
+    bool new_on_battery;
+
     {
         std::lock_guard<std::mutex> lock{devices_mutex};
+        old_on_battery = is_using_battery_power();
         devices.erase(device_path);
+        new_on_battery = is_using_battery_power();
     }
 
     device_handler_registrations.erase(device_path);
 
+    emit_on_battery_if_changed(old_on_battery, new_on_battery);
+
     auto const params = g_variant_new_parsed("(@o %o,)", device_path.c_str());
     emit_signal_full("/org/freedesktop/UPower", "org.freedesktop.UPower", "DeviceRemoved", params);
 }
@@ -248,6 +278,11 @@ int rt::FakeUPower::num_enumerate_devices_calls()
     return num_enumerate_device_calls_;
 }
 
+int rt::FakeUPower::num_on_battery_get_calls()
+{
+    return num_on_battery_get_calls_;
+}
+
 void rt::FakeUPower::dbus_method_call(
     GDBusConnection* /*connection*/,
     gchar const* /*sender_cstr*/,
@@ -290,16 +325,24 @@ void rt::FakeUPower::dbus_method_call(
 
         auto const properties = g_variant_new_parsed(
             "(@a{sv} {'Type': <%u>, 'Online': <%b>, 'Percentage': <%d>, "
-            "'Temperature': <%d>, 'IsPresent': <%b>, 'State': <%u>},)",
+            "'Temperature': <%d>, 'EnergyRate': <%d>, 'IsPresent': <%b>, 'State': <%u>},)",
             info.type, info.online, info.percentage,
-            info.temperature, info.is_present, info.state);
+            info.temperature, info.energy_rate, info.is_present, info.state);
 
         g_dbus_method_invocation_return_value(invocation, properties);
     }
     else if (interface_name == "org.freedesktop.DBus.Properties" &&
              method_name == "Get" && object_path == "/org/freedesktop/UPower")
     {
-        auto const properties = g_variant_new_parsed("(<%b>,)", is_using_battery_power());
+        ++num_on_battery_get_calls_;
+
+        bool on_battery;
+        {
+            std::lock_guard<std::mutex> lock{devices_mutex};
+            on_battery = is_using_battery_power();
+        }
+
+        auto const properties = g_variant_new_parsed("(<%b>,)", on_battery);
 
         g_dbus_method_invocation_return_value(invocation, properties);
     }
@@ -337,3 +380,21 @@ bool rt::FakeUPower::is_using_battery_power()
 
     return on_battery;
 }
+
+void rt::FakeUPower::emit_on_battery_if_changed(bool old_on_battery, bool new_on_battery)
+{
+    if (old_on_battery == new_on_battery)
+        return;
+
+    auto const params_str =
+        "(@s 'org.freedesktop.UPower',"s +
+        " @a{sv} {'OnBattery': <@b " + (new_on_battery ? "true" : "false") + ">}," +
+        " @as [])";
+    auto const params = g_variant_new_parsed(params_str.c_str());
+
+    emit_signal_full(
+        "/org/freedesktop/UPower",
+        "org.freedesktop.DBus.Properties",
+        "PropertiesChanged",
+        params);
+}
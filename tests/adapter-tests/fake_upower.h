@@ -62,6 +62,7 @@ public:
         bool online;
         double percentage;
         double temperature;
+        double energy_rate;
         bool is_present;
         DeviceState state;
     };
@@ -77,6 +78,7 @@ public:
     void open_lid();
 
     int num_enumerate_devices_calls();
+    int num_on_battery_get_calls();
 
 private:
     void dbus_method_call(
@@ -88,10 +90,12 @@ private:
         GVariant* parameters,
         GDBusMethodInvocation* invocation);
     bool is_using_battery_power();
+    void emit_on_battery_if_changed(bool old_on_battery, bool new_on_battery);
 
     repowerd::HandlerRegistration upower_handler_registration;
 
     std::atomic<int> num_enumerate_device_calls_;
+    std::atomic<int> num_on_battery_get_calls_;
 
     std::mutex devices_mutex;
     std::unordered_map<std::string,DeviceInfo> devices;
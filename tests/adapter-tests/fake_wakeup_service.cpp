@@ -32,6 +32,12 @@ std::string rt::FakeWakeupService::schedule_wakeup_at(
     return std::to_string(wakeups.size() - 1);
 }
 
+std::string rt::FakeWakeupService::schedule_wakeup_at(
+    std::chrono::system_clock::time_point tp, std::chrono::milliseconds)
+{
+    return schedule_wakeup_at(tp);
+}
+
 void rt::FakeWakeupService::cancel_wakeup(std::string const& cookie)
 {
     int const cookie_int = std::stoi(cookie);
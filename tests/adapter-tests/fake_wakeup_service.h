@@ -35,6 +35,8 @@ public:
     FakeWakeupService();
 
     std::string schedule_wakeup_at(std::chrono::system_clock::time_point tp) override;
+    std::string schedule_wakeup_at(
+        std::chrono::system_clock::time_point tp, std::chrono::milliseconds slack) override;
     void cancel_wakeup(std::string const& cookie) override;
     repowerd::HandlerRegistration register_wakeup_handler(
         repowerd::WakeupHandler const& handler) override;
@@ -68,3 +68,30 @@ rt::DBusAsyncReplyVoid rt::RepowerdDBusClient::request_set_critical_power_behavi
         repowerd_interface, "SetCriticalPowerBehavior",
         g_variant_new("(s)", power_action.c_str()));
 }
+
+rt::DBusAsyncReply rt::RepowerdDBusClient::request_get_event_latencies()
+{
+    return invoke_with_reply<rt::DBusAsyncReply>(
+        repowerd_interface, "GetEventLatencies", nullptr);
+}
+
+rt::DBusAsyncReply rt::RepowerdDBusClient::request_get_battery_estimates()
+{
+    return invoke_with_reply<rt::DBusAsyncReply>(
+        repowerd_interface, "GetBatteryEstimates", nullptr);
+}
+
+rt::DBusAsyncReplyVoid rt::RepowerdDBusClient::request_set_log_level(
+    std::string const& tag,
+    std::string const& level)
+{
+    return invoke_with_reply<rt::DBusAsyncReplyVoid>(
+        repowerd_interface, "SetLogLevel",
+        g_variant_new("(ss)", tag.c_str(), level.c_str()));
+}
+
+rt::DBusAsyncReply rt::RepowerdDBusClient::request_get_log_levels()
+{
+    return invoke_with_reply<rt::DBusAsyncReply>(
+        repowerd_interface, "GetLogLevels", nullptr);
+}
@@ -42,6 +42,12 @@ public:
         std::string const& power_supply);
     DBusAsyncReplyVoid request_set_critical_power_behavior(
         std::string const& power_action);
+    DBusAsyncReply request_get_event_latencies();
+    DBusAsyncReply request_get_battery_estimates();
+    DBusAsyncReplyVoid request_set_log_level(
+        std::string const& tag,
+        std::string const& level);
+    DBusAsyncReply request_get_log_levels();
 };
 
 }
@@ -43,6 +43,22 @@ struct AnAndroidAutobrightnessAlgorithm : Test
         event_loop.enqueue([]{}).get();
     }
 
+    // Samples 100ms apart, the last one taken now
+    repowerd::LightSamples light_samples(std::vector<double> const& lights)
+    {
+        repowerd::LightSamples samples;
+        auto time = std::chrono::steady_clock::now() -
+                    lights.size() * std::chrono::milliseconds{100};
+
+        for (auto const light : lights)
+        {
+            time += std::chrono::milliseconds{100};
+            samples.push_back({time, light});
+        }
+
+        return samples;
+    }
+
     repowerd::EventLoop event_loop{"test"};
     std::shared_ptr<rt::FakeLog> const fake_log{std::make_shared<rt::FakeLog>()};
 
@@ -97,7 +113,7 @@ TEST_F(AnAndroidAutobrightnessAlgorithm,
         [&] (double brightness) { ab_values.push_back(brightness); });
 
     ab_algorithm.start();
-    ab_algorithm.new_light_value(2.0);
+    ab_algorithm.new_light_values(light_samples({2.0}));
 
     wait_for_event_loop_processing();
 
@@ -114,13 +130,34 @@ TEST_F(AnAndroidAutobrightnessAlgorithm, ignores_light_values_when_stopped)
     auto const reg = ab_algorithm.register_autobrightness_handler(
         [&] (double brightness) { ab_values.push_back(brightness); });
 
-    ab_algorithm.new_light_value(2.0);
+    ab_algorithm.new_light_values(light_samples({2.0}));
     wait_for_event_loop_processing();
     EXPECT_THAT(ab_values, IsEmpty());
 
     ab_algorithm.start();
     ab_algorithm.stop();
-    ab_algorithm.new_light_value(2.0);
+    ab_algorithm.new_light_values(light_samples({2.0}));
     wait_for_event_loop_processing();
     EXPECT_THAT(ab_values, IsEmpty());
 }
+
+TEST_F(AnAndroidAutobrightnessAlgorithm, reacts_once_to_first_batch_of_light_values)
+{
+    repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
+        device_config_with_valid_curves, fake_log};
+    ASSERT_TRUE(ab_algorithm.init(event_loop));
+
+    std::vector<double> ab_values;
+    auto const reg = ab_algorithm.register_autobrightness_handler(
+        [&] (double brightness) { ab_values.push_back(brightness); });
+
+    ab_algorithm.start();
+    ab_algorithm.new_light_values(light_samples({1.0, 2.0, 3.0}));
+
+    wait_for_event_loop_processing();
+
+    ASSERT_THAT(ab_values.size(), Eq(1));
+    // The fast average has moved from the first sample towards the last one
+    EXPECT_THAT(ab_values[0], Gt(2.0/100.0));
+    EXPECT_THAT(ab_values[0], Lt(3.0/100.0));
+}
@@ -34,6 +34,8 @@
 
 #include <thread>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <numeric>
 #include <cmath>
 
@@ -50,16 +52,30 @@ class FakeBacklight : public repowerd::Backlight
 public:
     void set_brightness(double v) override
     {
+        std::lock_guard<std::mutex> lock{history_mutex};
         brightness_history.push_back(v);
     }
 
+    int num_brightness_levels() override
+    {
+        return 100;
+    }
+
     double get_brightness() override
     {
+        std::lock_guard<std::mutex> lock{history_mutex};
         return brightness_history.back();
     }
 
+    std::vector<double> history()
+    {
+        std::lock_guard<std::mutex> lock{history_mutex};
+        return brightness_history;
+    }
+
     void clear_brightness_history()
     {
+        std::lock_guard<std::mutex> lock{history_mutex};
         auto const last = brightness_history.back();
         brightness_history.clear();
         brightness_history.push_back(last);
@@ -67,7 +83,7 @@ public:
 
     std::vector<double> brightness_steps()
     {
-        auto steps = brightness_history;
+        auto steps = history();
         std::adjacent_difference(steps.begin(), steps.end(), steps.begin());
         steps.erase(steps.begin());
         std::transform(steps.begin(), steps.end(), steps.begin(),
@@ -90,6 +106,9 @@ public:
     }
 
     double const starting_brightness = 0.5;
+
+private:
+    std::mutex history_mutex;
     std::vector<double> brightness_history{starting_brightness};
 };
 
@@ -101,7 +120,7 @@ public:
     {
         light_handler = handler;
         return repowerd::HandlerRegistration(
-            [this] { light_handler = [](double){}; });
+            [this] { light_handler = [](repowerd::LightSamples const&){}; });
     }
 
     void enable_light_events() override { enabled = true; }
@@ -110,10 +129,10 @@ public:
     void emit_light_if_enabled(double light)
     {
         if (enabled)
-            light_handler(light);
+            light_handler({{std::chrono::steady_clock::now(), light}});
     }
 
-    repowerd::LightHandler light_handler{[](double){}};
+    repowerd::LightHandler light_handler{[](repowerd::LightSamples const&){}};
     bool enabled{false};
 };
 
@@ -126,9 +145,10 @@ public:
         return true;
     }
 
-    void new_light_value(double light) override
+    void new_light_values(repowerd::LightSamples const& samples) override
     {
-        light_history.push_back(light);
+        for (auto const& sample : samples)
+            light_history.push_back(sample.light);
     }
 
     void start() override
@@ -169,17 +189,45 @@ public:
 
 struct ABacklightBrightnessControl : Test
 {
+    bool wait_for_brightness_value(double brightness)
+    {
+        return rt::spin_wait_for_condition_or_timeout(
+            [&] { return backlight.get_brightness() == brightness; },
+            default_timeout,
+            1ms);
+    }
+
+    // Transitions are driven by timers, but progress according to the
+    // fake chrono, so advance it enough for any transition to complete
     void expect_brightness_value(double brightness)
     {
-        EXPECT_THAT(backlight.brightness_history.back(), Eq(brightness));
+        fake_chrono.sleep_for(1s);
+        wait_for_brightness_value(brightness);
+        EXPECT_THAT(backlight.get_brightness(), Eq(brightness));
+    }
+
+    // Allow the transition timers to observe the current fake chrono time
+    void run_transition_timers()
+    {
+        std::this_thread::sleep_for(50ms);
     }
 
-    std::chrono::milliseconds fake_chrono_duration_of(std::function<void()> const& func)
+    // Overdue transition steps are skipped, so advance the fake chrono a
+    // millisecond (i.e. at most one step) at a time until the transition
+    // reaches the expected brightness, letting the timers write each step
+    void run_transition_step_by_step(double brightness)
     {
-        auto start = fake_chrono.steady_now();
-        func();
-        return std::chrono::duration_cast<std::chrono::milliseconds>(
-            fake_chrono.steady_now() - start);
+        for (auto elapsed = 0ms;
+             backlight.get_brightness() != brightness && elapsed < 1s;
+             elapsed += 1ms)
+        {
+            auto const history_size = backlight.history().size();
+            fake_chrono.sleep_for(1ms);
+            rt::spin_wait_for_condition_or_timeout(
+                [&] { return backlight.history().size() > history_size; }, 5ms, 1ms);
+        }
+
+        EXPECT_THAT(backlight.get_brightness(), Eq(brightness));
     }
 
     rt::FakeDeviceConfig fake_device_config;
@@ -189,6 +237,8 @@ struct ABacklightBrightnessControl : Test
     rt::FakeChrono fake_chrono;
     rt::FakeLog fake_log;
     rt::FakeDeviceQuirks fake_device_quirks;
+    repowerd::BrightnessCurve const linear_curve{
+        repowerd::BrightnessCurve::Easing::linear, false, 0};
     repowerd::BacklightBrightnessControl brightness_control{
         rt::fake_shared(backlight), 
         rt::fake_shared(light_sensor), 
@@ -196,7 +246,8 @@ struct ABacklightBrightnessControl : Test
         rt::fake_shared(fake_chrono),
         rt::fake_shared(fake_log),
         fake_device_config,
-        fake_device_quirks};
+        fake_device_quirks,
+        linear_curve};
 
     double const normal_percent =
         static_cast<double>(fake_device_config.brightness_default_value) /
@@ -209,11 +260,6 @@ struct ABacklightBrightnessControl : Test
     std::chrono::seconds default_timeout{3};
 };
 
-MATCHER_P(IsAbout, a, "")
-{
-    return arg >= a && arg <= a + 10ms;
-}
-
 }
 
 TEST_F(ABacklightBrightnessControl,
@@ -268,21 +314,28 @@ TEST_F(ABacklightBrightnessControl,
 TEST_F(ABacklightBrightnessControl, transitions_smoothly_between_brightness_values_when_increasing)
 {
     brightness_control.set_off_brightness();
+    expect_brightness_value(0.0);
+    backlight.clear_brightness_history();
+
     brightness_control.set_normal_brightness();
+    run_transition_step_by_step(normal_percent);
 
-    EXPECT_THAT(backlight.brightness_history.size(), Ge(20));
+    EXPECT_THAT(backlight.history().size(), Ge(20));
     EXPECT_THAT(backlight.brightness_steps_stddev(), Le(0.01));
 }
 
 TEST_F(ABacklightBrightnessControl, transitions_smoothly_between_brightness_values_when_decreasing)
 {
     brightness_control.set_off_brightness();
+    expect_brightness_value(0.0);
     brightness_control.set_normal_brightness();
+    expect_brightness_value(normal_percent);
     backlight.clear_brightness_history();
 
     brightness_control.set_off_brightness();
+    run_transition_step_by_step(0.0);
 
-    EXPECT_THAT(backlight.brightness_history.size(), Ge(20));
+    EXPECT_THAT(backlight.history().size(), Ge(20));
     EXPECT_THAT(backlight.brightness_steps_stddev(), Le(0.01));
 }
 
@@ -290,13 +343,153 @@ TEST_F(ABacklightBrightnessControl,
        transitions_between_zero_and_non_zero_brightness_in_100ms)
 {
     brightness_control.set_off_brightness();
+    expect_brightness_value(0.0);
+
+    brightness_control.set_normal_brightness();
+    fake_chrono.sleep_for(90ms);
+    run_transition_timers();
+    EXPECT_THAT(backlight.get_brightness(), Lt(normal_percent));
+    fake_chrono.sleep_for(10ms);
+    EXPECT_TRUE(wait_for_brightness_value(normal_percent));
+
+    brightness_control.set_off_brightness();
+    fake_chrono.sleep_for(90ms);
+    run_transition_timers();
+    EXPECT_THAT(backlight.get_brightness(), Gt(0.0));
+    fake_chrono.sleep_for(10ms);
+    EXPECT_TRUE(wait_for_brightness_value(0.0));
+}
+
+TEST_F(ABacklightBrightnessControl, limits_transition_steps_to_max_steps_per_second)
+{
+    repowerd::BacklightBrightnessControl capped_brightness_control{
+        rt::fake_shared(backlight),
+        rt::fake_shared(light_sensor),
+        rt::fake_shared(autobrightness_algorithm),
+        rt::fake_shared(fake_chrono),
+        rt::fake_shared(fake_log),
+        fake_device_config,
+        fake_device_quirks,
+        repowerd::BrightnessCurve{
+            repowerd::BrightnessCurve::Easing::linear, true, 60}};
+
+    auto const prev_history_size = backlight.history().size();
+
+    capped_brightness_control.set_off_brightness();
+    run_transition_step_by_step(0.0);
+
+    // 100ms at 60 steps per second
+    EXPECT_THAT(backlight.history().size(), Eq(prev_history_size + 6));
+}
+
+TEST_F(ABacklightBrightnessControl, does_not_wait_for_transition_to_complete)
+{
+    brightness_control.set_dim_brightness();
+
+    EXPECT_THAT(backlight.get_brightness(), Gt(dim_percent));
+
+    expect_brightness_value(dim_percent);
+}
+
+TEST_F(ABacklightBrightnessControl, does_not_wait_for_fade_out_to_complete)
+{
+    auto const off_start = fake_chrono.steady_now();
+
+    brightness_control.set_off_brightness();
+
+    EXPECT_THAT(backlight.get_brightness(), Gt(0.0));
+    EXPECT_THAT(fake_chrono.steady_now(), Eq(off_start));
+
+    expect_brightness_value(0.0);
+}
+
+TEST_F(ABacklightBrightnessControl, retargets_transition_in_flight_to_off_brightness)
+{
+    brightness_control.set_normal_brightness_value(0.7);
+    brightness_control.set_normal_brightness();
+    fake_chrono.sleep_for(10ms);
+    run_transition_timers();
+    ASSERT_THAT(backlight.get_brightness(), Lt(0.7));
+    backlight.clear_brightness_history();
+
+    brightness_control.set_off_brightness();
+    EXPECT_THAT(backlight.get_brightness(), Gt(0.0));
+
+    run_transition_step_by_step(0.0);
+    EXPECT_THAT(backlight.brightness_steps(), Each(Le(0.01 + 1e-9)));
+}
+
+TEST_F(ABacklightBrightnessControl, transitions_to_dim_if_set_while_fading_out)
+{
+    brightness_control.set_off_brightness();
+    fake_chrono.sleep_for(90ms);
+    run_transition_timers();
+    ASSERT_THAT(backlight.get_brightness(), AllOf(Gt(0.0), Lt(dim_percent)));
+
+    brightness_control.set_dim_brightness();
 
-    EXPECT_THAT(fake_chrono_duration_of([&]{brightness_control.set_normal_brightness();}),
-                IsAbout(100ms));
-    EXPECT_THAT(fake_chrono_duration_of([&]{brightness_control.set_off_brightness();}),
-                IsAbout(100ms));
-    EXPECT_THAT(fake_chrono_duration_of([&]{brightness_control.set_dim_brightness();}),
-                IsAbout(100ms));
+    expect_brightness_value(dim_percent);
+}
+
+TEST_F(ABacklightBrightnessControl, writes_only_the_current_step_of_overdue_steps)
+{
+    brightness_control.set_dim_brightness();
+    auto const history_size = backlight.history().size();
+
+    // 20 more of the 45 1ms steps of the transition are due at once
+    fake_chrono.sleep_for(20ms);
+    run_transition_timers();
+
+    EXPECT_THAT(backlight.history().size(), Eq(history_size + 1));
+    EXPECT_THAT(backlight.get_brightness(),
+                DoubleNear(normal_percent - (normal_percent - dim_percent) * 21 / 45, 1e-9));
+}
+
+TEST_F(ABacklightBrightnessControl, retargets_transition_in_flight_without_restarting_it)
+{
+    brightness_control.set_dim_brightness();
+    fake_chrono.sleep_for(20ms);
+    run_transition_timers();
+
+    auto const brightness_before_retarget = backlight.get_brightness();
+    ASSERT_THAT(brightness_before_retarget, Lt(backlight.starting_brightness));
+    ASSERT_THAT(brightness_before_retarget, Gt(dim_percent));
+    backlight.clear_brightness_history();
+
+    brightness_control.set_normal_brightness_value(0.7);
+    brightness_control.set_normal_brightness();
+    run_transition_step_by_step(0.7);
+
+    auto const history = backlight.history();
+    EXPECT_THAT(*std::min_element(history.begin(), history.end()),
+                Ge(brightness_before_retarget));
+    EXPECT_THAT(backlight.brightness_steps(), Each(Le(0.01 + 1e-9)));
+}
+
+TEST_F(ABacklightBrightnessControl, notifies_of_brightness_only_when_transition_completes)
+{
+    std::atomic<int> notifications{0};
+    std::atomic<double> notified_brightness{0.0};
+
+    auto const handler_registration =
+        brightness_control.register_brightness_handler(
+            [&](double brightness)
+            {
+                notified_brightness = brightness;
+                ++notifications;
+            });
+
+    brightness_control.set_normal_brightness_value(0.7);
+    brightness_control.set_dim_brightness();
+    brightness_control.set_normal_brightness();
+    expect_brightness_value(0.7);
+
+    rt::spin_wait_for_condition_or_timeout(
+        [&] { return notifications > 0; }, default_timeout);
+    run_transition_timers();
+
+    EXPECT_THAT(notifications.load(), Eq(1));
+    EXPECT_THAT(notified_brightness.load(), Eq(0.7));
 }
 
 TEST_F(ABacklightBrightnessControl,
@@ -397,14 +590,16 @@ TEST_F(ABacklightBrightnessControl,
 TEST_F(ABacklightBrightnessControl,
        does_not_set_normal_brightness_when_set_to_normal_mode_if_autobrightness_enabled)
 {
-    auto const prev_history_size = backlight.brightness_history.size();
+    auto const prev_history_size = backlight.history().size();
 
     brightness_control.enable_autobrightness();
     brightness_control.set_normal_brightness();
+    run_transition_timers();
 
-    EXPECT_THAT(backlight.brightness_history.size(), Eq(prev_history_size));
+    EXPECT_THAT(backlight.history().size(), Eq(prev_history_size));
 
     brightness_control.set_off_brightness();
+    expect_brightness_value(0.0);
     brightness_control.set_normal_brightness();
 
     expect_brightness_value(0.0);
@@ -421,7 +616,8 @@ TEST_F(ABacklightBrightnessControl,
         rt::fake_shared(fake_chrono),
         rt::fake_shared(fake_log),
         fake_device_config,
-        fake_device_quirks};
+        fake_device_quirks,
+        linear_curve};
 
     quirked_brightness_control.enable_autobrightness();
     quirked_brightness_control.set_normal_brightness();
@@ -518,6 +714,36 @@ TEST_F(ABacklightBrightnessControl,
 {
     EXPECT_CALL(autobrightness_algorithm.mock, stop()).Times(1);
     brightness_control.set_off_brightness();
+    expect_brightness_value(0.0);
+    Mock::VerifyAndClearExpectations(&autobrightness_algorithm.mock);
+}
+
+TEST_F(ABacklightBrightnessControl,
+       stops_autobrightness_algorithm_only_when_fade_out_completes)
+{
+    EXPECT_CALL(autobrightness_algorithm.mock, stop()).Times(0);
+    brightness_control.set_off_brightness();
+    Mock::VerifyAndClearExpectations(&autobrightness_algorithm.mock);
+
+    EXPECT_CALL(autobrightness_algorithm.mock, stop()).Times(1);
+    expect_brightness_value(0.0);
+    Mock::VerifyAndClearExpectations(&autobrightness_algorithm.mock);
+}
+
+TEST_F(ABacklightBrightnessControl,
+       reverses_fade_out_without_restarting_autobrightness_when_setting_normal_brightness)
+{
+    brightness_control.set_normal_brightness();
+    brightness_control.enable_autobrightness();
+    autobrightness_algorithm.emit_autobrightness(0.7);
+    expect_brightness_value(0.7);
+
+    EXPECT_CALL(autobrightness_algorithm.mock, start()).Times(0);
+    EXPECT_CALL(autobrightness_algorithm.mock, stop()).Times(0);
+    brightness_control.set_off_brightness();
+    brightness_control.set_normal_brightness();
+
+    expect_brightness_value(0.7);
     Mock::VerifyAndClearExpectations(&autobrightness_algorithm.mock);
 }
 
@@ -546,7 +772,7 @@ TEST_F(ABacklightBrightnessControl,
 
 TEST_F(ABacklightBrightnessControl, notifies_of_brightness_change)
 {
-    double notified_brightness{0.0};
+    std::atomic<double> notified_brightness{0.0};
 
     auto const handler_registration =
         brightness_control.register_brightness_handler(
@@ -554,17 +780,23 @@ TEST_F(ABacklightBrightnessControl, notifies_of_brightness_change)
 
     brightness_control.set_normal_brightness();
     brightness_control.set_normal_brightness_value(0.9);
+    expect_brightness_value(0.9);
 
-    EXPECT_THAT(notified_brightness, Eq(0.9));
+    rt::spin_wait_for_condition_or_timeout(
+        [&] { return notified_brightness == 0.9; }, default_timeout);
+    EXPECT_THAT(notified_brightness.load(), Eq(0.9));
 
     brightness_control.set_dim_brightness();
+    expect_brightness_value(dim_percent);
 
-    EXPECT_THAT(notified_brightness, Eq(dim_percent));
+    rt::spin_wait_for_condition_or_timeout(
+        [&] { return notified_brightness == dim_percent; }, default_timeout);
+    EXPECT_THAT(notified_brightness.load(), Eq(dim_percent));
 }
 
 TEST_F(ABacklightBrightnessControl, notifies_of_autobrightness_change)
 {
-    double notified_brightness{0.0};
+    std::atomic<double> notified_brightness{0.0};
 
     auto const handler_registration =
         brightness_control.register_brightness_handler(
@@ -573,13 +805,16 @@ TEST_F(ABacklightBrightnessControl, notifies_of_autobrightness_change)
     brightness_control.set_normal_brightness();
     brightness_control.enable_autobrightness();
     autobrightness_algorithm.emit_autobrightness(0.9);
+    expect_brightness_value(0.9);
 
-    EXPECT_THAT(notified_brightness, Eq(0.9));
+    rt::spin_wait_for_condition_or_timeout(
+        [&] { return notified_brightness == 0.9; }, default_timeout);
+    EXPECT_THAT(notified_brightness.load(), Eq(0.9));
 }
 
 TEST_F(ABacklightBrightnessControl, does_not_notify_if_brightness_does_not_change)
 {
-    double notified_brightness{-1.0};
+    std::atomic<double> notified_brightness{-1.0};
 
     auto const handler_registration =
         brightness_control.register_brightness_handler(
@@ -591,13 +826,15 @@ TEST_F(ABacklightBrightnessControl, does_not_notify_if_brightness_does_not_chang
     brightness_control.set_normal_brightness_value(backlight.starting_brightness);
     brightness_control.enable_autobrightness();
     autobrightness_algorithm.emit_autobrightness(backlight.starting_brightness);
+    run_transition_timers();
 
-    EXPECT_THAT(notified_brightness, Eq(-1.0));
+    EXPECT_THAT(notified_brightness.load(), Eq(-1.0));
 }
 
 TEST_F(ABacklightBrightnessControl, logs_brightness_transition)
 {
     brightness_control.set_off_brightness();
+    expect_brightness_value(0.0);
 
     EXPECT_TRUE(fake_log.contains_line(
         {std::to_string(normal_percent).substr(0, 4), "0.00", "steps"}));
@@ -616,12 +853,12 @@ TEST_F(ABacklightBrightnessControl, does_not_log_null_brightness_transition)
 TEST_F(ABacklightBrightnessControl, transitions_directly_to_new_value_if_current_is_unknown)
 {
     backlight.set_brightness(repowerd::Backlight::unknown_brightness);
-    auto const prev_history_size = backlight.brightness_history.size();
+    auto const prev_history_size = backlight.history().size();
 
     brightness_control.set_dim_brightness();
 
-    EXPECT_THAT(backlight.brightness_history.size(), Eq(prev_history_size + 1));
     expect_brightness_value(dim_percent);
+    EXPECT_THAT(backlight.history().size(), Eq(prev_history_size + 1));
 }
 
 TEST_F(ABacklightBrightnessControl, logs_autobrightness_values)
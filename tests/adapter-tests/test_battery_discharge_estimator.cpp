@@ -0,0 +1,160 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/adapters/battery_discharge_estimator.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct ABatteryDischargeEstimator : Test
+{
+    void add_samples_every(
+        std::chrono::seconds interval,
+        std::vector<double> const& percentages,
+        double energy_rate = 0.0)
+    {
+        for (auto const percentage : percentages)
+        {
+            estimator.add_sample(now, percentage, energy_rate);
+            now += interval;
+        }
+    }
+
+    repowerd::BatteryDischargeEstimator estimator;
+    repowerd::BatteryDischargeEstimator::TimePoint now{};
+};
+
+}
+
+TEST_F(ABatteryDischargeEstimator, is_unknown_without_enough_samples)
+{
+    add_samples_every(60s, {50.0});
+
+    auto const estimate = estimator.estimate();
+
+    EXPECT_THAT(estimate.discharge_rate, Eq(0.0));
+    EXPECT_THAT(estimate.time_to_empty, Eq(0s));
+}
+
+TEST_F(ABatteryDischargeEstimator, is_unknown_for_samples_spanning_a_short_time)
+{
+    add_samples_every(1s, {50.0, 49.0, 48.0});
+
+    EXPECT_THAT(estimator.estimate().time_to_empty, Eq(0s));
+}
+
+TEST_F(ABatteryDischargeEstimator, estimates_steady_discharge)
+{
+    add_samples_every(60s, {50.0, 49.0, 48.0, 47.0});
+
+    auto const estimate = estimator.estimate();
+
+    EXPECT_THAT(estimate.discharge_rate, DoubleNear(60.0, 1e-9));
+    EXPECT_THAT(estimate.time_to_empty, Eq(47min));
+}
+
+TEST_F(ABatteryDischargeEstimator, smooths_percentage_granularity)
+{
+    add_samples_every(30s, {50.0, 50.0, 49.0, 49.0, 48.0, 48.0, 47.0, 47.0});
+
+    auto const estimate = estimator.estimate();
+
+    EXPECT_THAT(estimate.discharge_rate, DoubleNear(60.0, 10.0));
+}
+
+TEST_F(ABatteryDischargeEstimator, scales_rate_by_current_load)
+{
+    add_samples_every(60s, {50.0, 49.0, 48.0}, 5.0);
+    add_samples_every(60s, {47.0, 46.0}, 20.0);
+
+    auto const estimate = estimator.estimate();
+
+    // The mean energy rate is 11, so the current rate is 20 / 11 times
+    // the 60% per hour the percentages alone suggest
+    EXPECT_THAT(estimate.discharge_rate, DoubleNear(60.0 * 20.0 / 11.0, 1e-9));
+}
+
+TEST_F(ABatteryDischargeEstimator, ignores_single_energy_rate_spike)
+{
+    add_samples_every(60s, {50.0, 49.0, 48.0, 47.0}, 5.0);
+    add_samples_every(60s, {46.0}, 100.0);
+
+    auto const estimate = estimator.estimate();
+
+    // The median of the latest rates is still 5, against a mean of 24
+    EXPECT_THAT(estimate.discharge_rate, DoubleNear(60.0 * 5.0 / 24.0, 1e-9));
+    EXPECT_THAT(estimate.time_to_empty, Gt(1h));
+}
+
+TEST_F(ABatteryDischargeEstimator, is_unknown_when_not_discharging)
+{
+    add_samples_every(60s, {50.0, 50.0, 50.0});
+
+    EXPECT_THAT(estimator.estimate().time_to_empty, Eq(0s));
+}
+
+TEST_F(ABatteryDischargeEstimator, forgets_samples_from_before_charging)
+{
+    add_samples_every(60s, {50.0, 40.0, 30.0, 60.0});
+
+    EXPECT_THAT(estimator.estimate().time_to_empty, Eq(0s));
+}
+
+TEST_F(ABatteryDischargeEstimator, keeps_only_latest_samples)
+{
+    std::vector<double> fast_discharge;
+    for (auto i = 0u; i < repowerd::BatteryDischargeEstimator::capacity; ++i)
+        fast_discharge.push_back(90.0 - 2.0 * i);
+    add_samples_every(60s, fast_discharge);
+
+    std::vector<double> slow_discharge;
+    for (auto i = 1u; i <= repowerd::BatteryDischargeEstimator::capacity; ++i)
+        slow_discharge.push_back(fast_discharge.back() - 1.0 * i);
+    add_samples_every(60s, slow_discharge);
+
+    EXPECT_THAT(estimator.estimate().discharge_rate, DoubleNear(60.0, 1e-9));
+}
+
+TEST_F(ABatteryDischargeEstimator, reports_mean_sample_interval)
+{
+    add_samples_every(20s, {50.0, 49.0, 48.0});
+
+    EXPECT_THAT(estimator.mean_sample_interval(), Eq(20s));
+}
+
+TEST(ABatteryEstimates, keeps_latest_estimate_per_battery)
+{
+    repowerd::BatteryEstimates estimates;
+
+    estimates.update("bat0", {10.0, 100s});
+    estimates.update("bat1", {20.0, 200s});
+    estimates.update("bat0", {30.0, 300s});
+    estimates.remove("bat1");
+
+    auto const all = estimates.all();
+
+    ASSERT_THAT(all.size(), Eq(1u));
+    EXPECT_THAT(all[0].first, StrEq("bat0"));
+    EXPECT_THAT(all[0].second.discharge_rate, Eq(30.0));
+    EXPECT_THAT(all[0].second.time_to_empty, Eq(300s));
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/adapters/brightness_curve.h"
+
+#include <gmock/gmock.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+using Easing = repowerd::BrightnessCurve::Easing;
+
+TEST(ABrightnessCurve, interpolates_linearly_in_linear_space)
+{
+    repowerd::BrightnessCurve const curve{Easing::linear, false, 0};
+
+    EXPECT_THAT(curve.value_at(0.2, 0.6, 0.0), DoubleEq(0.2));
+    EXPECT_THAT(curve.value_at(0.2, 0.6, 0.5), DoubleEq(0.4));
+    EXPECT_THAT(curve.value_at(0.2, 0.6, 1.0), DoubleEq(0.6));
+}
+
+TEST(ABrightnessCurve, spends_more_of_the_transition_in_dark_range_in_perceptual_space)
+{
+    repowerd::BrightnessCurve const curve{Easing::linear, true, 0};
+
+    EXPECT_THAT(curve.value_at(0.0, 1.0, 0.0), DoubleNear(0.0, 1e-9));
+    EXPECT_THAT(curve.value_at(0.0, 1.0, 0.5), Lt(0.25));
+    EXPECT_THAT(curve.value_at(0.0, 1.0, 1.0), DoubleNear(1.0, 1e-9));
+}
+
+TEST(ABrightnessCurve, is_monotonic_for_all_easings)
+{
+    for (auto const easing : {Easing::linear, Easing::ease_in,
+                              Easing::ease_out, Easing::ease_in_out})
+    {
+        repowerd::BrightnessCurve const curve{easing, true, 0};
+
+        auto prev = curve.value_at(0.9, 0.1, 0.0);
+        for (int i = 1; i <= 100; ++i)
+        {
+            auto const value = curve.value_at(0.9, 0.1, i / 100.0);
+            EXPECT_THAT(value, Le(prev));
+            prev = value;
+        }
+        EXPECT_THAT(prev, DoubleNear(0.1, 1e-9));
+    }
+}
+
+TEST(ABrightnessCurve, uses_one_step_per_backlight_level)
+{
+    repowerd::BrightnessCurve const curve{Easing::linear, false, 0};
+
+    EXPECT_THAT(curve.num_steps(0.0, 0.5, 255, 100ms), Eq(128));
+    EXPECT_THAT(curve.num_steps(0.5, 0.5, 255, 100ms), Eq(1));
+    EXPECT_THAT(curve.num_steps(0.5, 0.4, 10, 100ms), Eq(1));
+}
+
+TEST(ABrightnessCurve, visits_every_backlight_level_along_the_curve)
+{
+    int const num_levels{255};
+
+    for (auto const easing : {Easing::linear, Easing::ease_in,
+                              Easing::ease_out, Easing::ease_in_out})
+    {
+        for (auto const perceptual : {false, true})
+        {
+            repowerd::BrightnessCurve const curve{easing, perceptual, 0};
+
+            for (auto const& range : {std::make_pair(0.0, 1.0),
+                                     std::make_pair(0.9, 0.1),
+                                     std::make_pair(0.02, 0.3)})
+            {
+                auto const steps = curve.num_steps(range.first, range.second, num_levels, 100ms);
+
+                auto prev = std::round(range.first * num_levels);
+                for (int i = 1; i <= steps; ++i)
+                {
+                    auto const level = std::round(
+                        curve.value_at(range.first, range.second,
+                                       static_cast<double>(i) / steps) * num_levels);
+                    EXPECT_THAT(std::fabs(level - prev), Le(1.0));
+                    prev = level;
+                }
+            }
+        }
+    }
+}
+
+TEST(ABrightnessCurve, needs_more_steps_in_perceptual_space)
+{
+    repowerd::BrightnessCurve const linear{Easing::linear, false, 0};
+    repowerd::BrightnessCurve const perceptual{Easing::linear, true, 0};
+
+    EXPECT_THAT(perceptual.num_steps(0.0, 0.5, 255, 100ms),
+                Gt(linear.num_steps(0.0, 0.5, 255, 100ms)));
+}
+
+TEST(ABrightnessCurve, limits_steps_to_max_steps_per_second)
+{
+    repowerd::BrightnessCurve const curve{Easing::linear, true, 60};
+
+    EXPECT_THAT(curve.num_steps(0.0, 0.5, 255, 100ms), Eq(6));
+    EXPECT_THAT(curve.num_steps(0.0, 0.5, 255, 1ms), Eq(1));
+    EXPECT_THAT(curve.num_steps(0.0, 0.01, 255, 1s), Eq(3));
+}
+
+TEST(ABrightnessCurve, parses_easing_names)
+{
+    EXPECT_THAT(repowerd::BrightnessCurve::easing_from_string("linear"), Eq(Easing::linear));
+    EXPECT_THAT(repowerd::BrightnessCurve::easing_from_string("ease-in"), Eq(Easing::ease_in));
+    EXPECT_THAT(repowerd::BrightnessCurve::easing_from_string("ease-out"), Eq(Easing::ease_out));
+    EXPECT_THAT(repowerd::BrightnessCurve::easing_from_string("ease-in-out"), Eq(Easing::ease_in_out));
+    EXPECT_THROW(repowerd::BrightnessCurve::easing_from_string("bouncy"), std::invalid_argument);
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "dbus_bus.h"
+#include "dbus_client.h"
+#include "src/adapters/dbus_connection_handle.h"
+#include "src/adapters/dbus_event_loop.h"
+
+#include "wait_condition.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <memory>
+
+using namespace testing;
+
+namespace rt = repowerd::test;
+
+namespace
+{
+
+struct ADBusConnectionHandle : Test
+{
+    ~ADBusConnectionHandle()
+    {
+        repowerd::DBusConnectionHandle::enable_shared_connections(false);
+    }
+
+    rt::DBusBus bus;
+    std::chrono::seconds const default_timeout{3};
+};
+
+char const* const test_interface = "com.test.Interface";
+
+}
+
+TEST_F(ADBusConnectionHandle, uses_separate_connections_by_default)
+{
+    repowerd::DBusConnectionHandle handle1{bus.address()};
+    repowerd::DBusConnectionHandle handle2{bus.address()};
+
+    EXPECT_THAT(static_cast<GDBusConnection*>(handle1),
+                Ne(static_cast<GDBusConnection*>(handle2)));
+}
+
+TEST_F(ADBusConnectionHandle, shares_connection_for_same_address_when_enabled)
+{
+    repowerd::DBusConnectionHandle::enable_shared_connections(true);
+
+    repowerd::DBusConnectionHandle handle1{bus.address()};
+    repowerd::DBusConnectionHandle handle2{bus.address()};
+
+    EXPECT_THAT(static_cast<GDBusConnection*>(handle1),
+                Eq(static_cast<GDBusConnection*>(handle2)));
+    EXPECT_THAT(g_dbus_connection_get_unique_name(handle1),
+                StrEq(g_dbus_connection_get_unique_name(handle2)));
+}
+
+TEST_F(ADBusConnectionHandle, keeps_shared_connection_open_until_last_handle_is_destroyed)
+{
+    repowerd::DBusConnectionHandle::enable_shared_connections(true);
+
+    auto handle1 = std::make_unique<repowerd::DBusConnectionHandle>(bus.address());
+    repowerd::DBusConnectionHandle handle2{bus.address()};
+
+    handle1.reset();
+
+    EXPECT_FALSE(g_dbus_connection_is_closed(handle2));
+    EXPECT_NO_THROW(handle2.request_name("com.test.Name"));
+}
+
+TEST_F(ADBusConnectionHandle, routes_signals_on_shared_connection_by_path)
+{
+    repowerd::DBusConnectionHandle::enable_shared_connections(true);
+
+    repowerd::DBusConnectionHandle handle1{bus.address()};
+    repowerd::DBusConnectionHandle handle2{bus.address()};
+    repowerd::DBusEventLoop event_loop1{"Loop1"};
+    repowerd::DBusEventLoop event_loop2{"Loop2"};
+
+    struct MockHandlers
+    {
+        MOCK_METHOD1(signal1, void(std::string const&));
+        MOCK_METHOD1(signal2, void(std::string const&));
+    };
+    NiceMock<MockHandlers> mock_handlers;
+
+    auto const registration1 = event_loop1.register_signal_handler(
+        handle1, nullptr, test_interface, "Signal", "/com/test/One",
+        [&] (GDBusConnection*, char const*, char const* path,
+             char const*, char const*, GVariant*)
+        {
+            mock_handlers.signal1(path);
+        });
+
+    auto const registration2 = event_loop2.register_signal_handler(
+        handle2, nullptr, test_interface, "Signal", "/com/test/Two",
+        [&] (GDBusConnection*, char const*, char const* path,
+             char const*, char const*, GVariant*)
+        {
+            mock_handlers.signal2(path);
+        });
+
+    rt::WaitCondition signal_received;
+
+    EXPECT_CALL(mock_handlers, signal1(_)).Times(0);
+    EXPECT_CALL(mock_handlers, signal2(StrEq("/com/test/Two")))
+        .WillOnce(WakeUp(&signal_received));
+
+    rt::DBusClient client{bus.address(), "com.test.Name", "/com/test/Two"};
+    client.emit_signal(test_interface, "Signal", nullptr);
+
+    signal_received.wait_for(default_timeout);
+    EXPECT_TRUE(signal_received.woken());
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "dbus_bus.h"
+#include "fake_log.h"
+#include "fake_shared.h"
+#include "src/adapters/dbus_connection_handle.h"
+#include "src/adapters/dbus_sender_credentials.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <string>
+
+#include <unistd.h>
+
+using namespace testing;
+
+namespace rt = repowerd::test;
+
+namespace
+{
+
+struct ADBusSenderCredentials : Test
+{
+    rt::DBusBus bus;
+    rt::FakeLog fake_log;
+    repowerd::DBusSenderCredentials sender_credentials{rt::fake_shared(fake_log)};
+    repowerd::DBusConnectionHandle connection{bus.address()};
+};
+
+}
+
+TEST_F(ADBusSenderCredentials, gets_pid_of_sender)
+{
+    repowerd::DBusConnectionHandle client{bus.address()};
+    std::string const sender = g_dbus_connection_get_unique_name(client);
+
+    EXPECT_THAT(sender_credentials.pid_for(connection, sender), Eq(getpid()));
+}
+
+TEST_F(ADBusSenderCredentials, reuses_pid_of_connected_sender)
+{
+    auto client = std::make_unique<repowerd::DBusConnectionHandle>(bus.address());
+    std::string const sender = g_dbus_connection_get_unique_name(*client);
+
+    sender_credentials.pid_for(connection, sender);
+    client.reset();
+
+    EXPECT_THAT(sender_credentials.pid_for(connection, sender), Eq(getpid()));
+}
+
+TEST_F(ADBusSenderCredentials, forgets_pid_of_disconnected_sender)
+{
+    auto client = std::make_unique<repowerd::DBusConnectionHandle>(bus.address());
+    std::string const sender = g_dbus_connection_get_unique_name(*client);
+
+    sender_credentials.pid_for(connection, sender);
+    client.reset();
+    sender_credentials.name_owner_changed(sender, sender, "");
+
+    EXPECT_THAT(sender_credentials.pid_for(connection, sender), Eq(-1));
+}
+
+TEST_F(ADBusSenderCredentials, logs_failed_lookup)
+{
+    std::string const sender{":1.999"};
+
+    EXPECT_THAT(sender_credentials.pid_for(connection, sender), Eq(-1));
+    EXPECT_TRUE(fake_log.contains_line({"failed", sender}));
+}
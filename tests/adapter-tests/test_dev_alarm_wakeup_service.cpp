@@ -143,7 +143,7 @@ struct ADevAlarmWakeupService : Test
 
     rt::FakeFilesystem fake_fs;
     FakeDevAlarm fake_dev_alarm{fake_fs};
-    repowerd::DevAlarmWakeupService wakeup_service{rt::fake_shared(fake_fs)};
+    repowerd::DevAlarmWakeupService wakeup_service{rt::fake_shared(fake_fs), 0ms};
     repowerd::HandlerRegistration handler_registration;
     std::mutex wakeup_mutex;
     std::condition_variable wakeup_cv;
@@ -227,11 +227,27 @@ TEST_F(ADevAlarmWakeupService, cancels_one_of_many_wakeups)
     wait_for_wakeups({cookie1, cookie3}, {tp1, tp3});
 }
 
+TEST_F(ADevAlarmWakeupService, coalesces_wakeups_within_slack)
+{
+    auto const tp1 = fake_dev_alarm.system_now() + 50ms;
+    auto const tp2 = fake_dev_alarm.system_now() + 100ms;
+
+    auto const cookie1 = wakeup_service.schedule_wakeup_at(tp1, 100ms);
+    auto const cookie2 = wakeup_service.schedule_wakeup_at(tp2, 0ms);
+
+    fake_dev_alarm.advance_time_by(50ms);
+    std::this_thread::sleep_for(50ms);
+    wait_for_wakeups({}, {});
+
+    fake_dev_alarm.advance_time_by(50ms);
+    wait_for_wakeups({cookie1, cookie2}, {tp2, tp2});
+}
+
 TEST_F(ADevAlarmWakeupService, throws_if_cannot_open_dev_alarm_at_construction)
 {
     EXPECT_THROW({
         rt::FakeFilesystem empty_fs;
-        repowerd::DevAlarmWakeupService wakeup_service(rt::fake_shared(empty_fs));
+        repowerd::DevAlarmWakeupService wakeup_service(rt::fake_shared(empty_fs), 0ms);
     }, std::exception);
 }
 
@@ -242,7 +258,7 @@ TEST_F(ADevAlarmWakeupService, throws_if_cannot_set_dev_alarm_at_construction)
         FakeDevAlarm local_fake_dev_alarm(local_fake_fs);
 
         local_fake_dev_alarm.fail_on_next_alarm_set();
-        repowerd::DevAlarmWakeupService wakeup_service(rt::fake_shared(local_fake_fs));
+        repowerd::DevAlarmWakeupService wakeup_service(rt::fake_shared(local_fake_fs), 0ms);
     }, std::exception);
 }
 
@@ -17,6 +17,7 @@
  */
 
 #include "src/adapters/event_loop.h"
+#include "src/adapters/event_loop_handler_registration.h"
 #include "src/adapters/fd.h"
 
 #include "current_thread_name.h"
@@ -25,8 +26,11 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <algorithm>
+#include <atomic>
 #include <mutex>
 #include <system_error>
+#include <vector>
 
 using namespace testing;
 
@@ -107,3 +111,193 @@ TEST(AnEventLoop, watches_fd)
     if (write(write_fd, "b", 1)) {}
     wait_for_string_contents(data, "ab", data_mutex);
 }
+
+TEST(AnEventLoop, runs_posted_actions_in_order_in_loop_thread)
+{
+    repowerd::EventLoop event_loop{"Posted"};
+
+    std::mutex data_mutex;
+    std::string data;
+    std::string thread_name;
+
+    for (char c = 'a'; c <= 'e'; ++c)
+    {
+        event_loop.post(
+            [&, c]
+            {
+                std::lock_guard<std::mutex> lock{data_mutex};
+                data += c;
+                thread_name = rt::current_thread_name();
+            });
+    }
+
+    wait_for_string_contents(data, "abcde", data_mutex);
+
+    std::lock_guard<std::mutex> lock{data_mutex};
+    EXPECT_THAT(thread_name, StrEq("Posted"));
+}
+
+TEST(AnEventLoop, keeps_running_posted_actions_after_one_throws)
+{
+    repowerd::EventLoop event_loop{"Posted"};
+
+    std::mutex data_mutex;
+    std::string data;
+
+    event_loop.post([] { throw std::runtime_error{"error"}; });
+    event_loop.post(
+        [&]
+        {
+            std::lock_guard<std::mutex> lock{data_mutex};
+            data += 'a';
+        });
+
+    wait_for_string_contents(data, "a", data_mutex);
+}
+
+TEST(AnEventLoop, runs_actions_posted_from_loop_thread_beyond_ring_capacity)
+{
+    repowerd::EventLoop event_loop{"Posted"};
+
+    int const num_actions = 1000;
+    std::mutex data_mutex;
+    std::vector<int> data;
+
+    event_loop.post(
+        [&]
+        {
+            for (int i = 0; i < num_actions; ++i)
+            {
+                event_loop.post(
+                    [&, i]
+                    {
+                        std::lock_guard<std::mutex> lock{data_mutex};
+                        data.push_back(i);
+                    });
+            }
+        });
+
+    auto const result = rt::spin_wait_for_condition_or_timeout(
+        [&]
+        {
+            std::lock_guard<std::mutex> lock{data_mutex};
+            return data.size() == static_cast<size_t>(num_actions);
+        },
+        std::chrono::seconds{3});
+
+    ASSERT_TRUE(result);
+    std::lock_guard<std::mutex> lock{data_mutex};
+    EXPECT_TRUE(std::is_sorted(data.begin(), data.end()));
+}
+
+TEST(AnEventLoop, knows_whether_caller_is_in_loop_thread)
+{
+    repowerd::EventLoop event_loop{"Loop"};
+
+    bool in_loop_thread = false;
+    event_loop.enqueue([&] { in_loop_thread = event_loop.in_loop_thread(); }).wait();
+
+    EXPECT_TRUE(in_loop_thread);
+    EXPECT_FALSE(event_loop.in_loop_thread());
+}
+
+TEST(AnEventLoop, allows_handler_registration_changes_from_loop_thread)
+{
+    repowerd::EventLoop event_loop{"Loop"};
+
+    int registered = 0;
+    event_loop.enqueue(
+        [&]
+        {
+            repowerd::EventLoopHandlerRegistration registration{
+                event_loop, [&] { ++registered; }, [&] { --registered; }};
+            EXPECT_THAT(registered, Eq(1));
+        }).wait();
+
+    EXPECT_THAT(registered, Eq(0));
+}
+
+namespace
+{
+
+struct ASharedReactorEventLoop : Test
+{
+    ASharedReactorEventLoop() { repowerd::EventLoop::enable_shared_reactor(true); }
+    ~ASharedReactorEventLoop() { repowerd::EventLoop::enable_shared_reactor(false); }
+};
+
+}
+
+TEST_F(ASharedReactorEventLoop, runs_all_loops_in_single_thread)
+{
+    repowerd::EventLoop event_loop1{"Loop1"};
+    repowerd::EventLoop event_loop2{"Loop2"};
+
+    std::thread::id thread_id1;
+    std::thread::id thread_id2;
+    std::string thread_name;
+
+    event_loop1.enqueue([&] { thread_id1 = std::this_thread::get_id(); }).wait();
+    event_loop2.enqueue(
+        [&]
+        {
+            thread_id2 = std::this_thread::get_id();
+            thread_name = rt::current_thread_name();
+        }).wait();
+
+    EXPECT_THAT(thread_id1, Eq(thread_id2));
+    EXPECT_THAT(thread_id1, Ne(std::this_thread::get_id()));
+    EXPECT_THAT(thread_name, StrEq("Reactor"));
+}
+
+TEST_F(ASharedReactorEventLoop, runs_nested_enqueue_without_deadlock)
+{
+    repowerd::EventLoop event_loop1{"Loop1"};
+    repowerd::EventLoop event_loop2{"Loop2"};
+
+    bool nested_called = false;
+
+    event_loop1.enqueue(
+        [&]
+        {
+            event_loop2.enqueue([&] { nested_called = true; }).wait();
+        }).wait();
+
+    EXPECT_TRUE(nested_called);
+}
+
+TEST_F(ASharedReactorEventLoop, can_be_constructed_from_reactor_thread)
+{
+    repowerd::EventLoop event_loop1{"Loop1"};
+
+    bool in_loop_thread = false;
+    auto const done = event_loop1.enqueue(
+        [&]
+        {
+            repowerd::EventLoop event_loop2{"Loop2"};
+            in_loop_thread = event_loop2.in_loop_thread();
+        });
+
+    ASSERT_THAT(done.wait_for(std::chrono::seconds{3}), Eq(std::future_status::ready));
+    EXPECT_TRUE(in_loop_thread);
+}
+
+TEST_F(ASharedReactorEventLoop, stop_cancels_only_own_scheduled_callbacks)
+{
+    repowerd::EventLoop event_loop1{"Loop1"};
+    repowerd::EventLoop event_loop2{"Loop2"};
+
+    std::atomic<bool> called1{false};
+    std::atomic<bool> called2{false};
+
+    event_loop1.schedule_in(std::chrono::milliseconds{50}, [&] { called1 = true; });
+    auto const done2 = event_loop2.schedule_in(
+        std::chrono::milliseconds{100}, [&] { called2 = true; });
+
+    event_loop1.stop();
+
+    done2.wait_for(std::chrono::seconds{3});
+
+    EXPECT_FALSE(called1);
+    EXPECT_TRUE(called2);
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "src/adapters/light_sample_batcher.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <vector>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct ALightSampleBatcher : Test
+{
+    repowerd::LightSample sample_at(std::chrono::milliseconds t, double light)
+    {
+        return {start + t, light};
+    }
+
+    std::vector<double> lights(repowerd::LightSamples const& samples)
+    {
+        std::vector<double> ret;
+        for (auto const& sample : samples)
+            ret.push_back(sample.light);
+        return ret;
+    }
+
+    int const batch_size{3};
+    std::chrono::milliseconds const min_sample_interval{100ms};
+    std::chrono::milliseconds const max_batch_delay{1000ms};
+    repowerd::LightSampleBatcher batcher{batch_size, min_sample_interval, max_batch_delay};
+    repowerd::LightSampleBatcher::TimePoint const start{};
+};
+
+}
+
+TEST_F(ALightSampleBatcher, delivers_first_sample_immediately)
+{
+    EXPECT_THAT(lights(batcher.add(sample_at(0ms, 10))), ElementsAre(10));
+    EXPECT_THAT(batcher.due_time(), Eq(repowerd::LightSampleBatcher::TimePoint::max()));
+}
+
+TEST_F(ALightSampleBatcher, delivers_full_batch)
+{
+    batcher.add(sample_at(0ms, 10));
+
+    EXPECT_THAT(batcher.add(sample_at(200ms, 20)), IsEmpty());
+    EXPECT_THAT(batcher.add(sample_at(400ms, 30)), IsEmpty());
+    EXPECT_THAT(lights(batcher.add(sample_at(600ms, 40))), ElementsAre(20, 30, 40));
+}
+
+TEST_F(ALightSampleBatcher, delivers_partial_batch_once_due)
+{
+    batcher.add(sample_at(0ms, 10));
+    batcher.add(sample_at(200ms, 20));
+    batcher.add(sample_at(400ms, 30));
+
+    EXPECT_THAT(batcher.due_time(), Eq(start + 200ms + max_batch_delay));
+    EXPECT_THAT(batcher.take_due(start + 1199ms), IsEmpty());
+    EXPECT_THAT(lights(batcher.take_due(start + 1200ms)), ElementsAre(20, 30));
+    EXPECT_THAT(batcher.due_time(), Eq(repowerd::LightSampleBatcher::TimePoint::max()));
+}
+
+TEST_F(ALightSampleBatcher, replaces_samples_closer_than_min_interval)
+{
+    batcher.add(sample_at(0ms, 10));
+    batcher.add(sample_at(200ms, 20));
+    batcher.add(sample_at(250ms, 21));
+    batcher.add(sample_at(299ms, 22));
+    batcher.add(sample_at(300ms, 30));
+
+    EXPECT_THAT(lights(batcher.take_due(start + 1200ms)), ElementsAre(22, 30));
+}
+
+TEST_F(ALightSampleBatcher, does_not_postpone_batch_when_replacing_samples)
+{
+    batcher.add(sample_at(0ms, 10));
+    batcher.add(sample_at(200ms, 20));
+
+    batcher.add(sample_at(250ms, 21));
+    batcher.add(sample_at(290ms, 22));
+
+    EXPECT_THAT(batcher.due_time(), Eq(start + 200ms + max_batch_delay));
+}
+
+TEST_F(ALightSampleBatcher, delivers_first_sample_immediately_again_after_reset)
+{
+    batcher.add(sample_at(0ms, 10));
+    batcher.add(sample_at(200ms, 20));
+
+    batcher.reset();
+
+    EXPECT_THAT(batcher.due_time(), Eq(repowerd::LightSampleBatcher::TimePoint::max()));
+    EXPECT_THAT(lights(batcher.add(sample_at(5000ms, 50))), ElementsAre(50));
+}
@@ -32,6 +32,8 @@
 
 #include <chrono>
 
+#include <unistd.h>
+
 namespace rt = repowerd::test;
 using namespace testing;
 using namespace std::chrono_literals;
@@ -318,6 +320,21 @@ TEST_F(ALogindSessionTracker,
                 StrEq(session_id(0)));
 }
 
+TEST_F(ALogindSessionTracker, does_not_cache_failed_session_lookups)
+{
+    auto const pid = getpid();
+
+    EXPECT_THAT(logind_session_tracker->session_for_pid(pid),
+                StrEq(repowerd::invalid_session_id));
+
+    fake_logind.add_session(session_id(2), "mir", pid, session_uid(2));
+    fake_logind.activate_session(session_id(2));
+    wait_until_active_session_is(session_id(2));
+
+    EXPECT_THAT(logind_session_tracker->session_for_pid(pid),
+                StrEq(session_id(2)));
+}
+
 TEST_F(ALogindSessionTracker, returns_active_session_id_for_pid_belonging_to_root)
 {
     pid_t const pid = 667;
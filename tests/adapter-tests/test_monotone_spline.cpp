@@ -20,6 +20,8 @@
 
 #include <gmock/gmock.h>
 
+#include <random>
+
 using namespace testing;
 
 namespace
@@ -104,3 +106,33 @@ TEST_F(AMonotoneSpline, with_fewer_than_two_point_cannot_be_created)
         repowerd::MonotoneSpline({{1,1}});
     }, std::logic_error);
 }
+
+TEST_F(AMonotoneSpline, is_monotone_for_random_monotone_points)
+{
+    std::mt19937 rng{1234};
+    std::uniform_real_distribution<double> step{0.0, 100.0};
+
+    for (int n = 0; n < 100; ++n)
+    {
+        std::vector<repowerd::MonotoneSpline::Point> random_points;
+        auto x = 0.0;
+        auto y = 0.0;
+        for (int i = 0; i < 2 + n % 64; ++i)
+        {
+            x += 1.0 + step(rng);
+            // Include flat stretches, which are hard to keep monotone
+            y += (i % 3 == 0) ? 0.0 : step(rng);
+            random_points.push_back({x, y});
+        }
+
+        repowerd::MonotoneSpline const random_spline{random_points};
+
+        auto prev_y = random_spline.interpolate(0.0);
+        for (auto xi = 0.0; xi < x + 10.0; xi += 0.37)
+        {
+            auto const yi = random_spline.interpolate(xi);
+            ASSERT_THAT(yi, Ge(prev_y)) << "x=" << xi;
+            prev_y = yi;
+        }
+    }
+}
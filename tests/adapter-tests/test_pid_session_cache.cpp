@@ -0,0 +1,210 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/adapters/pid_session_cache.h"
+
+#include "fake_filesystem.h"
+#include "fake_shared.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <csignal>
+
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace rt = repowerd::test;
+
+using namespace testing;
+
+namespace
+{
+
+struct ChildProcess
+{
+    ChildProcess()
+        : pid{fork()}
+    {
+        if (pid == 0)
+        {
+            pause();
+            _exit(0);
+        }
+    }
+
+    ~ChildProcess()
+    {
+        exit();
+    }
+
+    void exit()
+    {
+        if (pid > 0)
+        {
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+            pid = -1;
+        }
+    }
+
+    pid_t pid;
+};
+
+struct APidSessionCache : Test
+{
+    void insert(pid_t pid, std::string const& session_id)
+    {
+        cache.insert(pid, cache.identify(pid), session_id);
+    }
+
+    // Inserts an entry identified by its start time, as without pidfd support
+    void insert_polled(pid_t pid, uint64_t start_time, std::string const& session_id)
+    {
+        set_start_time(pid, start_time);
+        cache.insert(
+            pid,
+            {repowerd::Fd{-1}, start_time, cache.identify(pid).generation},
+            session_id);
+    }
+
+    void set_start_time(pid_t pid, uint64_t start_time)
+    {
+        fake_filesystem.add_file_with_contents(
+            "/proc/" + std::to_string(pid) + "/stat",
+            std::to_string(pid) + " (a process) S 1 1 1 0 -1 0 0 0 0 0 0 0 0 0 20 0 1 0 " +
+            std::to_string(start_time) + " 0 0");
+    }
+
+    bool wait_for_exit_notification()
+    {
+        pollfd pfd{cache.exit_notification_fd(), POLLIN, 0};
+        return poll(&pfd, 1, 3000) == 1;
+    }
+
+    rt::FakeFilesystem fake_filesystem;
+    repowerd::PidSessionCache cache{rt::fake_shared(fake_filesystem), 2};
+};
+
+}
+
+TEST_F(APidSessionCache, returns_cached_session_of_live_process)
+{
+    ChildProcess child;
+    insert(child.pid, "s1");
+
+    std::string session_id;
+    EXPECT_TRUE(cache.lookup(child.pid, session_id));
+    EXPECT_THAT(session_id, StrEq("s1"));
+}
+
+TEST_F(APidSessionCache, does_not_return_session_of_exited_process)
+{
+    ChildProcess child;
+    insert(child.pid, "s1");
+
+    child.exit();
+
+    std::string session_id;
+    EXPECT_FALSE(cache.lookup(child.pid, session_id));
+}
+
+TEST_F(APidSessionCache, removes_exited_processes_when_notified)
+{
+    ChildProcess child1;
+    ChildProcess child2;
+    insert(child1.pid, "s1");
+    insert(child2.pid, "s1");
+
+    child1.exit();
+
+    ASSERT_TRUE(wait_for_exit_notification());
+    cache.process_exit_notifications();
+
+    EXPECT_THAT(cache.size(), Eq(1u));
+}
+
+TEST_F(APidSessionCache, removes_entries_of_removed_session)
+{
+    ChildProcess child1;
+    ChildProcess child2;
+    insert(child1.pid, "s1");
+    insert(child2.pid, "s2");
+
+    cache.remove_session("s1");
+
+    std::string session_id;
+    EXPECT_FALSE(cache.lookup(child1.pid, session_id));
+    EXPECT_TRUE(cache.lookup(child2.pid, session_id));
+}
+
+TEST_F(APidSessionCache, ignores_sessions_resolved_before_it_was_cleared)
+{
+    ChildProcess child;
+
+    auto identity = cache.identify(child.pid);
+    cache.clear();
+    cache.insert(child.pid, std::move(identity), "s1");
+
+    EXPECT_THAT(cache.size(), Eq(0u));
+}
+
+TEST_F(APidSessionCache, evicts_least_recently_used_entry_when_full)
+{
+    ChildProcess child1;
+    ChildProcess child2;
+    ChildProcess child3;
+    insert(child1.pid, "s1");
+    insert(child2.pid, "s1");
+
+    std::string session_id;
+    cache.lookup(child1.pid, session_id);
+    insert(child3.pid, "s1");
+
+    EXPECT_THAT(cache.size(), Eq(2u));
+    EXPECT_TRUE(cache.lookup(child1.pid, session_id));
+    EXPECT_FALSE(cache.lookup(child2.pid, session_id));
+    EXPECT_TRUE(cache.lookup(child3.pid, session_id));
+}
+
+TEST_F(APidSessionCache, removes_polled_entries_of_exited_processes)
+{
+    pid_t const pid1{4001};
+    pid_t const pid2{4002};
+    insert_polled(pid1, 100, "s1");
+    insert_polled(pid2, 200, "s1");
+
+    // The pid was reused by a process started later
+    set_start_time(pid1, 300);
+
+    EXPECT_TRUE(cache.poll_exits());
+    EXPECT_THAT(cache.size(), Eq(1u));
+
+    set_start_time(pid2, 400);
+
+    EXPECT_FALSE(cache.poll_exits());
+    EXPECT_THAT(cache.size(), Eq(0u));
+}
+
+TEST_F(APidSessionCache, does_not_need_polling_for_entries_with_pidfd)
+{
+    ChildProcess child;
+    insert(child.pid, "s1");
+
+    EXPECT_FALSE(cache.poll_exits());
+}
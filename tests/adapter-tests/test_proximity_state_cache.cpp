@@ -0,0 +1,148 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "src/adapters/proximity_state_cache.h"
+
+#include "fake_chrono.h"
+#include "fake_shared.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace rt = repowerd::test;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct AProximityStateCache : Test
+{
+    std::chrono::milliseconds const freshness_window{1000ms};
+    std::chrono::milliseconds const linger_period{3000ms};
+    rt::FakeChrono fake_chrono;
+    repowerd::ProximityStateCache cache{
+        rt::fake_shared(fake_chrono), freshness_window, linger_period};
+};
+
+}
+
+TEST_F(AProximityStateCache, has_no_state_initially)
+{
+    EXPECT_FALSE(cache.has_state());
+    EXPECT_FALSE(cache.is_valid());
+    EXPECT_FALSE(cache.is_fresh());
+}
+
+TEST_F(AProximityStateCache, keeps_state_valid_while_sensor_is_powered)
+{
+    cache.record(repowerd::ProximityState::near);
+    fake_chrono.sleep_for(freshness_window + 1s);
+
+    EXPECT_TRUE(cache.is_valid());
+    EXPECT_THAT(cache.state(), Eq(repowerd::ProximityState::near));
+}
+
+TEST_F(AProximityStateCache, keeps_state_fresh_for_freshness_window_after_power_off)
+{
+    cache.record(repowerd::ProximityState::near);
+    fake_chrono.sleep_for(5s);
+    cache.sensor_powered_off();
+
+    fake_chrono.sleep_for(freshness_window);
+
+    EXPECT_FALSE(cache.is_valid());
+    EXPECT_TRUE(cache.is_fresh());
+    EXPECT_THAT(cache.state(), Eq(repowerd::ProximityState::near));
+}
+
+TEST_F(AProximityStateCache, state_becomes_stale_after_freshness_window)
+{
+    cache.record(repowerd::ProximityState::near);
+    cache.sensor_powered_off();
+
+    fake_chrono.sleep_for(freshness_window + 1ms);
+
+    EXPECT_FALSE(cache.is_fresh());
+    EXPECT_TRUE(cache.has_state());
+}
+
+TEST_F(AProximityStateCache, lingers_for_linger_period)
+{
+    EXPECT_TRUE(cache.start_linger());
+    EXPECT_TRUE(cache.is_lingering());
+    EXPECT_THAT(cache.linger_time_left(), Eq(linger_period));
+
+    fake_chrono.sleep_for(linger_period - 1ms);
+    EXPECT_THAT(cache.linger_time_left(), Eq(1ms));
+
+    fake_chrono.sleep_for(1ms);
+    EXPECT_THAT(cache.linger_time_left(), Eq(0ms));
+}
+
+TEST_F(AProximityStateCache, rounds_linger_time_left_up)
+{
+    cache.start_linger();
+
+    fake_chrono.sleep_for(linger_period - 500us);
+
+    EXPECT_THAT(cache.linger_time_left(), Eq(1ms));
+}
+
+TEST_F(AProximityStateCache, stops_lingering_when_reenabled_during_linger)
+{
+    cache.start_linger();
+    fake_chrono.sleep_for(1s);
+
+    cache.cancel_linger();
+
+    EXPECT_FALSE(cache.is_lingering());
+    EXPECT_THAT(cache.linger_time_left(), Eq(0ms));
+}
+
+TEST_F(AProximityStateCache, restarts_linger_period_after_reenable)
+{
+    cache.start_linger();
+    fake_chrono.sleep_for(2s);
+    cache.cancel_linger();
+
+    cache.start_linger();
+    fake_chrono.sleep_for(2s);
+
+    EXPECT_TRUE(cache.is_lingering());
+    EXPECT_THAT(cache.linger_time_left(), Eq(linger_period - 2s));
+}
+
+TEST_F(AProximityStateCache, stops_lingering_when_sensor_is_powered_off)
+{
+    cache.start_linger();
+
+    cache.sensor_powered_off();
+
+    EXPECT_FALSE(cache.is_lingering());
+}
+
+TEST_F(AProximityStateCache, does_not_linger_without_linger_period)
+{
+    repowerd::ProximityStateCache no_linger_cache{
+        rt::fake_shared(fake_chrono), freshness_window, 0ms};
+
+    EXPECT_FALSE(no_linger_cache.start_linger());
+    EXPECT_FALSE(no_linger_cache.is_lingering());
+}
@@ -46,3 +46,11 @@ TEST_F(ARealChrono, sleeps_for_right_amount_of_time)
 {
     EXPECT_THAT(rt::duration_of([&]{real_chrono.sleep_for(50ms);}), IsAbout(50ms));
 }
+
+TEST_F(ARealChrono, steady_now_advances_with_time)
+{
+    auto const start = real_chrono.steady_now();
+    real_chrono.sleep_for(50ms);
+
+    EXPECT_THAT(real_chrono.steady_now() - start, IsAbout(50ms));
+}
@@ -170,3 +170,15 @@ TEST_F(ARealFilesystem, writes_through_ostream)
 
     EXPECT_THAT(file_contents("/file"), StrEq("123"));
 }
+
+TEST_F(ARealFilesystem, reads_and_writes_through_fd)
+{
+    auto const fd = fs.open(full_path("/file").c_str(), O_RDWR);
+    EXPECT_THAT(fd, Ge(0));
+
+    EXPECT_THAT(fs.pwrite(fd, "12", 2, 1), Eq(2));
+
+    char buf[8]{};
+    EXPECT_THAT(fs.pread(fd, buf, sizeof(buf), 0), Eq(3));
+    EXPECT_THAT(buf, StrEq("a12"));
+}
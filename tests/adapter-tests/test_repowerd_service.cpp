@@ -17,6 +17,10 @@
  */
 
 #include "src/adapters/repowerd_service.h"
+#include "src/adapters/battery_discharge_estimator.h"
+#include "src/adapters/dbus_message_handle.h"
+#include "src/adapters/dbus_sender_credentials.h"
+#include "src/core/event_latency.h"
 #include "src/core/infinite_timeout.h"
 
 #include "dbus_bus.h"
@@ -99,8 +103,14 @@ struct ARepowerdService : testing::Test
 
     rt::DBusBus bus;
     rt::FakeLog fake_log;
+    repowerd::EventLatencyStats event_latency_stats;
+    repowerd::BatteryEstimates battery_estimates;
+    repowerd::DBusSenderCredentials sender_credentials{rt::fake_shared(fake_log)};
     repowerd::RepowerdService service{
         rt::fake_shared(fake_log),
+        rt::fake_shared(event_latency_stats),
+        rt::fake_shared(battery_estimates),
+        rt::fake_shared(sender_credentials),
         bus.address()};
     rt::RepowerdDBusClient client{bus.address()};
     std::vector<repowerd::HandlerRegistration> registrations;
@@ -379,3 +389,108 @@ TEST_F(ARepowerdService, logs_set_critical_power_behavior_request)
             fake_log.contains_line({"SetCriticalPowerBehavior", action_arg.str}));
     }
 }
+
+TEST_F(ARepowerdService, replies_to_get_event_latencies_request)
+{
+    auto const t0 = std::chrono::steady_clock::now();
+    event_latency_stats.record(
+        repowerd::EventType::power_button_press, t0, t0 + 2ms, t0 + 10ms);
+
+    auto reply = client.request_get_event_latencies().get();
+    auto const body = g_dbus_message_get_body(reply);
+
+    GVariantIter* iter;
+    g_variant_get(body, "(a(sttttttt))", &iter);
+
+    char const* name;
+    guint64 count, queue_p50, queue_p99, queue_max, total_p50, total_p99, total_max;
+    bool found = false;
+
+    while (g_variant_iter_next(
+            iter, "(&sttttttt)", &name, &count,
+            &queue_p50, &queue_p99, &queue_max,
+            &total_p50, &total_p99, &total_max))
+    {
+        if (std::string{name} != "power_button_press")
+            continue;
+
+        found = true;
+        EXPECT_THAT(count, Eq(1u));
+        EXPECT_THAT(queue_max, Eq(2000u));
+        EXPECT_THAT(total_max, Eq(10000u));
+    }
+
+    g_variant_iter_free(iter);
+
+    EXPECT_TRUE(found);
+}
+
+TEST_F(ARepowerdService, replies_to_get_battery_estimates_request)
+{
+    battery_estimates.update("/org/freedesktop/UPower/devices/battery_0", {12.5, 3600s});
+
+    auto reply = client.request_get_battery_estimates().get();
+    auto const body = g_dbus_message_get_body(reply);
+
+    GVariantIter* iter;
+    g_variant_get(body, "(a(sdt))", &iter);
+
+    char const* name;
+    double discharge_rate;
+    guint64 time_to_empty;
+
+    ASSERT_TRUE(g_variant_iter_next(iter, "(&sdt)", &name, &discharge_rate, &time_to_empty));
+    EXPECT_THAT(name, StrEq("/org/freedesktop/UPower/devices/battery_0"));
+    EXPECT_THAT(discharge_rate, Eq(12.5));
+    EXPECT_THAT(time_to_empty, Eq(3600u));
+    EXPECT_FALSE(g_variant_iter_next(iter, "(&sdt)", &name, &discharge_rate, &time_to_empty));
+
+    g_variant_iter_free(iter);
+}
+
+TEST_F(ARepowerdService, sets_log_levels)
+{
+    client.request_set_log_level("", "warning").get();
+    client.request_set_log_level("Tag", "trace").get();
+
+    EXPECT_THAT(fake_log.levels().default_level(), Eq(repowerd::LogLevel::warning));
+    EXPECT_TRUE(fake_log.is_enabled(repowerd::LogLevel::trace, "Tag"));
+
+    client.request_set_log_level("Tag", "").get();
+
+    EXPECT_FALSE(fake_log.is_enabled(repowerd::LogLevel::info, "Tag"));
+}
+
+TEST_F(ARepowerdService, does_not_set_invalid_log_levels)
+{
+    EXPECT_THROW({
+        client.request_set_log_level("Tag", "loud").get();
+    }, std::runtime_error);
+
+    EXPECT_THAT(fake_log.levels().tag_levels(), IsEmpty());
+}
+
+TEST_F(ARepowerdService, replies_to_get_log_levels_request)
+{
+    fake_log.levels().set_default_level(repowerd::LogLevel::info);
+    fake_log.levels().set_tag_level("Tag", repowerd::LogLevel::debug);
+
+    auto reply = client.request_get_log_levels().get();
+    auto const body = g_dbus_message_get_body(reply);
+
+    GVariantIter* iter;
+    g_variant_get(body, "(a(ss))", &iter);
+
+    char const* tag;
+    char const* level;
+
+    ASSERT_TRUE(g_variant_iter_next(iter, "(&s&s)", &tag, &level));
+    EXPECT_THAT(tag, StrEq(""));
+    EXPECT_THAT(level, StrEq("info"));
+    ASSERT_TRUE(g_variant_iter_next(iter, "(&s&s)", &tag, &level));
+    EXPECT_THAT(tag, StrEq("Tag"));
+    EXPECT_THAT(level, StrEq("debug"));
+    EXPECT_FALSE(g_variant_iter_next(iter, "(&s&s)", &tag, &level));
+
+    g_variant_iter_free(iter);
+}
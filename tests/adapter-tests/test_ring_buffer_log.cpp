@@ -0,0 +1,333 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/adapters/ring_buffer_log.h"
+
+#include "spin_wait.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <csignal>
+#include <unistd.h>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace rt = repowerd::test;
+
+namespace
+{
+
+struct RecordingLog : repowerd::Log
+{
+    void vlog(repowerd::LogLevel level, char const* tag, char const* format, va_list ap) override
+    {
+        char output[1024];
+        vsnprintf(output, sizeof(output), format, ap);
+
+        std::lock_guard<std::mutex> lock{lines_mutex};
+        lines.push_back(std::string{tag} + ": " + output);
+        levels_seen.push_back(level);
+    }
+
+    std::vector<std::string> the_lines()
+    {
+        std::lock_guard<std::mutex> lock{lines_mutex};
+        return lines;
+    }
+
+    std::mutex lines_mutex;
+    std::vector<std::string> lines;
+    std::vector<repowerd::LogLevel> levels_seen;
+};
+
+struct ARingBufferLog : testing::Test
+{
+    std::shared_ptr<RecordingLog> const sink{std::make_shared<RecordingLog>()};
+    size_t const records_per_thread{16};
+    std::chrono::milliseconds const long_flush_interval{1h};
+};
+
+}
+
+TEST_F(ARingBufferLog, formats_lines_only_when_drained)
+{
+    repowerd::RingBufferLog log{
+        sink, records_per_thread, long_flush_interval,
+        repowerd::RingBufferLog::SignalHandling::none};
+
+    log.log("tag", "int %d uint %u hex %#x long %ld size %zu char %c",
+            -5, 7u, 255, -123456789012L, size_t{42}, 'z');
+    log.log("tag", "double %.3f %e width %5d|%-5d| percent %%", 1.5, 2.0, 12, 34);
+
+    EXPECT_THAT(sink->the_lines(), IsEmpty());
+
+    log.drain();
+
+    EXPECT_THAT(sink->the_lines(), ElementsAre(
+        "tag: int -5 uint 7 hex 0xff long -123456789012 size 42 char z",
+        "tag: double 1.500 2.000000e+00 width    12|34   | percent %"));
+}
+
+TEST_F(ARingBufferLog, copies_string_arguments)
+{
+    repowerd::RingBufferLog log{
+        sink, records_per_thread, long_flush_interval,
+        repowerd::RingBufferLog::SignalHandling::none};
+
+    {
+        std::string temporary{"transient"};
+        log.log("tag", "string %s %.3s", temporary.c_str(), "abcdef");
+        temporary.assign("overwritten");
+    }
+
+    log.drain();
+
+    EXPECT_THAT(sink->the_lines(), ElementsAre("tag: string transient abc"));
+}
+
+TEST_F(ARingBufferLog, copies_tags)
+{
+    repowerd::RingBufferLog log{
+        sink, records_per_thread, long_flush_interval,
+        repowerd::RingBufferLog::SignalHandling::none};
+
+    {
+        auto const temporary = std::make_unique<std::string>("Transient[c1]");
+        log.log(temporary->c_str(), "message");
+        temporary->assign("Overwritten[c2]");
+    }
+
+    log.drain();
+
+    EXPECT_THAT(sink->the_lines(), ElementsAre("Transient[c1]: message"));
+}
+
+TEST_F(ARingBufferLog, supports_star_width_and_precision)
+{
+    repowerd::RingBufferLog log{
+        sink, records_per_thread, long_flush_interval,
+        repowerd::RingBufferLog::SignalHandling::none};
+
+    log.log("tag", "[%*d] [%.*f] [%*.*s]", 4, 7, 2, 3.14159, 5, 2, "xyz");
+    log.drain();
+
+    EXPECT_THAT(sink->the_lines(), ElementsAre("tag: [   7] [3.14] [   xy]"));
+}
+
+TEST_F(ARingBufferLog, marks_truncated_arguments)
+{
+    repowerd::RingBufferLog log{
+        sink, records_per_thread, long_flush_interval,
+        repowerd::RingBufferLog::SignalHandling::none};
+
+    std::string const long_string(1000, 'a');
+    log.log("tag", "%s %d", long_string.c_str(), 5);
+    log.drain();
+
+    ASSERT_THAT(sink->the_lines(), SizeIs(1));
+    EXPECT_THAT(sink->the_lines()[0], StartsWith("tag: aaaa"));
+    EXPECT_THAT(sink->the_lines()[0], EndsWith("<truncated>"));
+}
+
+TEST_F(ARingBufferLog, drops_records_when_full_and_reports_it)
+{
+    repowerd::RingBufferLog log{
+        sink, records_per_thread, long_flush_interval,
+        repowerd::RingBufferLog::SignalHandling::none};
+
+    for (size_t i = 0; i < records_per_thread + 3; ++i)
+        log.log("tag", "line %zu", i);
+
+    log.drain();
+
+    auto const lines = sink->the_lines();
+    EXPECT_THAT(lines, SizeIs(records_per_thread + 1));
+    EXPECT_THAT(lines, Contains("RingBufferLog: Dropped 3 log records, buffer full"));
+    EXPECT_THAT(lines, Contains("tag: line 0"));
+    EXPECT_THAT(lines, Not(Contains("tag: line 16")));
+}
+
+TEST_F(ARingBufferLog, merges_lines_from_threads_in_time_order)
+{
+    repowerd::RingBufferLog log{
+        sink, records_per_thread, long_flush_interval,
+        repowerd::RingBufferLog::SignalHandling::none};
+
+    log.log("tag", "line %d", 1);
+    std::thread{[&] { log.log("tag", "line %d", 2); }}.join();
+    log.log("tag", "line %d", 3);
+    std::thread{[&] { log.log("tag", "line %d", 4); }}.join();
+
+    log.drain();
+
+    EXPECT_THAT(sink->the_lines(), ElementsAre(
+        "tag: line 1", "tag: line 2", "tag: line 3", "tag: line 4"));
+}
+
+TEST_F(ARingBufferLog, frees_buffers_of_exited_threads_once_drained)
+{
+    repowerd::RingBufferLog log{
+        sink, records_per_thread, long_flush_interval,
+        repowerd::RingBufferLog::SignalHandling::none};
+
+    log.log("tag", "line %d", 1);
+    std::thread{[&] { log.log("tag", "line %d", 2); }}.join();
+    std::thread{[&] { log.log("tag", "line %d", 3); }}.join();
+
+    // The second thread may reuse the id, and so the buffer, of the first
+    EXPECT_THAT(log.num_thread_buffers(), Gt(1u));
+
+    log.drain();
+
+    EXPECT_THAT(log.num_thread_buffers(), Eq(1u));
+    EXPECT_THAT(sink->the_lines(), SizeIs(3));
+}
+
+TEST_F(ARingBufferLog, flushes_periodically_in_the_background)
+{
+    repowerd::RingBufferLog log{
+        sink, records_per_thread, 10ms,
+        repowerd::RingBufferLog::SignalHandling::none};
+
+    log.log("tag", "line %d", 1);
+
+    auto const flushed = rt::spin_wait_for_condition_or_timeout(
+        [&] { return sink->the_lines().size() == 1; }, 3s);
+
+    EXPECT_TRUE(flushed);
+}
+
+TEST_F(ARingBufferLog, flushes_lines_logged_after_an_idle_period)
+{
+    repowerd::RingBufferLog log{
+        sink, records_per_thread, 10ms,
+        repowerd::RingBufferLog::SignalHandling::none};
+
+    log.log("tag", "line %d", 1);
+    ASSERT_TRUE(rt::spin_wait_for_condition_or_timeout(
+        [&] { return sink->the_lines().size() == 1; }, 3s));
+
+    std::this_thread::sleep_for(50ms);
+
+    log.log("tag", "line %d", 2);
+    std::thread{[&] { log.log("tag", "line %d", 3); }}.join();
+
+    auto const flushed = rt::spin_wait_for_condition_or_timeout(
+        [&] { return sink->the_lines().size() == 3; }, 3s);
+
+    EXPECT_TRUE(flushed);
+}
+
+TEST_F(ARingBufferLog, flushes_on_sigusr1)
+{
+    repowerd::RingBufferLog log{
+        sink, records_per_thread, long_flush_interval,
+        repowerd::RingBufferLog::SignalHandling::install};
+
+    log.log("tag", "line %d", 1);
+    kill(getpid(), SIGUSR1);
+
+    auto const flushed = rt::spin_wait_for_condition_or_timeout(
+        [&] { return sink->the_lines().size() == 1; }, 3s);
+
+    EXPECT_TRUE(flushed);
+}
+
+TEST_F(ARingBufferLog, writes_out_lines_without_the_sink_for_crashes)
+{
+    repowerd::RingBufferLog log{
+        sink, records_per_thread, long_flush_interval,
+        repowerd::RingBufferLog::SignalHandling::none};
+
+    log.log("tag", "int %d hex %x str %s double %.2f", -5, 255u, "abc", 1.5);
+    std::thread{[&] { log.log("tag2", "percent %% %zu", size_t{7}); }}.join();
+
+    int fds[2];
+    ASSERT_THAT(pipe(fds), Eq(0));
+    log.write_out_for_crash(fds[1]);
+    close(fds[1]);
+
+    std::string output;
+    char buf[256];
+    ssize_t n;
+    while ((n = read(fds[0], buf, sizeof(buf))) > 0)
+        output.append(buf, n);
+    close(fds[0]);
+
+    EXPECT_THAT(output, Eq(
+        "RingBufferLog: Crashed, writing out unflushed log lines\n"
+        "info tag: int -5 hex ff str abc double 1.500\n"
+        "info tag2: percent % 7\n"));
+    EXPECT_THAT(sink->the_lines(), IsEmpty());
+}
+
+TEST_F(ARingBufferLog, writes_out_lines_to_stderr_on_crash)
+{
+    ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+    auto const log_and_crash =
+        [this]
+        {
+            repowerd::RingBufferLog log{
+                sink, records_per_thread, long_flush_interval,
+                repowerd::RingBufferLog::SignalHandling::install};
+
+            log.log("tag", "last words %d", 42);
+            abort();
+        };
+
+    EXPECT_DEATH(log_and_crash(), "info tag: last words 42");
+}
+
+TEST_F(ARingBufferLog, flushes_remaining_lines_on_destruction)
+{
+    {
+        repowerd::RingBufferLog log{
+            sink, records_per_thread, long_flush_interval,
+            repowerd::RingBufferLog::SignalHandling::none};
+
+        log.log("tag", "line %d", 1);
+    }
+
+    EXPECT_THAT(sink->the_lines(), ElementsAre("tag: line 1"));
+}
+
+TEST_F(ARingBufferLog, passes_levels_to_sink_and_filters_disabled_ones)
+{
+    repowerd::RingBufferLog log{
+        sink, records_per_thread, long_flush_interval,
+        repowerd::RingBufferLog::SignalHandling::none};
+
+    log.log(repowerd::LogLevel::warning, "tag", "warning %d", 1);
+    log.log(repowerd::LogLevel::debug, "tag", "debug %d", 2);
+    log.levels().set_tag_level("tag", repowerd::LogLevel::debug);
+    log.log(repowerd::LogLevel::debug, "tag", "debug %d", 3);
+
+    log.drain();
+
+    EXPECT_THAT(sink->the_lines(), ElementsAre("tag: warning 1", "tag: debug 3"));
+    EXPECT_THAT(sink->levels_seen,
+                ElementsAre(repowerd::LogLevel::warning, repowerd::LogLevel::debug));
+}
@@ -189,6 +189,16 @@ TEST_F(ASysfsBacklight, gets_last_set_brightness)
     EXPECT_THAT(backlight->get_brightness(), Eq(normalized_brightness));
 }
 
+TEST_F(ASysfsBacklight, gets_brightness_from_file_before_setting_it)
+{
+    set_up_sysfs_backlight();
+    sysfs_backlight->brightness_contents->push_back("102");
+
+    auto const backlight = create_sysfs_backlight();
+
+    EXPECT_THAT(backlight->get_brightness(), Eq(102.0/max_brightness));
+}
+
 TEST_F(ASysfsBacklight, gets_real_brightness_if_brightness_changed_externally)
 {
     set_up_sysfs_backlight();
@@ -200,6 +210,34 @@ TEST_F(ASysfsBacklight, gets_real_brightness_if_brightness_changed_externally)
     EXPECT_THAT(backlight->get_brightness(), Eq(102.0/max_brightness));
 }
 
+TEST_F(ASysfsBacklight, does_not_write_unchanged_absolute_brightness_value)
+{
+    set_up_sysfs_backlight();
+
+    auto const backlight = create_sysfs_backlight();
+    backlight->set_brightness(0.5);
+    auto const num_writes = sysfs_backlight->brightness_contents->size();
+
+    backlight->set_brightness(0.501);
+
+    EXPECT_THAT(sysfs_backlight->brightness_contents->size(), Eq(num_writes));
+    EXPECT_THAT(backlight->get_brightness(), Eq(0.501));
+}
+
+TEST_F(ASysfsBacklight, writes_brightness_value_again_if_brightness_changed_externally)
+{
+    set_up_sysfs_backlight();
+
+    auto const backlight = create_sysfs_backlight();
+    backlight->set_brightness(0.4);
+
+    sysfs_backlight->brightness_contents->push_back("10");
+    backlight->get_brightness();
+    backlight->set_brightness(0.4);
+
+    expect_brightness_value(round(max_brightness * 0.4));
+}
+
 TEST_F(ASysfsBacklight, logs_used_sysfs_backlight_dir)
 {
     set_up_sysfs_backlight();
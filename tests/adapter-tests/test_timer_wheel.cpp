@@ -0,0 +1,224 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/adapters/timer_wheel.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <map>
+#include <random>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct ATimerWheel : Test
+{
+    std::vector<repowerd::AlarmId> advance_to(std::chrono::milliseconds t)
+    {
+        std::vector<repowerd::AlarmId> expired;
+        wheel.advance(start + t, expired);
+        return expired;
+    }
+
+    std::chrono::steady_clock::time_point const start{std::chrono::steady_clock::now()};
+    repowerd::TimerWheel wheel{start};
+};
+
+}
+
+TEST_F(ATimerWheel, expires_alarms_at_their_deadline)
+{
+    wheel.add(1, start + 10ms);
+
+    EXPECT_THAT(advance_to(9ms), IsEmpty());
+    EXPECT_THAT(advance_to(10ms), ElementsAre(repowerd::AlarmId{1}));
+    EXPECT_THAT(wheel.size(), Eq(0u));
+}
+
+TEST_F(ATimerWheel, expires_alarms_in_deadline_order)
+{
+    wheel.add(1, start + 5s);
+    wheel.add(2, start + 70ms);
+    wheel.add(3, start + 3ms);
+    wheel.add(4, start + 10min);
+
+    EXPECT_THAT(advance_to(11min),
+                ElementsAre(repowerd::AlarmId{3}, repowerd::AlarmId{2},
+                            repowerd::AlarmId{1}, repowerd::AlarmId{4}));
+}
+
+TEST_F(ATimerWheel, expires_alarms_in_coarse_levels_at_their_deadline)
+{
+    wheel.add(1, start + 5000ms);
+    wheel.add(2, start + 300001ms);
+
+    EXPECT_THAT(advance_to(4999ms), IsEmpty());
+    EXPECT_THAT(advance_to(5000ms), ElementsAre(repowerd::AlarmId{1}));
+    EXPECT_THAT(advance_to(300000ms), IsEmpty());
+    EXPECT_THAT(advance_to(300001ms), ElementsAre(repowerd::AlarmId{2}));
+}
+
+TEST_F(ATimerWheel, expires_alarms_beyond_wheel_range_at_their_deadline)
+{
+    wheel.add(1, start + 10h);
+
+    EXPECT_THAT(advance_to(10h - 1ms), IsEmpty());
+    EXPECT_THAT(advance_to(10h), ElementsAre(repowerd::AlarmId{1}));
+}
+
+TEST_F(ATimerWheel, does_not_expire_removed_alarms)
+{
+    wheel.add(1, start + 10ms);
+    wheel.add(2, start + 20ms);
+    wheel.add(3, start + 30ms);
+
+    EXPECT_TRUE(wheel.remove(2));
+    EXPECT_FALSE(wheel.remove(2));
+
+    EXPECT_THAT(advance_to(1s), ElementsAre(repowerd::AlarmId{1}, repowerd::AlarmId{3}));
+}
+
+TEST_F(ATimerWheel, expires_alarms_with_past_deadline_on_next_tick)
+{
+    advance_to(100ms);
+    wheel.add(1, start + 50ms);
+
+    EXPECT_THAT(advance_to(101ms), ElementsAre(repowerd::AlarmId{1}));
+}
+
+TEST_F(ATimerWheel, reports_next_event)
+{
+    EXPECT_THAT(wheel.next_event(), Eq(std::chrono::steady_clock::time_point::max()));
+
+    wheel.add(1, start + 10ms);
+
+    EXPECT_THAT(wheel.next_event(), Eq(start + 10ms));
+}
+
+TEST_F(ATimerWheel, reports_next_event_no_later_than_earliest_deadline)
+{
+    wheel.add(1, start + 100s);
+    wheel.add(2, start + 7s);
+
+    auto const expired = advance_to(std::chrono::duration_cast<std::chrono::milliseconds>(
+        wheel.next_event() - start));
+
+    EXPECT_THAT(expired, IsEmpty());
+    EXPECT_THAT(wheel.next_event(), Le(start + 7s));
+}
+
+TEST_F(ATimerWheel, reuses_storage_of_expired_and_removed_alarms)
+{
+    for (int i = 0; i < 1000; ++i)
+    {
+        wheel.add(i, start + std::chrono::milliseconds{i + 1});
+        wheel.remove(i);
+    }
+
+    wheel.add(1000, start + 2s);
+
+    EXPECT_THAT(wheel.size(), Eq(1u));
+    EXPECT_THAT(advance_to(2s), ElementsAre(repowerd::AlarmId{1000}));
+}
+
+TEST_F(ATimerWheel, expires_extended_alarms_at_their_new_deadline)
+{
+    wheel.add(1, start + 10ms);
+    wheel.add(2, start + 20ms);
+
+    EXPECT_TRUE(wheel.extend(1, start + 5s));
+
+    EXPECT_THAT(advance_to(4999ms), ElementsAre(repowerd::AlarmId{2}));
+    EXPECT_THAT(advance_to(5000ms), ElementsAre(repowerd::AlarmId{1}));
+}
+
+TEST_F(ATimerWheel, expires_alarms_extended_to_an_earlier_deadline_at_that_deadline)
+{
+    wheel.add(1, start + 5s);
+
+    EXPECT_TRUE(wheel.extend(1, start + 10ms));
+
+    EXPECT_THAT(advance_to(9ms), IsEmpty());
+    EXPECT_THAT(advance_to(10ms), ElementsAre(repowerd::AlarmId{1}));
+}
+
+TEST_F(ATimerWheel, does_not_extend_alarms_that_are_not_pending)
+{
+    wheel.add(1, start + 10ms);
+    advance_to(10ms);
+
+    EXPECT_FALSE(wheel.extend(1, start + 1s));
+    EXPECT_FALSE(wheel.extend(2, start + 1s));
+    EXPECT_THAT(wheel.size(), Eq(0u));
+}
+
+TEST_F(ATimerWheel, expires_random_alarms_exactly_when_due)
+{
+    std::mt19937 rng{1234};
+    std::uniform_int_distribution<int> deadline_ms{1, 6 * 3600 * 1000};
+    std::uniform_int_distribution<int> step_ms{0, 120 * 1000};
+    std::uniform_int_distribution<int> alarm{0, 1999};
+    std::map<int, std::chrono::milliseconds> deadlines;
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        auto const deadline = std::chrono::milliseconds{deadline_ms(rng)};
+        wheel.add(i, start + deadline);
+        deadlines[i] = deadline;
+    }
+
+    for (int i = 0; i < 2000; i += 7)
+    {
+        wheel.remove(i);
+        deadlines.erase(i);
+    }
+
+    std::chrono::milliseconds now{0};
+    while (!deadlines.empty())
+    {
+        auto const extended = deadlines.find(alarm(rng));
+        if (extended != deadlines.end())
+        {
+            extended->second = now + std::chrono::milliseconds{deadline_ms(rng)};
+            EXPECT_TRUE(wheel.extend(extended->first, start + extended->second));
+        }
+
+        now += std::chrono::milliseconds{step_ms(rng)};
+
+        std::vector<repowerd::AlarmId> expected;
+        for (auto iter = deadlines.begin(); iter != deadlines.end();)
+        {
+            if (iter->second <= now)
+            {
+                expected.push_back(iter->first);
+                iter = deadlines.erase(iter);
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+
+        EXPECT_THAT(advance_to(now), UnorderedElementsAreArray(expected));
+    }
+
+    EXPECT_THAT(wheel.size(), Eq(0u));
+}
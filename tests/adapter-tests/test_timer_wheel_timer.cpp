@@ -0,0 +1,173 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/adapters/timer_wheel_timer.h"
+
+#include "wait_condition.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <thread>
+
+namespace rt = repowerd::test;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct ATimerWheelTimer : testing::Test
+{
+    repowerd::TimerWheelTimer timer;
+    repowerd::HandlerRegistration const reg{
+        timer.register_alarm_handler(
+            [this](repowerd::AlarmId id) { alarm_handler(id); })};
+
+    MOCK_METHOD1(alarm_handler, void(repowerd::AlarmId id));
+};
+
+}
+
+TEST_F(ATimerWheelTimer, gives_different_ids_to_active_alarms)
+{
+    auto const id1 = timer.schedule_alarm_in(10s);
+    auto const id2 = timer.schedule_alarm_in(10s);
+    auto const id3 = timer.schedule_alarm_in(10s);
+
+    EXPECT_THAT(id1, Ne(id2));
+    EXPECT_THAT(id1, Ne(id3));
+    EXPECT_THAT(id2, Ne(id3));
+}
+
+TEST_F(ATimerWheelTimer, notifies_when_alarm_triggers)
+{
+    auto const id = timer.schedule_alarm_in(100ms);
+
+    rt::WaitCondition alarm_triggered;
+
+    EXPECT_CALL(*this, alarm_handler(id))
+        .WillOnce(WakeUp(&alarm_triggered));
+
+    alarm_triggered.wait_for(120ms);
+    EXPECT_TRUE(alarm_triggered.woken());
+}
+
+TEST_F(ATimerWheelTimer, notifies_in_order_when_multiple_alarms_trigger)
+{
+    auto const id1 = timer.schedule_alarm_in(100ms);
+    auto const id2 = timer.schedule_alarm_in(110ms);
+    auto const id3 = timer.schedule_alarm_in(120ms);
+    auto const id4 = timer.schedule_alarm_in(130ms);
+
+    rt::WaitCondition alarm_triggered;
+
+    testing::InSequence s;
+    EXPECT_CALL(*this, alarm_handler(id1));
+    EXPECT_CALL(*this, alarm_handler(id2));
+    EXPECT_CALL(*this, alarm_handler(id3));
+    EXPECT_CALL(*this, alarm_handler(id4))
+        .WillOnce(WakeUp(&alarm_triggered));
+
+    alarm_triggered.wait_for(150ms);
+    EXPECT_TRUE(alarm_triggered.woken());
+}
+
+TEST_F(ATimerWheelTimer, does_not_notify_for_alarms_not_triggered)
+{
+    auto const id1 = timer.schedule_alarm_in(50ms);
+    auto const id2 = timer.schedule_alarm_in(100ms);
+    auto const id3 = timer.schedule_alarm_in(10s);
+
+    testing::InSequence s;
+    EXPECT_CALL(*this, alarm_handler(id1));
+    EXPECT_CALL(*this, alarm_handler(id2));
+    EXPECT_CALL(*this, alarm_handler(id3)).Times(0);
+
+    std::this_thread::sleep_for(150ms);
+}
+
+TEST_F(ATimerWheelTimer, reports_current_now)
+{
+    auto const wait = 100ms;
+
+    auto const then = timer.now();
+    std::this_thread::sleep_for(wait);
+    auto const now = timer.now();
+
+    EXPECT_THAT(now - then, Ge(wait));
+    EXPECT_THAT(now - then, Le(wait + 20ms));
+}
+
+TEST_F(ATimerWheelTimer, does_not_notify_for_cancelled_alarms)
+{
+    auto const id1 = timer.schedule_alarm_in(50ms);
+    auto const id2 = timer.schedule_alarm_in(100ms);
+    auto const id3 = timer.schedule_alarm_in(150ms);
+    auto const id4 = timer.schedule_alarm_in(200ms);
+
+    testing::InSequence s;
+    EXPECT_CALL(*this, alarm_handler(id1));
+    EXPECT_CALL(*this, alarm_handler(id2)).Times(0);
+    EXPECT_CALL(*this, alarm_handler(id3));
+    EXPECT_CALL(*this, alarm_handler(id4)).Times(0);
+
+    timer.cancel_alarm(id4);
+    timer.cancel_alarm(id2);
+
+    std::this_thread::sleep_for(250ms);
+}
+
+TEST_F(ATimerWheelTimer, notifies_extended_alarms_at_their_new_deadline)
+{
+    auto const id1 = timer.schedule_alarm_in(50ms);
+    auto const id2 = timer.schedule_alarm_in(100ms);
+
+    EXPECT_TRUE(timer.extend_alarm_in(id1, 150ms));
+
+    testing::InSequence s;
+    EXPECT_CALL(*this, alarm_handler(id2));
+    EXPECT_CALL(*this, alarm_handler(id1));
+
+    std::this_thread::sleep_for(200ms);
+
+    EXPECT_FALSE(timer.extend_alarm_in(id1, 50ms));
+}
+
+TEST_F(ATimerWheelTimer, allows_cancelling_and_scheduling_alarms_from_alarm_handler)
+{
+    auto const id1 = timer.schedule_alarm_in(50ms);
+    auto const id2 = timer.schedule_alarm_in(100ms);
+
+    rt::WaitCondition alarm_triggered;
+
+    testing::InSequence s;
+    EXPECT_CALL(*this, alarm_handler(id1))
+        .WillOnce(InvokeWithoutArgs(
+            [&]
+            {
+                timer.cancel_alarm(id2);
+                timer.schedule_alarm_in(10ms);
+            }));
+    EXPECT_CALL(*this, alarm_handler(Ne(id2)))
+        .WillOnce(WakeUp(&alarm_triggered));
+
+    alarm_triggered.wait_for(200ms);
+    EXPECT_TRUE(alarm_triggered.woken());
+    std::this_thread::sleep_for(100ms);
+}
@@ -17,6 +17,15 @@
  */
 
 #include "src/adapters/timerfd_wakeup_service.h"
+#include "src/core/event_latency.h"
+
+#include "fake_filesystem.h"
+#include "fake_log.h"
+#include "fake_shared.h"
+#include "spin_wait.h"
+
+#include <sys/timerfd.h>
+#include <unistd.h>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -28,6 +37,8 @@
 using namespace testing;
 using namespace std::chrono_literals;
 
+namespace rt = repowerd::test;
+
 namespace
 {
 
@@ -93,7 +104,14 @@ struct ATimerfdWakeupService : Test
         }
     }
 
-    repowerd::TimerfdWakeupService wakeup_service;
+    rt::FakeLog fake_log;
+    rt::FakeFilesystem fake_filesystem;
+    repowerd::EventLatencyStats event_latency_stats;
+    repowerd::TimerfdWakeupService wakeup_service{
+        rt::fake_shared(fake_log),
+        rt::fake_shared(fake_filesystem),
+        rt::fake_shared(event_latency_stats),
+        0ms};
     std::mutex wakeup_mutex;
     std::condition_variable wakeup_cv;
     std::vector<std::string> wakeup_cookies;
@@ -182,6 +200,17 @@ TEST_F(ATimerfdWakeupService, schedules_and_cancels_multiple_wakeups_with_same_t
     wait_for_wakeups({cookie1, cookie3}, {tp1, tp3});
 }
 
+TEST_F(ATimerfdWakeupService, coalesces_wakeups_within_slack)
+{
+    auto const tp1 = system_now() + 50ms;
+    auto const tp2 = system_now() + 100ms;
+
+    auto const cookie1 = wakeup_service.schedule_wakeup_at(tp1, 100ms);
+    auto const cookie2 = wakeup_service.schedule_wakeup_at(tp2, 0ms);
+
+    wait_for_wakeups({cookie1, cookie2}, {tp2, tp2});
+}
+
 TEST_F(ATimerfdWakeupService, does_not_leak_memory_when_triggering)
 {
     auto const tp1 = system_now() + 50ms;
@@ -201,3 +230,32 @@ TEST_F(ATimerfdWakeupService, does_not_leak_memory_when_cancelling)
 
     EXPECT_THAT(wakeup_service.num_stored_elements(), Eq(0));
 }
+
+TEST_F(ATimerfdWakeupService, uses_alarm_clock_if_permitted)
+{
+    auto const alarm_fd = timerfd_create(CLOCK_REALTIME_ALARM, TFD_CLOEXEC);
+    auto const alarm_permitted = alarm_fd != -1;
+    if (alarm_permitted)
+        close(alarm_fd);
+
+    EXPECT_THAT(wakeup_service.wakes_system(), Eq(alarm_permitted));
+    EXPECT_TRUE(fake_log.contains_line(
+        {alarm_permitted ? "CLOCK_REALTIME_ALARM" : "CLOCK_REALTIME"}));
+}
+
+TEST_F(ATimerfdWakeupService, records_wakeup_latency)
+{
+    auto const tp1 = system_now() + 50ms;
+
+    auto const cookie1 = wakeup_service.schedule_wakeup_at(tp1);
+    wait_for_wakeups({cookie1}, {tp1});
+
+    auto const recorded = rt::spin_wait_for_condition_or_timeout(
+        [this] { return event_latency_stats.summary(repowerd::EventType::wakeup).count == 1; },
+        3s);
+
+    EXPECT_TRUE(recorded);
+    EXPECT_THAT(event_latency_stats.summary(repowerd::EventType::wakeup).queue_max,
+                Le(std::chrono::microseconds{10ms}));
+    EXPECT_TRUE(fake_log.contains_line({"1 wakeup(s) due", "latency"}));
+}
@@ -18,6 +18,7 @@
 
 #include "src/adapters/ubuntu_proximity_sensor.h"
 #include "src/adapters/device_quirks.h"
+#include "src/adapters/real_chrono.h"
 
 #include "fake_device_quirks.h"
 #include "fake_log.h"
@@ -48,7 +49,9 @@ struct AUbuntuProximitySensor : testing::Test
         command_file.write(script);
 
         sensor = std::make_unique<repowerd::UbuntuProximitySensor>(
-            rt::fake_shared(fake_log), fake_device_quirks);
+            rt::fake_shared(fake_log), std::make_shared<repowerd::RealChrono>(),
+            fake_device_quirks,
+            std::chrono::milliseconds{0}, std::chrono::milliseconds{0});
         registration = sensor->register_proximity_handler(
             [this](repowerd::ProximityState state) { mock_handlers.proximity_handler(state); });
     }
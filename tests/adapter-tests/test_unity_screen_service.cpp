@@ -24,6 +24,7 @@
 #include "unity_screen_dbus_client.h"
 #include "src/adapters/dbus_connection_handle.h"
 #include "src/adapters/dbus_message_handle.h"
+#include "src/adapters/dbus_sender_credentials.h"
 #include "src/adapters/temporary_suspend_inhibition.h"
 #include "src/adapters/unity_screen_power_state_change_reason.h"
 #include "src/adapters/unity_screen_service.h"
@@ -121,12 +122,14 @@ struct AUnityScreenService : testing::Test
     rt::FakeLog fake_log;
     rt::FakeWakeupService fake_wakeup_service;
     NullTemporarySuspendInhibition null_temporary_suspend_inhibition;
+    repowerd::DBusSenderCredentials sender_credentials{rt::fake_shared(fake_log)};
     repowerd::UnityScreenService service{
         rt::fake_shared(fake_wakeup_service),
         rt::fake_shared(fake_brightness_notification),
         rt::fake_shared(fake_log),
         rt::fake_shared(null_temporary_suspend_inhibition),
         fake_device_config,
+        rt::fake_shared(sender_credentials),
         bus.address()};
     rt::UnityScreenDBusClient client{bus.address()};
     std::vector<repowerd::HandlerRegistration> registrations;
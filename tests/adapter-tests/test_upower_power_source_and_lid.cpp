@@ -18,6 +18,7 @@
 
 #include "dbus_bus.h"
 #include "dbus_client.h"
+#include "fake_chrono.h"
 #include "fake_device_config.h"
 #include "fake_log.h"
 #include "fake_shared.h"
@@ -26,12 +27,14 @@
 #include "wait_condition.h"
 
 #include "src/adapters/upower_power_source_and_lid.h"
+#include "src/adapters/battery_discharge_estimator.h"
 #include "src/adapters/temporary_suspend_inhibition.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
 #include <chrono>
+#include <cstdio>
 
 namespace rt = repowerd::test;
 using namespace testing;
@@ -80,6 +83,20 @@ struct AUPowerPowerSourceAndLidBase : testing::Test
             throw std::runtime_error("Timeout while waiting for tracked batteries");
     }
 
+    void change_display_device_and_wait(rt::FakeUPower::DeviceInfo const& info)
+    {
+        char percentage_str[32];
+        snprintf(percentage_str, sizeof(percentage_str), "percentage=%.2f", info.percentage);
+
+        fake_upower.change_device(display_device_path, info);
+
+        auto const result = rt::spin_wait_for_condition_or_timeout(
+            [&] { return fake_log.contains_line({"change_device", display_device_path, percentage_str}); },
+            default_timeout);
+        if (!result)
+            throw std::runtime_error("Timeout while waiting for display device change");
+    }
+
     std::string device_path(int i)
     {
         return "/org/freedesktop/UPower/devices/" + std::to_string(i);
@@ -97,9 +114,13 @@ struct AUPowerPowerSourceAndLidBase : testing::Test
     rt::FakeDeviceConfig fake_device_config;
     rt::FakeLog fake_log;
     NiceMock<MockTemporarySuspendInhibition> mock_temporary_suspend_inhibition;
+    rt::FakeChrono fake_chrono;
+    repowerd::BatteryEstimates battery_estimates;
     repowerd::UPowerPowerSourceAndLid upower_power_source_and_lid{
         rt::fake_shared(fake_log),
         rt::fake_shared(mock_temporary_suspend_inhibition),
+        rt::fake_shared(fake_chrono),
+        rt::fake_shared(battery_estimates),
         fake_device_config,
         bus.address()};
     rt::FakeUPower fake_upower{bus.address()};
@@ -455,6 +476,108 @@ TEST_F(AUPowerPowerSourceAndLid,
     EXPECT_TRUE(request_processed.woken());
 }
 
+TEST_F(AUPowerPowerSourceAndLid,
+       notifies_of_critical_state_for_short_predicted_time_to_empty)
+{
+    rt::WaitCondition request_processed;
+
+    EXPECT_CALL(mock_handlers, power_source_critical())
+        .WillOnce(WakeUp(&request_processed));
+
+    // Discharging at 10% per minute
+    auto battery = discharging_battery;
+    for (auto const percentage : {40.0, 30.0, 20.0, 10.0})
+    {
+        battery.percentage = percentage;
+        change_display_device_and_wait(battery);
+        fake_chrono.sleep_for(1min);
+    }
+
+    request_processed.wait_for(default_timeout);
+    EXPECT_TRUE(request_processed.woken());
+    EXPECT_TRUE(fake_log.contains_line({"predicted to be empty in 60 s"}));
+}
+
+TEST_F(AUPowerPowerSourceAndLid,
+       does_not_notify_of_critical_state_for_single_short_predicted_time_to_empty)
+{
+    EXPECT_CALL(mock_handlers, power_source_critical()).Times(0);
+
+    // Discharging at 10% per minute, predicted to be empty in 120 s only
+    // at the last sample
+    auto battery = discharging_battery;
+    for (auto const percentage : {40.0, 30.0, 20.0})
+    {
+        battery.percentage = percentage;
+        change_display_device_and_wait(battery);
+        fake_chrono.sleep_for(1min);
+    }
+}
+
+TEST_F(AUPowerPowerSourceAndLid,
+       does_not_notify_of_critical_state_for_energy_rate_spike)
+{
+    EXPECT_CALL(mock_handlers, power_source_critical()).Times(0);
+
+    // Discharging at 0.5% per minute under a steady load
+    auto battery = discharging_battery;
+    battery.energy_rate = 5.0;
+    for (auto const percentage : {10.0, 9.5, 9.0, 8.5, 8.0, 7.5, 7.0, 6.5})
+    {
+        battery.percentage = percentage;
+        change_display_device_and_wait(battery);
+        fake_chrono.sleep_for(1min);
+    }
+
+    // Scaled by this rate alone, the battery would be empty in 83 s
+    battery.percentage = 6.0;
+    battery.energy_rate = 1000.0;
+    change_display_device_and_wait(battery);
+    fake_chrono.sleep_for(1min);
+    battery.percentage = 5.5;
+    battery.energy_rate = 5.0;
+    change_display_device_and_wait(battery);
+}
+
+TEST_F(AUPowerPowerSourceAndLid,
+       does_not_notify_of_critical_state_for_long_predicted_time_to_empty)
+{
+    EXPECT_CALL(mock_handlers, power_source_critical()).Times(0);
+
+    // Discharging at 1% per minute
+    auto battery = discharging_battery;
+    for (auto const percentage : {40.0, 39.0, 38.0})
+    {
+        battery.percentage = percentage;
+        change_display_device_and_wait(battery);
+        fake_chrono.sleep_for(1min);
+    }
+}
+
+TEST_F(AUPowerPowerSourceAndLid, publishes_battery_estimates)
+{
+    auto battery = discharging_battery;
+    for (auto const percentage : {40.0, 39.0, 38.0})
+    {
+        battery.percentage = percentage;
+        change_display_device_and_wait(battery);
+        fake_chrono.sleep_for(1min);
+    }
+
+    bool found = false;
+    for (auto const& estimate : battery_estimates.all())
+    {
+        if (estimate.first != display_device_path)
+            continue;
+
+        found = true;
+        EXPECT_THAT(estimate.second.discharge_rate, DoubleNear(60.0, 1e-6));
+        EXPECT_THAT(estimate.second.time_to_empty, Eq(38min));
+    }
+
+    EXPECT_TRUE(found);
+}
+
 TEST_F(AUPowerPowerSourceAndLidWithAlmostEmptyBattery,
        does_not_notify_of_critical_state_for_low_energy)
 {
@@ -530,6 +653,32 @@ TEST_F(AUPowerPowerSourceAndLid, second_start_processing_is_ignored)
                 Eq(prev_num_calls));
 }
 
+TEST_F(AUPowerPowerSourceAndLid, answers_battery_power_queries_without_round_trips)
+{
+    auto const prev_num_calls = fake_upower.num_on_battery_get_calls();
+
+    EXPECT_FALSE(upower_power_source_and_lid.is_using_battery_power());
+    EXPECT_FALSE(upower_power_source_and_lid.is_using_battery_power());
+
+    EXPECT_THAT(fake_upower.num_on_battery_get_calls(), Eq(prev_num_calls));
+    EXPECT_THAT(upower_power_source_and_lid.avoided_on_battery_queries(), Eq(2u));
+}
+
+TEST_F(AUPowerPowerSourceAndLid, tracks_battery_power_from_signals)
+{
+    rt::WaitCondition request_processed;
+
+    EXPECT_CALL(mock_handlers, power_source_change())
+        .WillOnce(WakeUp(&request_processed));
+
+    fake_upower.change_device(display_device_path, discharging_battery);
+
+    request_processed.wait_for(default_timeout);
+    EXPECT_TRUE(request_processed.woken());
+
+    EXPECT_TRUE(upower_power_source_and_lid.is_using_battery_power());
+}
+
 TEST_F(AUPowerPowerSourceAndLid, inhibits_suspend_temporarily_on_change)
 {
     rt::WaitCondition request_processed;
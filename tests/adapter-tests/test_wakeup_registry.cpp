@@ -0,0 +1,140 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/adapters/wakeup_registry.h"
+
+#include <gmock/gmock.h>
+
+#include <set>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct AWakeupRegistry : Test
+{
+    repowerd::WakeupRegistry registry;
+    std::chrono::system_clock::time_point const t0 =
+        std::chrono::system_clock::time_point{} + 1000s;
+};
+
+}
+
+TEST_F(AWakeupRegistry, returns_unique_nonzero_handles)
+{
+    std::set<repowerd::WakeupRegistry::Id> ids;
+
+    for (int i = 0; i < 1000; ++i)
+        ids.insert(registry.add(t0, 0ms));
+
+    EXPECT_THAT(ids.size(), Eq(1000u));
+    EXPECT_THAT(ids.count(0), Eq(0u));
+    EXPECT_THAT(registry.size(), Eq(1000u));
+}
+
+TEST_F(AWakeupRegistry, is_empty_initially)
+{
+    EXPECT_TRUE(registry.empty());
+    EXPECT_THAT(registry.next_batch_time(),
+                Eq(std::chrono::system_clock::time_point::max()));
+}
+
+TEST_F(AWakeupRegistry, removes_wakeup)
+{
+    auto const id1 = registry.add(t0, 0ms);
+    auto const id2 = registry.add(t0 + 1s, 0ms);
+
+    EXPECT_TRUE(registry.remove(id1));
+    EXPECT_FALSE(registry.remove(id1));
+
+    EXPECT_THAT(registry.next_batch_time(), Eq(t0 + 1s));
+    EXPECT_THAT(registry.take_due(t0 + 1s), ElementsAre(id2));
+    EXPECT_THAT(registry.num_stored_elements(), Eq(0u));
+}
+
+TEST_F(AWakeupRegistry, batches_wakeups_with_overlapping_slack)
+{
+    registry.add(t0, 1000ms);
+    registry.add(t0 + 500ms, 1000ms);
+    registry.add(t0 + 900ms, 0ms);
+
+    EXPECT_THAT(registry.next_batch_time(), Eq(t0 + 900ms));
+    EXPECT_THAT(registry.take_due(t0 + 900ms).size(), Eq(3u));
+    EXPECT_TRUE(registry.empty());
+}
+
+TEST_F(AWakeupRegistry, does_not_defer_wakeup_beyond_its_slack)
+{
+    registry.add(t0, 100ms);
+    registry.add(t0 + 50ms, 1000ms);
+    auto const id3 = registry.add(t0 + 200ms, 1000ms);
+
+    EXPECT_THAT(registry.next_batch_time(), Eq(t0 + 50ms));
+    EXPECT_THAT(registry.take_due(t0 + 50ms).size(), Eq(2u));
+
+    EXPECT_THAT(registry.next_batch_time(), Eq(t0 + 200ms));
+    EXPECT_THAT(registry.take_due(t0 + 200ms), ElementsAre(id3));
+}
+
+TEST_F(AWakeupRegistry, does_not_batch_wakeups_without_slack)
+{
+    registry.add(t0, 0ms);
+    registry.add(t0 + 1ms, 0ms);
+
+    EXPECT_THAT(registry.next_batch_time(), Eq(t0));
+}
+
+TEST_F(AWakeupRegistry, takes_due_wakeups_in_time_and_insertion_order)
+{
+    auto const id1 = registry.add(t0 + 2s, 0ms);
+    auto const id2 = registry.add(t0, 0ms);
+    auto const id3 = registry.add(t0 + 2s, 0ms);
+    auto const id4 = registry.add(t0 + 3s, 0ms);
+
+    EXPECT_THAT(registry.take_due(t0 + 2s), ElementsAre(id2, id1, id3));
+    EXPECT_THAT(registry.take_due(t0 + 3s), ElementsAre(id4));
+}
+
+TEST_F(AWakeupRegistry, clamps_deadline_of_huge_slack)
+{
+    auto const max = std::chrono::system_clock::time_point::max();
+    auto const id = registry.add(max - 1s, std::chrono::milliseconds::max());
+
+    EXPECT_THAT(registry.next_batch_time(), Eq(max - 1s));
+    EXPECT_THAT(registry.take_due(max), ElementsAre(id));
+}
+
+TEST_F(AWakeupRegistry, converts_handles_to_and_from_cookies)
+{
+    auto const id = registry.add(t0, 0ms);
+
+    auto const cookie = repowerd::WakeupRegistry::to_cookie(id);
+
+    EXPECT_THAT(repowerd::WakeupRegistry::from_cookie(cookie), Eq(id));
+}
+
+TEST_F(AWakeupRegistry, maps_invalid_cookies_to_zero)
+{
+    using repowerd::WakeupRegistry;
+
+    EXPECT_THAT(WakeupRegistry::from_cookie(""), Eq(0u));
+    EXPECT_THAT(WakeupRegistry::from_cookie("abc"), Eq(0u));
+    EXPECT_THAT(WakeupRegistry::from_cookie("-5"), Eq(0u));
+    EXPECT_THAT(WakeupRegistry::from_cookie("12x"), Eq(0u));
+    EXPECT_THAT(WakeupRegistry::from_cookie("99999999999999999999999"), Eq(0u));
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "src/adapters/wakeup_resume_cause.h"
+
+#include "fake_filesystem.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace rt = repowerd::test;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct AWakeupResumeCause : Test
+{
+    AWakeupResumeCause()
+    {
+        fake_filesystem.add_file_with_contents(
+            "/proc/interrupts",
+            "           CPU0       CPU1\n"
+            "  8:          0          1   IO-APIC    8-edge      rtc0\n"
+            "  9:          0         12   IO-APIC    9-fasteoi   acpi\n"
+            " 18:          5         98   IO-APIC   18-fasteoi   i801_smbus\n"
+            "200:          0          3   msm_gpio  42-edge      qpnp_rtc_alarm\n");
+    }
+
+    void set_wakeup_irq(int irq)
+    {
+        fake_filesystem.add_file_with_contents(
+            "/sys/power/pm_wakeup_irq", std::to_string(irq) + "\n");
+    }
+
+    rt::FakeFilesystem fake_filesystem;
+    bool const alarm_wakes_system{true};
+    std::chrono::nanoseconds const late_latency{repowerd::max_alarm_resume_latency + 1s};
+};
+
+}
+
+TEST_F(AWakeupResumeCause, attributes_rtc_wakeup_irq_to_alarm_even_if_late)
+{
+    set_wakeup_irq(8);
+
+    auto const cause = repowerd::resume_cause(fake_filesystem, alarm_wakes_system, late_latency);
+
+    EXPECT_TRUE(cause.wakeup_alarm);
+    EXPECT_THAT(cause.description, StrEq("kernel wakeup IRQ 8 rtc0"));
+}
+
+TEST_F(AWakeupResumeCause, attributes_alarm_named_wakeup_irq_to_alarm)
+{
+    set_wakeup_irq(200);
+
+    auto const cause = repowerd::resume_cause(fake_filesystem, alarm_wakes_system, 10ms);
+
+    EXPECT_TRUE(cause.wakeup_alarm);
+    EXPECT_THAT(cause.description, StrEq("kernel wakeup IRQ 200 qpnp_rtc_alarm"));
+}
+
+TEST_F(AWakeupResumeCause, attributes_other_wakeup_irq_to_other_source_even_if_prompt)
+{
+    set_wakeup_irq(18);
+
+    auto const cause = repowerd::resume_cause(fake_filesystem, alarm_wakes_system, 10ms);
+
+    EXPECT_FALSE(cause.wakeup_alarm);
+    EXPECT_THAT(cause.description, StrEq("kernel wakeup IRQ 18 i801_smbus"));
+}
+
+TEST_F(AWakeupResumeCause, does_not_attribute_rtc_wakeup_irq_to_alarm_that_cannot_wake_system)
+{
+    set_wakeup_irq(8);
+
+    auto const cause = repowerd::resume_cause(fake_filesystem, false, 10ms);
+
+    EXPECT_FALSE(cause.wakeup_alarm);
+}
+
+TEST_F(AWakeupResumeCause, guesses_from_expiry_latency_for_shared_acpi_wakeup_irq)
+{
+    set_wakeup_irq(9);
+
+    auto const prompt = repowerd::resume_cause(fake_filesystem, alarm_wakes_system, 10ms);
+    auto const late = repowerd::resume_cause(fake_filesystem, alarm_wakes_system, late_latency);
+
+    EXPECT_TRUE(prompt.wakeup_alarm);
+    EXPECT_THAT(prompt.description, StrEq("guessed from expiry 10ms earlier"));
+    EXPECT_FALSE(late.wakeup_alarm);
+}
+
+TEST_F(AWakeupResumeCause, guesses_from_expiry_latency_without_wakeup_irq)
+{
+    auto const prompt = repowerd::resume_cause(fake_filesystem, alarm_wakes_system, 10ms);
+    auto const late = repowerd::resume_cause(fake_filesystem, alarm_wakes_system, late_latency);
+
+    EXPECT_TRUE(prompt.wakeup_alarm);
+    EXPECT_THAT(prompt.description, HasSubstr("guessed"));
+    EXPECT_FALSE(late.wakeup_alarm);
+    EXPECT_THAT(late.description, HasSubstr("guessed"));
+}
+
+TEST_F(AWakeupResumeCause, does_not_guess_alarm_that_cannot_wake_system)
+{
+    auto const cause = repowerd::resume_cause(fake_filesystem, false, 10ms);
+
+    EXPECT_FALSE(cause.wakeup_alarm);
+}
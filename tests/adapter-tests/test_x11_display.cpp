@@ -167,13 +167,17 @@ struct AX11Display : testing::Test
         }
     }
 
+    // Without an X server the display falls back to running commands
+    static constexpr char const* no_x11_display = ":65535";
+
     rt::DBusBus bus;
     rt::FakeLog fake_log;
     rt::FakeExec fake_exec;
     repowerd::X11Display x11_display{
         rt::fake_shared(fake_log),
         rt::fake_shared(fake_exec),
-        bus.address()};
+        bus.address(),
+        no_x11_display};
 
     std::chrono::seconds const default_timeout{3};
 };
@@ -0,0 +1,195 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "xvfb_server.h"
+
+#include "src/adapters/x11_display_connection.h"
+
+#include "fake_log.h"
+#include "fake_shared.h"
+#include "temporary_environment_value.h"
+
+#include <gtest/gtest.h>
+
+// Included after gtest, which clashes with macros like None and Bool
+#include <X11/Xlib.h>
+#include <X11/extensions/Xrandr.h>
+#include <X11/extensions/dpms.h>
+
+namespace rt = repowerd::test;
+
+namespace
+{
+
+// The single RandR output of Xvfb
+char const* const xvfb_output_name = "screen";
+
+struct AnX11DisplayConnection : testing::Test
+{
+    template <typename F>
+    void with_client_display(F const& f)
+    {
+        rt::TemporaryEnvironmentValue xauthority{
+            "XAUTHORITY", xvfb.xauthority_path().c_str()};
+
+        auto const display = XOpenDisplay(xvfb.display_name().c_str());
+        if (!display)
+            throw std::runtime_error("Failed to connect to " + xvfb.display_name());
+
+        f(display);
+
+        XCloseDisplay(display);
+    }
+
+    bool is_output_enabled()
+    {
+        bool enabled{false};
+
+        with_client_display(
+            [&] (Display* display)
+            {
+                auto const resources = XRRGetScreenResourcesCurrent(
+                    display, DefaultRootWindow(display));
+
+                for (int i = 0; i < resources->noutput; ++i)
+                {
+                    auto const info = XRRGetOutputInfo(
+                        display, resources, resources->outputs[i]);
+                    if (std::string(info->name, info->nameLen) == xvfb_output_name)
+                        enabled = info->crtc != None;
+                    XRRFreeOutputInfo(info);
+                }
+
+                XRRFreeScreenResources(resources);
+            });
+
+        return enabled;
+    }
+
+    bool is_dpms_capable()
+    {
+        bool capable{false};
+
+        with_client_display(
+            [&] (Display* display)
+            {
+                int event_base{0};
+                int error_base{0};
+                capable = DPMSQueryExtension(display, &event_base, &error_base) &&
+                          DPMSCapable(display);
+            });
+
+        return capable;
+    }
+
+    void expect_dpms_power_level(CARD16 expected_level)
+    {
+        with_client_display(
+            [&] (Display* display)
+            {
+                if (!DPMSCapable(display))
+                    return;
+
+                CARD16 power_level{0};
+                BOOL state{False};
+                DPMSInfo(display, &power_level, &state);
+
+                EXPECT_TRUE(state);
+                EXPECT_EQ(expected_level, power_level);
+            });
+    }
+
+    rt::XvfbServer xvfb;
+    rt::FakeLog fake_log;
+    repowerd::X11DisplayConnection connection{
+        rt::fake_shared(fake_log),
+        xvfb.display_name(),
+        xvfb_output_name};
+};
+
+}
+
+TEST_F(AnX11DisplayConnection, needs_xauthority_to_connect)
+{
+    rt::TemporaryEnvironmentValue no_xauthority{"XAUTHORITY", "/dev/null"};
+
+    EXPECT_FALSE(connection.turn_on(true));
+
+    connection.set_xauthority(xvfb.xauthority_path());
+
+    EXPECT_TRUE(connection.turn_on(true));
+}
+
+TEST_F(AnX11DisplayConnection, reuses_connection_for_power_changes)
+{
+    connection.set_xauthority(xvfb.xauthority_path());
+
+    EXPECT_EQ(is_dpms_capable(), connection.turn_off(false));
+    EXPECT_TRUE(connection.turn_on(true));
+    EXPECT_TRUE(connection.turn_off(true));
+    EXPECT_TRUE(connection.turn_on(true));
+
+    EXPECT_EQ(1, connection.num_connections());
+}
+
+TEST_F(AnX11DisplayConnection, reconnects_when_xauthority_changes)
+{
+    connection.set_xauthority(xvfb.xauthority_path());
+    EXPECT_TRUE(connection.turn_on(true));
+
+    connection.set_xauthority("");
+    connection.set_xauthority(xvfb.xauthority_path());
+    EXPECT_TRUE(connection.turn_on(true));
+
+    EXPECT_EQ(2, connection.num_connections());
+}
+
+TEST_F(AnX11DisplayConnection, disables_output_only_when_requested)
+{
+    connection.set_xauthority(xvfb.xauthority_path());
+
+    connection.turn_off(false);
+    EXPECT_TRUE(is_output_enabled());
+    expect_dpms_power_level(DPMSModeOff);
+
+    connection.turn_off(true);
+    EXPECT_FALSE(is_output_enabled());
+
+    connection.turn_on(true);
+    EXPECT_TRUE(is_output_enabled());
+    expect_dpms_power_level(DPMSModeOn);
+}
+
+TEST_F(AnX11DisplayConnection, reports_failure_to_turn_off_without_dpms_if_keeping_output)
+{
+    connection.set_xauthority(xvfb.xauthority_path());
+
+    EXPECT_EQ(is_dpms_capable(), connection.turn_off(false));
+    EXPECT_TRUE(connection.turn_off(true));
+}
+
+TEST_F(AnX11DisplayConnection, reports_lost_connection)
+{
+    connection.set_xauthority(xvfb.xauthority_path());
+    EXPECT_TRUE(connection.turn_on(true));
+
+    xvfb.stop();
+
+    EXPECT_FALSE(connection.turn_off(false));
+    EXPECT_FALSE(connection.turn_on(true));
+    EXPECT_EQ(1, connection.num_connections());
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "xvfb_server.h"
+
+#include <X11/Xauth.h>
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace rt = repowerd::test;
+
+namespace
+{
+
+void write_xauthority(int fd)
+{
+    std::random_device random;
+    std::vector<char> cookie(16);
+    for (auto& c : cookie)
+        c = static_cast<char>(random());
+
+    char family_wild_address[] = "";
+    char any_display[] = "";
+    char auth_name[] = "MIT-MAGIC-COOKIE-1";
+
+    Xauth auth;
+    auth.family = FamilyWild;
+    auth.address = family_wild_address;
+    auth.address_length = 0;
+    auth.number = any_display;
+    auth.number_length = 0;
+    auth.name = auth_name;
+    auth.name_length = sizeof(auth_name) - 1;
+    auth.data = cookie.data();
+    auth.data_length = cookie.size();
+
+    auto const file = fdopen(fd, "wb");
+    if (!file || !XauWriteAuth(file, &auth) || fclose(file) != 0)
+        throw std::runtime_error("Failed to write Xauthority file");
+}
+
+}
+
+rt::XvfbServer::XvfbServer()
+    : pid{0}
+{
+    char xauthority_template[] = "/tmp/repowerd-test-xauthority-XXXXXX";
+    auto const xauthority_fd = mkstemp(xauthority_template);
+    if (xauthority_fd < 0)
+        throw std::runtime_error("Failed to create Xauthority file");
+
+    xauthority_path_ = xauthority_template;
+    write_xauthority(xauthority_fd);
+
+    int displayfd[2];
+    if (pipe(displayfd) < 0)
+        throw std::runtime_error("Failed to create Xvfb displayfd pipe");
+
+    pid = fork();
+
+    if (pid == 0)
+    {
+        close(displayfd[0]);
+        auto const null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+
+        auto const displayfd_str = std::to_string(displayfd[1]);
+        execlp("Xvfb", "Xvfb",
+               "-displayfd", displayfd_str.c_str(),
+               "-auth", xauthority_path_.c_str(),
+               "-nolisten", "tcp",
+               static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    close(displayfd[1]);
+
+    // Xvfb writes the display number once it is ready to accept clients
+    std::string display_number;
+    char c;
+    while (pid > 0 && read(displayfd[0], &c, 1) == 1 && c != '\n')
+        display_number += c;
+
+    close(displayfd[0]);
+
+    if (display_number.empty())
+    {
+        stop();
+        unlink(xauthority_path_.c_str());
+        throw std::runtime_error("Failed to start Xvfb");
+    }
+
+    display_name_ = ":" + display_number;
+}
+
+rt::XvfbServer::~XvfbServer()
+{
+    stop();
+    unlink(xauthority_path_.c_str());
+}
+
+std::string rt::XvfbServer::display_name()
+{
+    return display_name_;
+}
+
+std::string rt::XvfbServer::xauthority_path()
+{
+    return xauthority_path_;
+}
+
+void rt::XvfbServer::stop()
+{
+    if (pid > 0)
+    {
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+        pid = 0;
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <string>
+#include <sys/types.h>
+
+namespace repowerd
+{
+namespace test
+{
+
+// An Xvfb server that only accepts clients with the cookie
+// stored in xauthority_path()
+class XvfbServer
+{
+public:
+    XvfbServer();
+    ~XvfbServer();
+
+    std::string display_name();
+    std::string xauthority_path();
+
+    void stop();
+
+private:
+    std::string display_name_;
+    std::string xauthority_path_;
+    pid_t pid;
+};
+
+}
+}
@@ -0,0 +1,241 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/adapters/monotone_spline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+
+using Point = repowerd::MonotoneSpline::Point;
+
+double ns_per_op(int ops, std::function<void()> const& func)
+{
+    auto const start = std::chrono::steady_clock::now();
+    func();
+    auto const end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>{end - start}.count() / ops;
+}
+
+// The previous evaluator, which scans for the segment and evaluates the
+// Hermite basis on every call, kept as a reference
+std::vector<double> secant_slopes(
+    std::vector<Point> const& points)
+{
+    std::vector<double> slopes;
+
+    for (auto i = 0u; i < points.size() - 1; ++i)
+    {
+        auto dy = points[i+1].y - points[i].y;
+        auto dx = points[i+1].x - points[i].x;
+        slopes.push_back(dy/dx);
+    }
+
+    slopes.push_back(0);
+
+    return slopes;
+}
+
+std::vector<double> point_tangents(std::vector<double> const& slopes)
+{
+    std::vector<double> tangents;
+
+    tangents.push_back(slopes.front());
+    for (auto i = 1u; i < slopes.size() - 1; ++i)
+    {
+        if (slopes[i-1]*slopes[i] < 0)
+            tangents.push_back(0);
+        else
+            tangents.push_back((slopes[i-1] + slopes[i]) / 2);
+    }
+    tangents.push_back(slopes[slopes.size() - 2]);
+
+    return tangents;
+}
+
+void ensure_monotonicity(std::vector<double>& tangents,
+                         std::vector<double> const& slopes)
+{
+    auto const alpha =
+        [&](int i) { return tangents[i] / slopes[i]; };
+    auto const beta =
+        [&](int i) { return (i < 0) ? 0 : tangents[i+1] / slopes[i]; };
+
+    for (auto i = 0u; i < slopes.size() - 1; ++i)
+    {
+        if (slopes[i] == 0.0)
+        {
+            tangents[i] = 0;
+            tangents[++i] = 0;
+            continue;
+        }
+
+        auto const alpha_i = alpha(i);
+
+        if (alpha_i < 0 || beta(i-1) < 0)
+        {
+            tangents[i] = 0;
+            continue;
+        }
+
+        if (alpha_i > 3)
+            tangents[i] = 3 * slopes[i];
+
+        if (beta(i) > 3)
+            tangents[i+1] = 3 * slopes[i];
+    }
+}
+
+std::vector<double> calculate_monotone_point_tangents(
+    std::vector<Point> const& points)
+{
+    if (points.size() < 2)
+        throw std::logic_error("Cannot create spline with fewer than two points");
+
+    auto const slopes = secant_slopes(points);
+    auto tangents = point_tangents(slopes);
+    ensure_monotonicity(tangents, slopes);
+    return tangents;
+}
+
+class ReferenceSpline
+{
+public:
+    ReferenceSpline(std::vector<Point> const& points)
+        : points{points},
+          tangents{calculate_monotone_point_tangents(points)}
+    {
+    }
+
+    double interpolate(double x) const
+    {
+        auto const i = find_index(x);
+
+        if (i < 0)
+            return points.front().y;
+        if (i >= static_cast<int>(points.size() - 1))
+            return points.back().y;
+
+        auto const h = points[i+1].x - points[i].x;
+        auto const t = (x - points[i].x) / h;
+        auto const h00 = t * t * (2 * t - 3) + 1;
+        auto const h10 = t * (1 + t * (t - 2));
+        auto const h01 = t * t * (3 - 2 * t);
+        auto const h11 = t * t * (t - 1);
+
+        return h00 * points[i].y +
+               h10 * h * tangents[i] +
+               h01 * points[i+1].y +
+               h11 * h * tangents[i+1];
+    }
+
+private:
+    int find_index(double x) const
+    {
+        if (x < points[0].x)
+            return -1;
+
+        for (auto i = 0u; i < points.size() - 1; ++i)
+        {
+            if (x >= points[i].x && x < points[i+1].x)
+                return i;
+        }
+
+        return points.size() - 1;
+    }
+
+    std::vector<Point> const points;
+    std::vector<double> const tangents;
+};
+
+// Like vendor autoBrightnessLevels, roughly logarithmic in lux
+std::vector<Point> light_curve(int num_points)
+{
+    std::vector<Point> points;
+    for (int i = 0; i < num_points; ++i)
+    {
+        auto const lux = std::pow(10.0, 5.0 * i / (num_points - 1)) - 1.0;
+        points.push_back({lux, 10.0 + 245.0 * i / (num_points - 1)});
+    }
+    return points;
+}
+
+bool run(int num_points)
+{
+    int const iterations = 1000000;
+
+    auto const points = light_curve(num_points);
+    repowerd::MonotoneSpline const spline{points};
+    ReferenceSpline const reference{points};
+
+    std::mt19937 rng{static_cast<std::mt19937::result_type>(num_points)};
+    std::uniform_real_distribution<double> exponent{0.0, 5.0};
+    std::vector<double> inputs;
+    for (int i = 0; i < 1024; ++i)
+        inputs.push_back(std::pow(10.0, exponent(rng)));
+
+    auto max_error = 0.0;
+    for (auto const x : inputs)
+        max_error = std::max(max_error, std::fabs(spline.interpolate(x) - reference.interpolate(x)));
+
+    volatile double sink = 0.0;
+
+    auto const spline_ns = ns_per_op(
+        iterations,
+        [&]
+        {
+            for (int i = 0; i < iterations; ++i)
+                sink = sink + spline.interpolate(inputs[i % inputs.size()]);
+        });
+
+    auto const reference_ns = ns_per_op(
+        iterations,
+        [&]
+        {
+            for (int i = 0; i < iterations; ++i)
+                sink = sink + reference.interpolate(inputs[i % inputs.size()]);
+        });
+
+    // Only rounding differences are expected
+    auto const matches = max_error < 1e-9;
+
+    printf("%3d points: MonotoneSpline %8.1f ns/op, reference %8.1f ns/op, max error %.2e%s\n",
+           num_points, spline_ns, reference_ns, max_error, matches ? "" : " MISMATCH");
+
+    return matches;
+}
+
+}
+
+int main()
+{
+    auto ok = true;
+
+    for (auto const num_points : {9, 24, 64})
+        ok = run(num_points) && ok;
+
+    return ok ? 0 : 1;
+}
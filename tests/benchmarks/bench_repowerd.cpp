@@ -0,0 +1,297 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// Microbenchmarks for the daemon hot paths, reported as JSON so that
+// results can be compared across releases
+
+#include "src/core/daemon.h"
+#include "src/adapters/android_autobrightness_algorithm.h"
+#include "src/adapters/backlight_brightness_control.h"
+#include "src/adapters/chrono.h"
+#include "src/adapters/event_loop.h"
+#include "src/adapters/event_loop_timer.h"
+#include "src/adapters/light_sensor.h"
+#include "src/adapters/monotone_spline.h"
+#include "src/adapters/null_log.h"
+#include "src/adapters/ring_buffer_log.h"
+#include "src/adapters/sysfs_backlight.h"
+
+#include "fake_shared.h"
+#include "tests/adapter-tests/fake_device_config.h"
+#include "tests/adapter-tests/fake_device_quirks.h"
+#include "tests/adapter-tests/fake_filesystem.h"
+#include "tests/core-tests/daemon_config.h"
+#include "tests/core-tests/fake_power_source.h"
+#include "tests/core-tests/run_daemon.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace rt = repowerd::test;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct Result
+{
+    std::string name;
+    int iterations;
+    double ns_per_op;
+};
+
+Result measure(std::string const& name, int iterations, std::function<void()> const& func)
+{
+    auto const start = std::chrono::steady_clock::now();
+    func();
+    auto const end = std::chrono::steady_clock::now();
+
+    return {name, iterations,
+            std::chrono::duration<double, std::nano>{end - start}.count() / iterations};
+}
+
+// Time runs an hour ahead on every query, so brightness transitions
+// apply all their steps at once instead of waiting for timers
+class JumpingChrono : public repowerd::Chrono
+{
+public:
+    void sleep_for(std::chrono::nanoseconds) override {}
+
+    std::chrono::steady_clock::time_point steady_now() override
+    {
+        offset += 1h;
+        return std::chrono::steady_clock::now() + offset;
+    }
+
+private:
+    std::chrono::steady_clock::duration offset{};
+};
+
+class NullLightSensor : public repowerd::LightSensor
+{
+public:
+    repowerd::HandlerRegistration register_light_handler(
+        repowerd::LightHandler const&) override
+    {
+        return {};
+    }
+
+    void enable_light_events() override {}
+    void disable_light_events() override {}
+};
+
+Result daemon_enqueue_dispatch(int iterations)
+{
+    rt::DaemonConfig config;
+    repowerd::Daemon daemon{config};
+    auto daemon_thread = rt::run_daemon(daemon);
+
+    auto const result = measure(
+        "daemon_enqueue_dispatch", iterations,
+        [&]
+        {
+            for (int i = 0; i < iterations; ++i)
+                config.the_fake_power_source()->emit_power_source_change();
+            daemon.flush();
+        });
+
+    daemon.stop();
+    daemon_thread.join();
+
+    return result;
+}
+
+Result event_loop_enqueue_round_trip(int iterations)
+{
+    repowerd::EventLoop event_loop{"Bench"};
+
+    return measure(
+        "event_loop_enqueue_round_trip", iterations,
+        [&]
+        {
+            for (int i = 0; i < iterations; ++i)
+                event_loop.enqueue([]{}).get();
+        });
+}
+
+Result event_loop_timer_schedule_cancel(int iterations)
+{
+    repowerd::EventLoopTimer timer;
+
+    return measure(
+        "event_loop_timer_schedule_cancel", iterations,
+        [&]
+        {
+            for (int i = 0; i < iterations; ++i)
+                timer.cancel_alarm(timer.schedule_alarm_in(10s));
+        });
+}
+
+// Like vendor autoBrightnessLevels, roughly logarithmic in lux
+std::vector<repowerd::MonotoneSpline::Point> light_curve(int num_points)
+{
+    std::vector<repowerd::MonotoneSpline::Point> points;
+    for (int i = 0; i < num_points; ++i)
+    {
+        auto const lux = std::pow(10.0, 5.0 * i / (num_points - 1)) - 1.0;
+        points.push_back({lux, 10.0 + 245.0 * i / (num_points - 1)});
+    }
+    return points;
+}
+
+Result monotone_spline_interpolate(int iterations)
+{
+    repowerd::MonotoneSpline const spline{light_curve(24)};
+    volatile double sink = 0.0;
+
+    return measure(
+        "monotone_spline_interpolate", iterations,
+        [&]
+        {
+            for (int i = 0; i < iterations; ++i)
+                sink = sink + spline.interpolate(i % 100000);
+        });
+}
+
+Result autobrightness_new_light_values(int iterations)
+{
+    rt::FakeDeviceConfig device_config;
+    std::string levels;
+    std::string values;
+    for (auto const& point : light_curve(24))
+    {
+        if (point.x > 0.0)
+            levels += (levels.empty() ? "" : ",") + std::to_string(static_cast<int>(point.x));
+        values += (values.empty() ? "" : ",") + std::to_string(static_cast<int>(point.y));
+    }
+    device_config.set("autoBrightnessLevels", levels);
+    device_config.set("autoBrightnessLcdBacklightValues", values);
+
+    repowerd::EventLoop event_loop{"Bench"};
+    repowerd::AndroidAutobrightnessAlgorithm algorithm{
+        device_config, std::make_shared<repowerd::NullLog>()};
+    algorithm.init(event_loop);
+    algorithm.start();
+
+    repowerd::LightSamples samples{{std::chrono::steady_clock::now(), 0.0}};
+
+    // Feed the algorithm from its own loop, as the brightness control does
+    return measure(
+        "autobrightness_new_light_values", iterations,
+        [&]
+        {
+            event_loop.enqueue(
+                [&]
+                {
+                    for (int i = 0; i < iterations; ++i)
+                    {
+                        samples[0].time += 100ms;
+                        samples[0].light = (i % 2) ? 100.0 : 1000.0;
+                        algorithm.new_light_values(samples);
+                    }
+                }).get();
+        });
+}
+
+Result backlight_brightness_transition(int iterations)
+{
+    rt::FakeFilesystem filesystem;
+    filesystem.add_file_with_contents("/sys/class/backlight/bench/type", "raw");
+    filesystem.add_file_with_live_contents("/sys/class/backlight/bench/brightness")->push_back("0");
+    filesystem.add_file_with_contents("/sys/class/backlight/bench/max_brightness", "255");
+
+    auto const log = std::make_shared<repowerd::NullLog>();
+    rt::FakeDeviceConfig device_config;
+    rt::FakeDeviceQuirks device_quirks;
+
+    repowerd::BacklightBrightnessControl brightness_control{
+        std::make_shared<repowerd::SysfsBacklight>(log, rt::fake_shared(filesystem)),
+        std::make_shared<NullLightSensor>(),
+        std::make_shared<repowerd::AndroidAutobrightnessAlgorithm>(device_config, log),
+        std::make_shared<JumpingChrono>(),
+        log,
+        device_config,
+        device_quirks,
+        repowerd::BrightnessCurve{repowerd::BrightnessCurve::Easing::linear, true, 0}};
+
+    brightness_control.set_normal_brightness();
+
+    // Each iteration is a full transition between dim and bright levels,
+    // including the event loop round trip to request it
+    return measure(
+        "backlight_brightness_transition", iterations,
+        [&]
+        {
+            for (int i = 0; i < iterations; ++i)
+                brightness_control.set_normal_brightness_value((i % 2) ? 0.1 : 0.9);
+        });
+}
+
+// Producer side only: the buffer is large enough that nothing is dropped
+// and the flusher doesn't run during the measurement
+Result ring_buffer_log_line(int iterations)
+{
+    repowerd::RingBufferLog log{
+        std::make_shared<repowerd::NullLog>(), static_cast<size_t>(iterations), 1h,
+        repowerd::RingBufferLog::SignalHandling::none};
+
+    // Fault in the buffer pages before measuring
+    for (int i = 0; i < iterations; ++i)
+        log.log("Bench", "Warm up %d", i);
+    log.drain();
+
+    return measure(
+        "ring_buffer_log_line", iterations,
+        [&]
+        {
+            for (int i = 0; i < iterations; ++i)
+                log.log("Bench", "Setting brightness %d, transition %s", i, "smooth");
+        });
+}
+
+void print_json(std::vector<Result> const& results)
+{
+    printf("{\n  \"benchmarks\": [\n");
+
+    for (auto i = 0u; i < results.size(); ++i)
+    {
+        printf("    {\"name\": \"%s\", \"iterations\": %d, \"ns_per_op\": %.1f}%s\n",
+               results[i].name.c_str(), results[i].iterations, results[i].ns_per_op,
+               i + 1 < results.size() ? "," : "");
+    }
+
+    printf("  ]\n}\n");
+}
+
+}
+
+int main()
+{
+    print_json({
+        daemon_enqueue_dispatch(10000),
+        event_loop_enqueue_round_trip(10000),
+        event_loop_timer_schedule_cancel(10000),
+        monotone_spline_interpolate(1000000),
+        autobrightness_new_light_values(100000),
+        backlight_brightness_transition(1000),
+        ring_buffer_log_line(100000)});
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/adapters/event_loop_timer.h"
+#include "src/adapters/timer_wheel_timer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+
+double ns_per_op(int ops, std::function<void()> const& func)
+{
+    auto const start = std::chrono::steady_clock::now();
+    func();
+    auto const end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>{end - start}.count() / ops;
+}
+
+double schedule_and_cancel(repowerd::Timer& timer, int iterations)
+{
+    return ns_per_op(
+        iterations,
+        [&]
+        {
+            for (int i = 0; i < iterations; ++i)
+                timer.cancel_alarm(timer.schedule_alarm_in(10s));
+        });
+}
+
+// Mimics the state machine re-arming the dim, display-off and suspend
+// alarms on every user activity event
+double rearm_on_activity(repowerd::Timer& timer, int iterations)
+{
+    std::vector<repowerd::AlarmId> alarms{
+        timer.schedule_alarm_in(20s),
+        timer.schedule_alarm_in(30s),
+        timer.schedule_alarm_in(60s)};
+
+    auto const result = ns_per_op(
+        iterations,
+        [&]
+        {
+            for (int i = 0; i < iterations; ++i)
+            {
+                for (auto const id : alarms)
+                    timer.cancel_alarm(id);
+                alarms[0] = timer.schedule_alarm_in(20s);
+                alarms[1] = timer.schedule_alarm_in(30s);
+                alarms[2] = timer.schedule_alarm_in(60s);
+            }
+        });
+
+    for (auto const id : alarms)
+        timer.cancel_alarm(id);
+
+    return result;
+}
+
+void run(char const* name, repowerd::Timer& timer)
+{
+    int const iterations = 10000;
+
+    printf("%-16s schedule+cancel:   %10.1f ns/op\n",
+           name, schedule_and_cancel(timer, iterations));
+    printf("%-16s rearm on activity: %10.1f ns/op\n",
+           name, rearm_on_activity(timer, iterations));
+}
+
+}
+
+int main()
+{
+    {
+        repowerd::EventLoopTimer timer;
+        run("EventLoopTimer", timer);
+    }
+
+    {
+        repowerd::TimerWheelTimer timer;
+        run("TimerWheelTimer", timer);
+    }
+}
@@ -39,20 +39,16 @@ bool get_log_to_console()
 rt::FakeLog::FakeLog()
     : log_to_console{get_log_to_console()}
 {
+    levels().set_default_level(LogLevel::trace);
 }
 
-void rt::FakeLog::log(char const* tag, char const* format, ...)
+void rt::FakeLog::vlog(LogLevel, char const* tag, char const* format, va_list ap)
 {
     std::string const format_str = std::string{tag} + ": " + format + "\n";
 
-    va_list ap;
-    va_start(ap, format);
-
     char output[1024];
     vsnprintf(output, 1024, format_str.c_str(), ap);
 
-    va_end(ap);
-
     std::lock_guard<std::mutex> lock{contents_mutex};
     contents.push_back(output);
 
@@ -34,10 +34,11 @@ class FakeLog : public Log
 public:
     FakeLog();
 
-    void log(char const* tag, char const* format, ...) override;
-
     bool contains_line(std::vector<std::string> const& words);
 
+protected:
+    void vlog(LogLevel level, char const* tag, char const* format, va_list ap) override;
+
 private:
     bool const log_to_console;
     std::mutex contents_mutex;
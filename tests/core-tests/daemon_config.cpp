@@ -18,6 +18,7 @@
 
 #include "daemon_config.h"
 #include "src/core/default_state_machine_factory.h"
+#include "src/core/event_latency.h"
 
 #include "fake_display_information.h"
 #include "mock_brightness_control.h"
@@ -80,6 +81,13 @@ std::shared_ptr<repowerd::DisplayPowerEventSink> rt::DaemonConfig::the_display_p
     return the_mock_display_power_event_sink();
 }
 
+std::shared_ptr<repowerd::EventLatencyStats> rt::DaemonConfig::the_event_latency_stats()
+{
+    if (!event_latency_stats)
+        event_latency_stats = std::make_shared<EventLatencyStats>();
+    return event_latency_stats;
+}
+
 std::shared_ptr<repowerd::Lid> rt::DaemonConfig::the_lid()
 {
     return the_fake_lid();
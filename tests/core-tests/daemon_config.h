@@ -62,6 +62,7 @@ public:
     std::shared_ptr<ClientSettings> the_client_settings() override;
     std::shared_ptr<DisplayPowerControl> the_display_power_control() override;
     std::shared_ptr<DisplayPowerEventSink> the_display_power_event_sink() override;
+    std::shared_ptr<EventLatencyStats> the_event_latency_stats() override;
     std::shared_ptr<Lid> the_lid() override;
     std::shared_ptr<Lock> the_lock() override;
     std::shared_ptr<Log> the_log() override;
@@ -113,6 +114,7 @@ public:
 private:
     std::shared_ptr<StateMachineFactory> state_machine_factory;
     std::shared_ptr<StateMachineOptions> state_machine_options;
+    std::shared_ptr<EventLatencyStats> event_latency_stats;
 
     std::shared_ptr<FakeDisplayInformation> fake_display_information;
     std::shared_ptr<testing::NiceMock<MockBrightnessControl>> mock_brightness_control;
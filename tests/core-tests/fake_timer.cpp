@@ -67,6 +67,22 @@ void rt::FakeTimer::cancel_alarm(AlarmId id)
         alarms.end());
 }
 
+bool rt::FakeTimer::extend_alarm_in(AlarmId id, std::chrono::milliseconds t)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const iter = std::find_if(
+        alarms.begin(),
+        alarms.end(),
+        [id](auto const& alarm) { return alarm.id == id; });
+
+    if (iter == alarms.end())
+        return false;
+
+    iter->time = now_ms + t;
+    return true;
+}
+
 std::chrono::steady_clock::time_point rt::FakeTimer::now()
 {
     std::lock_guard<std::mutex> lock{mutex};
@@ -38,6 +38,7 @@ public:
     HandlerRegistration register_alarm_handler(AlarmHandler const& handler) override;
     AlarmId schedule_alarm_in(std::chrono::milliseconds t) override;
     void cancel_alarm(AlarmId id) override;
+    bool extend_alarm_in(AlarmId id, std::chrono::milliseconds t) override;
     std::chrono::steady_clock::time_point now() override;
 
     void advance_by(std::chrono::milliseconds advance);
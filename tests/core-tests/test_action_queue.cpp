@@ -0,0 +1,226 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/core/action_queue.h"
+
+#include <poll.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+using namespace testing;
+
+TEST(AnAction, invokes_inline_callable)
+{
+    int calls = 0;
+    repowerd::Action action{[&calls] { ++calls; }};
+
+    action();
+
+    EXPECT_THAT(calls, Eq(1));
+}
+
+TEST(AnAction, invokes_callable_larger_than_inline_storage)
+{
+    char large[repowerd::Action::inline_size * 2] = {'x'};
+    char seen = 0;
+
+    repowerd::Action action{[large, &seen] { seen = large[0]; }};
+    action();
+
+    EXPECT_THAT(seen, Eq('x'));
+}
+
+TEST(AnAction, move_transfers_callable_and_empties_source)
+{
+    auto const counter = std::make_shared<int>(0);
+    repowerd::Action a1{[counter] { ++*counter; }};
+
+    repowerd::Action a2{std::move(a1)};
+    EXPECT_FALSE(a1);
+    EXPECT_TRUE(a2);
+
+    repowerd::Action a3;
+    a3 = std::move(a2);
+    EXPECT_FALSE(a2);
+
+    a3();
+    EXPECT_THAT(*counter, Eq(1));
+}
+
+TEST(AnAction, destroys_captures_when_destroyed)
+{
+    auto const counter = std::make_shared<int>(0);
+
+    {
+        repowerd::Action action{[counter] {}};
+        EXPECT_THAT(counter.use_count(), Eq(2));
+    }
+
+    EXPECT_THAT(counter.use_count(), Eq(1));
+}
+
+TEST(AnActionQueue, pops_actions_in_push_order)
+{
+    repowerd::ActionQueue queue{8};
+    std::vector<int> order;
+
+    for (int i = 0; i < 5; ++i)
+        queue.push([&order, i] { order.push_back(i); });
+
+    for (int i = 0; i < 5; ++i)
+        queue.pop()();
+
+    EXPECT_THAT(order, ElementsAre(0, 1, 2, 3, 4));
+}
+
+TEST(AnActionQueue, pops_priority_actions_first)
+{
+    repowerd::ActionQueue queue{8};
+    std::vector<int> order;
+
+    queue.push([&order] { order.push_back(1); });
+    queue.push_priority([&order] { order.push_back(0); });
+
+    queue.pop()();
+    queue.pop()();
+
+    EXPECT_THAT(order, ElementsAre(0, 1));
+}
+
+TEST(AnActionQueue, keeps_actions_pushed_to_full_ring_in_order)
+{
+    repowerd::ActionQueue queue{4};
+    std::vector<int> order;
+
+    for (int i = 0; i < 10; ++i)
+        queue.push([&order, i] { order.push_back(i); });
+
+    for (int i = 0; i < 10; ++i)
+        queue.pop()();
+
+    EXPECT_THAT(order, ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+}
+
+TEST(AnActionQueue, accepts_push_from_consumer_with_full_ring)
+{
+    repowerd::ActionQueue queue{4};
+    std::vector<int> order;
+
+    for (int i = 0; i < 4; ++i)
+        queue.push([&order, i] { order.push_back(i); });
+
+    // Run by the consumer while the ring is full
+    queue.push_priority(
+        [&]
+        {
+            for (int i = 4; i < 8; ++i)
+                queue.push([&order, i] { order.push_back(i); });
+        });
+
+    for (int i = 0; i < 9; ++i)
+        queue.pop()();
+
+    repowerd::Action action;
+    EXPECT_FALSE(queue.try_pop(action));
+    EXPECT_THAT(order, ElementsAre(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+TEST(AnActionQueue, throws_if_capacity_is_not_power_of_two)
+{
+    EXPECT_THROW({ repowerd::ActionQueue queue{10}; }, std::invalid_argument);
+}
+
+TEST(AnActionQueue, pop_waits_for_push_from_other_thread)
+{
+    repowerd::ActionQueue queue{8};
+    bool called = false;
+
+    std::thread producer{
+        [&]
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+            queue.push([&called] { called = true; });
+        }};
+
+    queue.pop()();
+    producer.join();
+
+    EXPECT_TRUE(called);
+}
+
+TEST(AnActionQueue, try_pop_signals_wakeup_fd_on_push_after_finding_queue_empty)
+{
+    repowerd::ActionQueue queue{8};
+    repowerd::Action action;
+
+    EXPECT_FALSE(queue.try_pop(action));
+
+    pollfd pfd{queue.wakeup_fd(), POLLIN, 0};
+    EXPECT_THAT(poll(&pfd, 1, 0), Eq(0));
+
+    bool called = false;
+    queue.push([&called] { called = true; });
+
+    EXPECT_THAT(poll(&pfd, 1, 0), Eq(1));
+    queue.clear_wakeup();
+
+    EXPECT_TRUE(queue.try_pop(action));
+    action();
+    EXPECT_TRUE(called);
+    EXPECT_FALSE(queue.try_pop(action));
+}
+
+TEST(AnActionQueue, delivers_all_actions_from_multiple_producers)
+{
+    int const num_producers = 8;
+    int const actions_per_producer = 10000;
+
+    repowerd::ActionQueue queue{64};
+    std::vector<int> last_seen(num_producers, -1);
+    bool in_order = true;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < num_producers; ++p)
+    {
+        producers.emplace_back(
+            [&, p]
+            {
+                for (int i = 0; i < actions_per_producer; ++i)
+                {
+                    queue.push(
+                        [&, p, i]
+                        {
+                            if (last_seen[p] != i - 1) in_order = false;
+                            last_seen[p] = i;
+                        });
+                }
+            });
+    }
+
+    for (int i = 0; i < num_producers * actions_per_producer; ++i)
+        queue.pop()();
+
+    for (auto& t : producers)
+        t.join();
+
+    EXPECT_TRUE(in_order);
+    EXPECT_THAT(last_seen, Each(Eq(actions_per_producer - 1)));
+}
@@ -34,10 +34,14 @@
 #include "mock_brightness_control.h"
 
 #include "src/core/daemon.h"
+#include "src/core/event_latency.h"
 #include "src/core/power_button.h"
 #include "src/core/state_machine.h"
 #include "src/core/state_machine_factory.h"
 
+#include <algorithm>
+#include <atomic>
+#include <future>
 #include <thread>
 
 #include <gmock/gmock.h>
@@ -332,6 +336,22 @@ TEST_F(ADaemon, notifies_state_machine_of_power_button_release)
     config.the_fake_power_button()->release();
 }
 
+TEST_F(ADaemon, records_latency_of_power_button_events)
+{
+    start_daemon();
+
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_power_button_press(_));
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_power_button_release());
+
+    config.the_fake_power_button()->onPress();
+    config.the_fake_power_button()->release();
+    flush_daemon();
+
+    auto const stats = config.the_event_latency_stats();
+    EXPECT_THAT(stats->summary(repowerd::EventType::power_button_press).count, Eq(1u));
+    EXPECT_THAT(stats->summary(repowerd::EventType::power_button_release).count, Eq(1u));
+}
+
 TEST_F(ADaemon, registers_starts_and_unregisters_lock_handler)
 {
     InSequence s;
@@ -392,6 +412,122 @@ TEST_F(ADaemon, notifies_state_machine_of_user_activity_extending_power_state)
     config.the_fake_user_activity()->perform(repowerd::UserActivityType::extend_power_state);
 }
 
+TEST_F(ADaemon, coalesces_consecutive_queued_user_activity_events)
+{
+    start_daemon();
+
+    std::promise<void> release_daemon;
+    auto release_future = release_daemon.get_future().share();
+
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_power_button_release())
+        .WillOnce(InvokeWithoutArgs([release_future] { release_future.wait(); }));
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_user_activity_extending_power_state())
+        .Times(0);
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_user_activity_changing_power_state());
+
+    config.the_fake_power_button()->release();
+    config.the_fake_user_activity()->perform(repowerd::UserActivityType::extend_power_state);
+    config.the_fake_user_activity()->perform(repowerd::UserActivityType::change_power_state);
+    config.the_fake_user_activity()->perform(repowerd::UserActivityType::extend_power_state);
+
+    release_daemon.set_value();
+    flush_daemon();
+
+    auto const counters = daemon->user_activity_counters();
+    EXPECT_THAT(counters.dispatched, Eq(1u));
+    EXPECT_THAT(counters.merged, Eq(2u));
+}
+
+TEST_F(ADaemon, does_not_coalesce_user_activity_events_separated_by_other_events)
+{
+    start_daemon();
+
+    std::promise<void> release_daemon;
+    auto release_future = release_daemon.get_future().share();
+
+    InSequence s;
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_power_button_release())
+        .WillOnce(InvokeWithoutArgs([release_future] { release_future.wait(); }));
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_user_activity_extending_power_state());
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_lock_active());
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_user_activity_extending_power_state());
+
+    config.the_fake_power_button()->release();
+    config.the_fake_user_activity()->perform(repowerd::UserActivityType::extend_power_state);
+    config.the_fake_lock()->active();
+    config.the_fake_user_activity()->perform(repowerd::UserActivityType::extend_power_state);
+
+    release_daemon.set_value();
+    flush_daemon();
+
+    auto const counters = daemon->user_activity_counters();
+    EXPECT_THAT(counters.dispatched, Eq(2u));
+    EXPECT_THAT(counters.merged, Eq(0u));
+}
+
+TEST_F(ADaemon, dispatches_user_activity_before_events_queued_after_it_from_any_thread)
+{
+    int const iterations = 2000;
+    std::vector<char> events;
+
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_user_activity_changing_power_state())
+        .WillRepeatedly(InvokeWithoutArgs([&events] { events.push_back('c'); }));
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_user_activity_extending_power_state())
+        .Times(AnyNumber());
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_lock_active())
+        .WillRepeatedly(InvokeWithoutArgs([&events] { events.push_back('l'); }));
+
+    start_daemon();
+
+    // Other threads keep queuing activity actions, which the activity
+    // below may be merged into while they are still being queued
+    std::atomic<bool> done{false};
+    std::vector<std::thread> noise;
+    for (int i = 0; i < 3; ++i)
+    {
+        noise.emplace_back(
+            [&]
+            {
+                while (!done)
+                {
+                    config.the_fake_user_activity()->perform(
+                        repowerd::UserActivityType::extend_power_state);
+                }
+            });
+    }
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        config.the_fake_user_activity()->perform(repowerd::UserActivityType::change_power_state);
+        config.the_fake_lock()->active();
+    }
+
+    done = true;
+    for (auto& t : noise)
+        t.join();
+    flush_daemon();
+
+    // Each lock event must follow the changing activity queued before it,
+    // whether dispatched on its own or merged into another activity action
+    int out_of_order = 0;
+    bool changed = false;
+    for (auto const event : events)
+    {
+        if (event == 'c')
+        {
+            changed = true;
+        }
+        else
+        {
+            if (!changed) ++out_of_order;
+            changed = false;
+        }
+    }
+
+    EXPECT_THAT(out_of_order, Eq(0));
+    EXPECT_THAT(std::count(events.begin(), events.end(), 'l'), Eq(iterations));
+}
+
 TEST_F(ADaemon, registers_starts_and_unregisters_proximity_handler)
 {
     EXPECT_CALL(config.the_fake_proximity_sensor()->mock, register_proximity_handler(_));
@@ -0,0 +1,93 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/core/event_latency.h"
+
+#include <gmock/gmock.h>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct AnEventLatencyStats : testing::Test
+{
+    void record_total(repowerd::EventType type, std::chrono::microseconds total)
+    {
+        stats.record(type, t0, t0, t0 + total);
+    }
+
+    repowerd::EventLatencyStats stats;
+    repowerd::EventLatencyStats::TimePoint const t0{std::chrono::steady_clock::now()};
+};
+
+}
+
+TEST_F(AnEventLatencyStats, reports_zero_for_unrecorded_event_types)
+{
+    auto const summary = stats.summary(repowerd::EventType::lid);
+
+    EXPECT_THAT(summary.count, Eq(0u));
+    EXPECT_THAT(summary.total_p50, Eq(0us));
+    EXPECT_THAT(summary.total_p99, Eq(0us));
+    EXPECT_THAT(summary.total_max, Eq(0us));
+}
+
+TEST_F(AnEventLatencyStats, records_queue_and_total_latency)
+{
+    stats.record(repowerd::EventType::proximity_near, t0, t0 + 3ms, t0 + 5ms);
+
+    auto const summary = stats.summary(repowerd::EventType::proximity_near);
+
+    EXPECT_THAT(summary.count, Eq(1u));
+    EXPECT_THAT(summary.queue_max, Eq(3ms));
+    EXPECT_THAT(summary.total_max, Eq(5ms));
+    EXPECT_THAT(summary.queue_p50, Eq(3ms));
+    EXPECT_THAT(summary.total_p99, Eq(5ms));
+}
+
+TEST_F(AnEventLatencyStats, keeps_event_types_separate)
+{
+    record_total(repowerd::EventType::power_button_press, 1ms);
+    record_total(repowerd::EventType::power_button_release, 7ms);
+
+    EXPECT_THAT(stats.summary(repowerd::EventType::power_button_press).total_max, Eq(1ms));
+    EXPECT_THAT(stats.summary(repowerd::EventType::power_button_release).total_max, Eq(7ms));
+}
+
+TEST_F(AnEventLatencyStats, approximates_percentiles_within_bucket_precision)
+{
+    for (int i = 1; i <= 100; ++i)
+        record_total(repowerd::EventType::alarm, std::chrono::microseconds{i * 100});
+
+    auto const summary = stats.summary(repowerd::EventType::alarm);
+
+    EXPECT_THAT(summary.count, Eq(100u));
+    EXPECT_THAT(summary.total_p50.count(), AllOf(Ge(5000), Le(5000 * 9 / 8)));
+    EXPECT_THAT(summary.total_p99.count(), AllOf(Ge(9900), Le(10000)));
+    EXPECT_THAT(summary.total_max, Eq(10ms));
+}
+
+TEST_F(AnEventLatencyStats, has_a_name_for_each_event_type)
+{
+    for (int i = 0; i < static_cast<int>(repowerd::EventType::count); ++i)
+    {
+        EXPECT_THAT(
+            repowerd::event_type_to_string(static_cast<repowerd::EventType>(i)),
+            StrNe("unknown"));
+    }
+}
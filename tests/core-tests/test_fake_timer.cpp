@@ -136,3 +136,23 @@ TEST_F(AFakeTimer, does_not_notify_for_cancelled_alarms)
 
     fake_timer.advance_by(30s);
 }
+
+TEST_F(AFakeTimer, notifies_for_extended_alarms_at_their_new_deadline)
+{
+    auto const id1 = fake_timer.schedule_alarm_in(10s);
+    auto const id2 = fake_timer.schedule_alarm_in(20s);
+
+    EXPECT_CALL(*this, alarm_handler(id1)).Times(0);
+    EXPECT_CALL(*this, alarm_handler(id2));
+
+    EXPECT_TRUE(fake_timer.extend_alarm_in(id1, 30s));
+    fake_timer.advance_by(29s);
+
+    testing::Mock::VerifyAndClearExpectations(this);
+
+    EXPECT_CALL(*this, alarm_handler(id1));
+
+    fake_timer.advance_by(1s);
+
+    EXPECT_FALSE(fake_timer.extend_alarm_in(id1, 30s));
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright © 2019 Gemian
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/core/log.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace testing;
+
+namespace
+{
+
+struct RecordingLog : repowerd::Log
+{
+    void vlog(repowerd::LogLevel level, char const* tag, char const* format, va_list ap) override
+    {
+        char output[256];
+        vsnprintf(output, sizeof(output), format, ap);
+        lines.push_back(std::string{repowerd::log_level_to_string(level)} + " " + tag + ": " + output);
+    }
+
+    std::vector<std::string> lines;
+};
+
+struct ALog : testing::Test
+{
+    RecordingLog log;
+    repowerd::LogLevels& levels = log.levels();
+
+    int evaluations = 0;
+    int counted_arg() { return ++evaluations; }
+};
+
+}
+
+TEST_F(ALog, enables_levels_up_to_info_by_default)
+{
+    EXPECT_TRUE(levels.is_enabled(repowerd::LogLevel::error, "tag"));
+    EXPECT_TRUE(levels.is_enabled(repowerd::LogLevel::warning, "tag"));
+    EXPECT_TRUE(levels.is_enabled(repowerd::LogLevel::info, "tag"));
+    EXPECT_FALSE(levels.is_enabled(repowerd::LogLevel::debug, "tag"));
+    EXPECT_FALSE(levels.is_enabled(repowerd::LogLevel::trace, "tag"));
+}
+
+TEST_F(ALog, tag_levels_override_the_default_level)
+{
+    levels.set_tag_level("verbose", repowerd::LogLevel::trace);
+    levels.set_tag_level("quiet", repowerd::LogLevel::error);
+
+    EXPECT_TRUE(levels.is_enabled(repowerd::LogLevel::trace, "verbose"));
+    EXPECT_FALSE(levels.is_enabled(repowerd::LogLevel::warning, "quiet"));
+    EXPECT_TRUE(levels.is_enabled(repowerd::LogLevel::info, "other"));
+    EXPECT_FALSE(levels.is_enabled(repowerd::LogLevel::debug, "other"));
+}
+
+TEST_F(ALog, resetting_a_tag_level_restores_the_default)
+{
+    levels.set_tag_level("tag", repowerd::LogLevel::trace);
+    levels.reset_tag_level("tag");
+
+    EXPECT_FALSE(levels.is_enabled(repowerd::LogLevel::debug, "tag"));
+    EXPECT_THAT(levels.tag_levels(), IsEmpty());
+}
+
+TEST_F(ALog, configures_levels_from_spec)
+{
+    levels.configure("warning, verbose=debug,quiet = error");
+
+    EXPECT_THAT(levels.default_level(), Eq(repowerd::LogLevel::warning));
+    EXPECT_TRUE(levels.is_enabled(repowerd::LogLevel::debug, "verbose"));
+    EXPECT_FALSE(levels.is_enabled(repowerd::LogLevel::warning, "quiet"));
+    EXPECT_FALSE(levels.is_enabled(repowerd::LogLevel::info, "other"));
+}
+
+TEST_F(ALog, throws_for_invalid_level_names)
+{
+    EXPECT_THROW({ levels.configure("loud"); }, std::invalid_argument);
+    EXPECT_THROW({ levels.configure("tag=loud"); }, std::invalid_argument);
+}
+
+TEST_F(ALog, applies_valid_items_of_spec_with_invalid_ones)
+{
+    EXPECT_THROW({ levels.configure("warning,tag=loud,verbose=debug"); }, std::invalid_argument);
+
+    EXPECT_THAT(levels.default_level(), Eq(repowerd::LogLevel::warning));
+    EXPECT_TRUE(levels.is_enabled(repowerd::LogLevel::debug, "verbose"));
+    EXPECT_FALSE(levels.is_enabled(repowerd::LogLevel::info, "tag"));
+}
+
+TEST_F(ALog, drops_messages_above_the_enabled_level)
+{
+    log.log("tag", "info %d", 1);
+    log.log(repowerd::LogLevel::debug, "tag", "debug %d", 2);
+    log.log(repowerd::LogLevel::error, "tag", "error %d", 3);
+
+    EXPECT_THAT(log.lines, ElementsAre("info tag: info 1", "error tag: error 3"));
+}
+
+TEST_F(ALog, macros_do_not_evaluate_arguments_of_disabled_levels)
+{
+    REPOWERD_LOG_DEBUG(log, "tag", "debug %d", counted_arg());
+    REPOWERD_LOG_INFO(log, "tag", "info %d", counted_arg());
+
+    EXPECT_THAT(evaluations, Eq(1));
+    EXPECT_THAT(log.lines, ElementsAre("info tag: info 1"));
+}